@@ -17,9 +17,15 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "controller_interface/realtime_buffer.hpp"
 #include "controller_interface/visibility_control.h"
 
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+
+#include "hardware_interface/interface_resources.hpp"
+#include "hardware_interface/joint_handle.hpp"
 #include "hardware_interface/robot_hardware.hpp"
 
 #include "rclcpp/rclcpp.hpp"
@@ -51,18 +57,227 @@ public:
     std::weak_ptr<hardware_interface::RobotHardware> robot_hardware,
     const std::string & controller_name);
 
+  /**
+   * \brief Initialize the controller in lightweight mode.
+   *
+   * Instead of owning a LifecycleNode, the controller creates its entities on the given node,
+   * typically a sub-node of the controller manager, and its lifecycle is driven by a slim state
+   * machine calling the same on_configure/on_activate/... callbacks.
+   *
+   * \param node node shared with the controller manager
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  virtual
+  return_type
+  init(
+    std::weak_ptr<hardware_interface::RobotHardware> robot_hardware,
+    const std::string & controller_name,
+    std::shared_ptr<rclcpp::Node> node);
+
   CONTROLLER_INTERFACE_PUBLIC
   virtual
   return_type
   update() = 0;
 
+  /**
+   * \brief returns the LifecycleNode of the controller, nullptr in lightweight mode
+   *
+   * Controllers supporting both modes use the node interfaces, clock and logger below instead.
+   */
   CONTROLLER_INTERFACE_PUBLIC
   std::shared_ptr<rclcpp_lifecycle::LifecycleNode>
   get_lifecycle_node();
 
+  /// \brief returns the node shared with the controller manager, nullptr unless in lightweight mode
+  CONTROLLER_INTERFACE_PUBLIC
+  std::shared_ptr<rclcpp::Node>
+  get_node();
+
+  /**
+   * \brief Interfaces of the node the controller creates its entities on, in either mode.
+   *
+   * \return interfaces of the LifecycleNode, or of the node shared with the controller manager in
+   * lightweight mode, nullptr before init()
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr
+  get_node_base_interface();
+
+  CONTROLLER_INTERFACE_PUBLIC
+  rclcpp::node_interfaces::NodeParametersInterface::SharedPtr
+  get_node_parameters_interface();
+
+  CONTROLLER_INTERFACE_PUBLIC
+  rclcpp::node_interfaces::NodeTopicsInterface::SharedPtr
+  get_node_topics_interface();
+
+  /// \brief returns the clock of the node of the controller, in either mode
+  CONTROLLER_INTERFACE_PUBLIC
+  rclcpp::Clock::SharedPtr
+  get_clock();
+
+  /// \brief returns the current time of the clock of the node of the controller, after init()
+  CONTROLLER_INTERFACE_PUBLIC
+  rclcpp::Time
+  now();
+
+  /// \brief returns the logger of the controller, in either mode
+  CONTROLLER_INTERFACE_PUBLIC
+  rclcpp::Logger
+  get_logger() const;
+
+  CONTROLLER_INTERFACE_PUBLIC
+  const std::string &
+  get_name() const;
+
+  /**
+   * \brief Lifecycle transitions and state of the controller, forwarded to the LifecycleNode or
+   * handled by the slim state machine in lightweight mode.
+   *
+   * \return state of the controller after the transition
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  const rclcpp_lifecycle::State &
+  configure();
+
+  CONTROLLER_INTERFACE_PUBLIC
+  const rclcpp_lifecycle::State &
+  activate();
+
+  CONTROLLER_INTERFACE_PUBLIC
+  const rclcpp_lifecycle::State &
+  deactivate();
+
+  CONTROLLER_INTERFACE_PUBLIC
+  const rclcpp_lifecycle::State &
+  cleanup();
+
+  CONTROLLER_INTERFACE_PUBLIC
+  const rclcpp_lifecycle::State &
+  get_current_state();
+
+  /**
+   * \brief Interfaces the controller commands, queried by the controller manager after
+   * configuring the controller. Two controllers claiming the same interface of the same
+   * resource cannot run at the same time.
+   *
+   * \return claimed resources grouped by interface, empty by default
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  virtual
+  std::vector<hardware_interface::InterfaceResources>
+  get_claimed_resources() const;
+
+  /**
+   * \brief Reference interfaces of this controller which other controllers can claim to write
+   * its references directly, within the same update cycle.
+   *
+   * No reference interface can be registered anymore once they are exported, until the
+   * controller is cleaned up, which also releases their storage. Handles exported before are
+   * invalid then, they are exported again once the controller is configured again.
+   * \return handles named "<controller_name>/<reference_name>", pointing into storage owned by
+   * this controller
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  std::vector<hardware_interface::JointHandle>
+  export_reference_interfaces();
+
+  /**
+   * \brief Reference interfaces exported by other controllers which this controller writes,
+   * queried by the controller manager after configuring the controller. The controller manager
+   * updates this controller before the controllers it claims reference interfaces from.
+   *
+   * \return claimed reference interfaces grouped by interface, with resources named
+   * "<controller_name>/<reference_name>", empty by default
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  virtual
+  std::vector<hardware_interface::InterfaceResources>
+  get_claimed_reference_interfaces() const;
+
+  /**
+   * \brief Hand over the handles to the claimed reference interfaces, called by the controller
+   * manager before the controller is started.
+   *
+   * \param handles handles in the order of get_claimed_reference_interfaces()
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  void
+  assign_reference_interfaces(std::vector<hardware_interface::JointHandle> && handles);
+
 protected:
+  /**
+   * \brief Register a reference interface to be exported to other controllers, typically
+   * called when configuring the controller.
+   *
+   * \return `OK`, or `ERROR` if the reference interfaces were already exported
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  hardware_interface::hardware_interface_ret_t
+  register_reference_interface(
+    const std::string & reference_name, const std::string & interface_name,
+    double default_value = 0.0);
+
+  /**
+   * \brief Get a handle to one of the reference interfaces registered by this controller.
+   *
+   * \param[in,out] handle handle with the reference and interface name, without the controller
+   * name prefix, the value pointer is set if found
+   * \return `OK`, or `ERROR` if no such reference interface is registered
+   */
+  CONTROLLER_INTERFACE_PUBLIC
+  hardware_interface::hardware_interface_ret_t
+  get_reference_interface_handle(hardware_interface::JointHandle & handle);
+
+  /**
+   * \brief Create a buffer passing e.g. references from a subscription callback to update().
+   *
+   * The buffer is cleared every time the controller is activated, so that update() never
+   * acts on a reference received before activation. update() is the only reader of the buffer
+   * and does not run while the controller is inactive, so the activation may run on any
+   * thread. The controller manager activates controllers from its update().
+   *
+   * \param prototype value used to preallocate the buffer
+   * \return buffer owned by the controller
+   */
+  template<typename T>
+  std::shared_ptr<RealtimeBuffer<T>>
+  create_realtime_buffer(const T & prototype = T())
+  {
+    auto buffer = std::make_shared<RealtimeBuffer<T>>(prototype);
+    realtime_buffers_.push_back(buffer);
+    return buffer;
+  }
+
   std::weak_ptr<hardware_interface::RobotHardware> robot_hardware_;
   std::shared_ptr<rclcpp_lifecycle::LifecycleNode> lifecycle_node_;
+  /// Reference interfaces of other controllers claimed by this controller
+  std::vector<hardware_interface::JointHandle> chained_reference_interfaces_;
+
+  /// Node shared with the controller manager in lightweight mode
+  std::shared_ptr<rclcpp::Node> node_;
+
+private:
+  using TransitionCallback = CallbackReturn (LifecycleNodeInterface::*)(
+    const rclcpp_lifecycle::State &);
+
+  /// Runs a transition of the slim state machine, realtime safe if the callback is
+  const rclcpp_lifecycle::State &
+  transition(std::uint8_t start_state_id, std::uint8_t goal_state_id, TransitionCallback callback);
+
+  void clear_realtime_buffers();
+
+  /// Releases the registered reference interfaces on cleanup, so that configure registers them
+  void clear_reference_interfaces();
+
+  std::string name_;
+  /// Primary states of the slim state machine, indexed by id, created once by init()
+  std::vector<rclcpp_lifecycle::State> slim_states_;
+  const rclcpp_lifecycle::State * slim_state_ = nullptr;
+
+  std::vector<std::shared_ptr<RealtimeBufferBase>> realtime_buffers_;
+  control_msgs::msg::DynamicJointState reference_interfaces_;
+  bool reference_interfaces_exported_ = false;
 };
 
 using ControllerInterfaceSharedPtr = std::shared_ptr<ControllerInterface>;
@@ -0,0 +1,149 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_INTERFACE__REALTIME_BUFFER_HPP_
+#define CONTROLLER_INTERFACE__REALTIME_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace controller_interface
+{
+
+/**
+ * \brief Type erased interface of RealtimeBuffer, lets a controller clear all its buffers.
+ */
+class RealtimeBufferBase
+{
+public:
+  virtual ~RealtimeBufferBase() = default;
+
+  /**
+   * \brief Forget the latest value, read() returns nullptr until the next write.
+   * \note not thread-safe with respect to read(), must be called from the reading thread or
+   * while no thread reads, e.g. while the controller reading it is not active. Writing
+   * concurrently is fine.
+   */
+  virtual void clear() = 0;
+};
+
+/**
+ * \brief Lock-free buffer passing the latest value from a single writer to a single reader.
+ *
+ * The buffer holds three slots: one owned by the writer, one owned by the reader and one
+ * exchanged between them with a single atomic operation, so neither side ever blocks or waits
+ * for the other. Values are copied into preallocated slots, writing a value with the same
+ * dynamic size as the previous ones does not allocate.
+ *
+ * Typically a subscription callback writes the reference and update() reads it.
+ */
+template<typename T>
+class RealtimeBuffer : public RealtimeBufferBase
+{
+public:
+  /**
+   * \param prototype value copied into all slots to preallocate them, read() still returns
+   * nullptr until the first write
+   */
+  explicit RealtimeBuffer(const T & prototype = T())
+  {
+    slots_.fill(prototype);
+  }
+
+  RealtimeBuffer(const RealtimeBuffer &) = delete;
+  RealtimeBuffer & operator=(const RealtimeBuffer &) = delete;
+
+  /// \brief Copy a value into the buffer, called from the writing thread.
+  void write(const T & value)
+  {
+    slots_[write_index_] = value;
+    commit();
+  }
+
+  /// \brief Move a value into the buffer, called from the writing thread.
+  void write(T && value)
+  {
+    slots_[write_index_] = std::move(value);
+    commit();
+  }
+
+  /**
+   * \brief Slot to be filled in place by the writer before calling commit().
+   * \note the slot holds an older value, all fields have to be written
+   */
+  T & writable()
+  {
+    return slots_[write_index_];
+  }
+
+  /// \brief Make the value filled in writable() available to the reader.
+  void commit()
+  {
+    const auto previous = shared_.exchange(write_index_ | kNewData, std::memory_order_acq_rel);
+    write_index_ = previous & kIndexMask;
+  }
+
+  /// \brief true if a value was written since the last read() or clear()
+  bool has_new_data() const
+  {
+    return (shared_.load(std::memory_order_acquire) & kNewData) != 0;
+  }
+
+  /**
+   * \brief Latest value written to the buffer, called from the reading thread.
+   *
+   * Costs a single atomic load if nothing was written since the last call.
+   * \return pointer valid until the next call to read() or clear(), nullptr if nothing was
+   * written since construction or the last clear()
+   */
+  const T * read()
+  {
+    if (has_new_data()) {
+      swap_read_slot();
+      has_value_ = true;
+    }
+    return has_value_ ? &slots_[read_index_] : nullptr;
+  }
+
+  void clear() override
+  {
+    if (has_new_data()) {
+      swap_read_slot();
+    }
+    has_value_ = false;
+  }
+
+private:
+  static constexpr std::uint8_t kIndexMask = 0x3;
+  static constexpr std::uint8_t kNewData = 0x4;
+
+  void swap_read_slot()
+  {
+    const auto previous = shared_.exchange(read_index_, std::memory_order_acq_rel);
+    read_index_ = previous & kIndexMask;
+  }
+
+  std::array<T, 3> slots_;
+  /// index of the exchanged slot and whether it holds data the reader did not see yet
+  std::atomic<std::uint8_t> shared_{1};
+  std::uint8_t write_index_ = 0;  // only accessed by the writer
+  std::uint8_t read_index_ = 2;   // only accessed by the reader
+  bool has_value_ = false;        // only accessed by the reader
+};
+
+}  // namespace controller_interface
+
+#endif  // CONTROLLER_INTERFACE__REALTIME_BUFFER_HPP_
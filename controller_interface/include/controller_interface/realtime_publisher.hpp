@@ -0,0 +1,110 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_INTERFACE__REALTIME_PUBLISHER_HPP_
+#define CONTROLLER_INTERFACE__REALTIME_PUBLISHER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "controller_interface/realtime_buffer.hpp"
+
+#include "rclcpp/publisher.hpp"
+
+namespace controller_interface
+{
+
+/**
+ * \brief Publishes messages handed over from a realtime thread.
+ *
+ * publish() only copies the message into a RealtimeBuffer, a non-realtime thread owned by
+ * this object publishes the latest message. Messages published faster than the thread polls
+ * are dropped, only the most recent one is sent.
+ */
+template<typename MessageT>
+class RealtimePublisher
+{
+public:
+  /**
+   * \param publisher publisher used by the non-realtime thread
+   * \param prototype message used to preallocate the buffer, e.g. with arrays of the right size
+   * \param poll_period how often the non-realtime thread checks for a new message
+   */
+  explicit RealtimePublisher(
+    std::shared_ptr<rclcpp::Publisher<MessageT>> publisher,
+    const MessageT & prototype = MessageT(),
+    std::chrono::nanoseconds poll_period = std::chrono::milliseconds(1))
+  : publisher_(publisher),
+    buffer_(prototype),
+    poll_period_(poll_period),
+    publishing_thread_(&RealtimePublisher::publishing_loop, this)
+  {
+  }
+
+  ~RealtimePublisher()
+  {
+    keep_running_ = false;
+    if (publishing_thread_.joinable()) {
+      publishing_thread_.join();
+    }
+  }
+
+  RealtimePublisher(const RealtimePublisher &) = delete;
+  RealtimePublisher & operator=(const RealtimePublisher &) = delete;
+
+  /// \brief Hand a message over to the publishing thread, realtime safe.
+  void publish(const MessageT & message)
+  {
+    buffer_.write(message);
+  }
+
+  /**
+   * \brief Message to be filled in place before calling unlock_and_publish().
+   * \note the message holds older content, all fields have to be written
+   */
+  MessageT & get_message()
+  {
+    return buffer_.writable();
+  }
+
+  /// \brief Hand the message filled in get_message() over to the publishing thread.
+  void unlock_and_publish()
+  {
+    buffer_.commit();
+  }
+
+private:
+  void publishing_loop()
+  {
+    while (keep_running_) {
+      if (buffer_.has_new_data()) {
+        publisher_->publish(*buffer_.read());
+      } else {
+        std::this_thread::sleep_for(poll_period_);
+      }
+    }
+  }
+
+  std::shared_ptr<rclcpp::Publisher<MessageT>> publisher_;
+  RealtimeBuffer<MessageT> buffer_;
+  std::chrono::nanoseconds poll_period_;
+  std::atomic<bool> keep_running_{true};
+  std::thread publishing_thread_;
+};
+
+}  // namespace controller_interface
+
+#endif  // CONTROLLER_INTERFACE__REALTIME_PUBLISHER_HPP_
@@ -14,8 +14,13 @@
 
 #include "controller_interface/controller_interface.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "lifecycle_msgs/msg/state.hpp"
 
 namespace controller_interface
 {
@@ -26,16 +31,26 @@ ControllerInterface::init(
   const std::string & controller_name)
 {
   robot_hardware_ = robot_hardware;
+  name_ = controller_name;
   lifecycle_node_ = std::make_shared<rclcpp_lifecycle::LifecycleNode>(controller_name);
 
   lifecycle_node_->register_on_configure(
     std::bind(&ControllerInterface::on_configure, this, std::placeholders::_1));
 
   lifecycle_node_->register_on_cleanup(
-    std::bind(&ControllerInterface::on_cleanup, this, std::placeholders::_1));
+    [this](const rclcpp_lifecycle::State & previous_state) {
+      const auto ret = on_cleanup(previous_state);
+      if (ret == CallbackReturn::SUCCESS) {
+        clear_reference_interfaces();
+      }
+      return ret;
+    });
 
   lifecycle_node_->register_on_activate(
-    std::bind(&ControllerInterface::on_activate, this, std::placeholders::_1));
+    [this](const rclcpp_lifecycle::State & previous_state) {
+      clear_realtime_buffers();
+      return on_activate(previous_state);
+    });
 
   lifecycle_node_->register_on_deactivate(
     std::bind(&ControllerInterface::on_deactivate, this, std::placeholders::_1));
@@ -49,10 +64,300 @@ ControllerInterface::init(
   return return_type::SUCCESS;
 }
 
+return_type
+ControllerInterface::init(
+  std::weak_ptr<hardware_interface::RobotHardware> robot_hardware,
+  const std::string & controller_name,
+  std::shared_ptr<rclcpp::Node> node)
+{
+  robot_hardware_ = robot_hardware;
+  name_ = controller_name;
+  node_ = node;
+
+  using lifecycle_msgs::msg::State;
+  slim_states_.clear();
+  slim_states_.emplace_back(State::PRIMARY_STATE_UNKNOWN, "unknown");
+  slim_states_.emplace_back(State::PRIMARY_STATE_UNCONFIGURED, "unconfigured");
+  slim_states_.emplace_back(State::PRIMARY_STATE_INACTIVE, "inactive");
+  slim_states_.emplace_back(State::PRIMARY_STATE_ACTIVE, "active");
+  slim_states_.emplace_back(State::PRIMARY_STATE_FINALIZED, "finalized");
+  slim_state_ = &slim_states_[State::PRIMARY_STATE_UNCONFIGURED];
+
+  return return_type::SUCCESS;
+}
+
 std::shared_ptr<rclcpp_lifecycle::LifecycleNode>
 ControllerInterface::get_lifecycle_node()
 {
   return lifecycle_node_;
 }
 
+std::shared_ptr<rclcpp::Node>
+ControllerInterface::get_node()
+{
+  return node_;
+}
+
+rclcpp::node_interfaces::NodeBaseInterface::SharedPtr
+ControllerInterface::get_node_base_interface()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->get_node_base_interface();
+  }
+  return node_ ? node_->get_node_base_interface() : nullptr;
+}
+
+rclcpp::node_interfaces::NodeParametersInterface::SharedPtr
+ControllerInterface::get_node_parameters_interface()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->get_node_parameters_interface();
+  }
+  return node_ ? node_->get_node_parameters_interface() : nullptr;
+}
+
+rclcpp::node_interfaces::NodeTopicsInterface::SharedPtr
+ControllerInterface::get_node_topics_interface()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->get_node_topics_interface();
+  }
+  return node_ ? node_->get_node_topics_interface() : nullptr;
+}
+
+rclcpp::Clock::SharedPtr
+ControllerInterface::get_clock()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->get_clock();
+  }
+  return node_ ? node_->get_clock() : nullptr;
+}
+
+rclcpp::Time
+ControllerInterface::now()
+{
+  return get_clock()->now();
+}
+
+const std::string &
+ControllerInterface::get_name() const
+{
+  return name_;
+}
+
+const rclcpp_lifecycle::State &
+ControllerInterface::configure()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->configure();
+  }
+  return transition(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED,
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE, &LifecycleNodeInterface::on_configure);
+}
+
+const rclcpp_lifecycle::State &
+ControllerInterface::activate()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->activate();
+  }
+  if (slim_state_->id() == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE) {
+    clear_realtime_buffers();
+  }
+  return transition(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE, &LifecycleNodeInterface::on_activate);
+}
+
+const rclcpp_lifecycle::State &
+ControllerInterface::deactivate()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->deactivate();
+  }
+  return transition(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE, &LifecycleNodeInterface::on_deactivate);
+}
+
+const rclcpp_lifecycle::State &
+ControllerInterface::cleanup()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->cleanup();
+  }
+  const auto previous_state_id = slim_state_->id();
+  const auto & state = transition(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED, &LifecycleNodeInterface::on_cleanup);
+  if (previous_state_id == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE &&
+    state.id() == lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED)
+  {
+    clear_reference_interfaces();
+  }
+  return state;
+}
+
+const rclcpp_lifecycle::State &
+ControllerInterface::get_current_state()
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->get_current_state();
+  }
+  return *slim_state_;
+}
+
+const rclcpp_lifecycle::State &
+ControllerInterface::transition(
+  std::uint8_t start_state_id, std::uint8_t goal_state_id, TransitionCallback callback)
+{
+  if (slim_state_->id() != start_state_id) {
+    RCLCPP_ERROR(
+      get_logger(), "Unable to start transition from current state %s",
+      slim_state_->label().c_str());
+    return *slim_state_;
+  }
+
+  // same outcomes as the lifecycle node, an error is handled by on_error
+  switch ((this->*callback)(*slim_state_)) {
+    case CallbackReturn::SUCCESS:
+      slim_state_ = &slim_states_[goal_state_id];
+      break;
+    case CallbackReturn::FAILURE:
+      break;
+    default:
+      slim_state_ = &slim_states_[on_error(*slim_state_) == CallbackReturn::SUCCESS ?
+          lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED :
+          lifecycle_msgs::msg::State::PRIMARY_STATE_FINALIZED];
+      break;
+  }
+  return *slim_state_;
+}
+
+rclcpp::Logger
+ControllerInterface::get_logger() const
+{
+  if (lifecycle_node_) {
+    return lifecycle_node_->get_logger();
+  }
+  if (node_) {
+    return node_->get_logger().get_child(name_);
+  }
+  return rclcpp::get_logger(name_);
+}
+
+void
+ControllerInterface::clear_realtime_buffers()
+{
+  for (auto & buffer : realtime_buffers_) {
+    buffer->clear();
+  }
+}
+
+void
+ControllerInterface::clear_reference_interfaces()
+{
+  reference_interfaces_ = control_msgs::msg::DynamicJointState();
+  reference_interfaces_exported_ = false;
+}
+
+std::vector<hardware_interface::InterfaceResources>
+ControllerInterface::get_claimed_resources() const
+{
+  return {};
+}
+
+std::vector<hardware_interface::JointHandle>
+ControllerInterface::export_reference_interfaces()
+{
+  reference_interfaces_exported_ = true;
+
+  const std::string prefix = name_ + "/";
+  std::vector<hardware_interface::JointHandle> handles;
+  for (size_t i = 0; i < reference_interfaces_.joint_names.size(); ++i) {
+    auto & interface_values = reference_interfaces_.interface_values[i];
+    for (size_t j = 0; j < interface_values.interface_names.size(); ++j) {
+      handles.emplace_back(
+        prefix + reference_interfaces_.joint_names[i], interface_values.interface_names[j],
+        &interface_values.values[j]);
+    }
+  }
+  return handles;
+}
+
+std::vector<hardware_interface::InterfaceResources>
+ControllerInterface::get_claimed_reference_interfaces() const
+{
+  return {};
+}
+
+void
+ControllerInterface::assign_reference_interfaces(
+  std::vector<hardware_interface::JointHandle> && handles)
+{
+  chained_reference_interfaces_ = std::move(handles);
+}
+
+hardware_interface::hardware_interface_ret_t
+ControllerInterface::register_reference_interface(
+  const std::string & reference_name, const std::string & interface_name,
+  double default_value)
+{
+  // exported handles point into the storage, which must not be reallocated anymore
+  if (reference_interfaces_exported_) {
+    RCLCPP_ERROR(
+      get_logger(),
+      "cannot register reference interface %s/%s, reference interfaces were already exported",
+      reference_name.c_str(), interface_name.c_str());
+    return hardware_interface::return_type::ERROR;
+  }
+
+  auto & names = reference_interfaces_.joint_names;
+  const auto it = std::find(names.begin(), names.end(), reference_name);
+  const auto index = static_cast<size_t>(std::distance(names.begin(), it));
+  if (it == names.end()) {
+    names.push_back(reference_name);
+    reference_interfaces_.interface_values.emplace_back();
+  }
+
+  auto & interface_values = reference_interfaces_.interface_values[index];
+  const auto & interface_names = interface_values.interface_names;
+  if (std::find(interface_names.begin(), interface_names.end(), interface_name) !=
+    interface_names.end())
+  {
+    RCLCPP_ERROR(
+      get_logger(), "reference interface %s/%s is already registered",
+      reference_name.c_str(), interface_name.c_str());
+    return hardware_interface::return_type::ERROR;
+  }
+  interface_values.interface_names.push_back(interface_name);
+  interface_values.values.push_back(default_value);
+  return hardware_interface::return_type::OK;
+}
+
+hardware_interface::hardware_interface_ret_t
+ControllerInterface::get_reference_interface_handle(hardware_interface::JointHandle & handle)
+{
+  const auto & names = reference_interfaces_.joint_names;
+  const auto it = std::find(names.begin(), names.end(), handle.get_name());
+  if (it != names.end()) {
+    auto & interface_values =
+      reference_interfaces_.interface_values[std::distance(names.begin(), it)];
+    const auto & interface_names = interface_values.interface_names;
+    const auto interface_it =
+      std::find(interface_names.begin(), interface_names.end(), handle.get_interface_name());
+    if (interface_it != interface_names.end()) {
+      handle = handle.with_value_ptr(
+        &interface_values.values[std::distance(interface_names.begin(), interface_it)]);
+      return hardware_interface::return_type::OK;
+    }
+  }
+  RCLCPP_ERROR(
+    get_logger(), "reference interface %s/%s not found",
+    handle.get_name().c_str(), handle.get_interface_name().c_str());
+  return hardware_interface::return_type::ERROR;
+}
+
 }  // namespace controller_interface
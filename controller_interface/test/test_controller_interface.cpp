@@ -0,0 +1,124 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "controller_interface/controller_interface.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+constexpr auto INACTIVE = lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE;
+constexpr auto ACTIVE = lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE;
+
+/// Reads the latest reference of its buffer in update(), like a controller subscribing to it
+class BufferedController : public controller_interface::ControllerInterface
+{
+public:
+  controller_interface::return_type update() override
+  {
+    reference = buffer->read();
+    return controller_interface::return_type::SUCCESS;
+  }
+
+  std::shared_ptr<controller_interface::RealtimeBuffer<double>> buffer =
+    create_realtime_buffer<double>();
+  const double * reference = nullptr;
+};
+
+void expect_buffers_cleared_on_activation(BufferedController & controller)
+{
+  ASSERT_EQ(INACTIVE, controller.configure().id());
+  // received while the controller was inactive
+  controller.buffer->write(1.0);
+  ASSERT_EQ(ACTIVE, controller.activate().id());
+  controller.update();
+  EXPECT_EQ(nullptr, controller.reference);
+
+  controller.buffer->write(2.0);
+  controller.update();
+  ASSERT_NE(nullptr, controller.reference);
+  EXPECT_EQ(2.0, *controller.reference);
+
+  // the value read before the deactivation is dropped as well
+  ASSERT_EQ(INACTIVE, controller.deactivate().id());
+  ASSERT_EQ(ACTIVE, controller.activate().id());
+  controller.update();
+  EXPECT_EQ(nullptr, controller.reference);
+}
+}  // namespace
+
+class TestControllerInterface : public ::testing::Test
+{
+public:
+  static void SetUpTestCase()
+  {
+    rclcpp::init(0, nullptr);
+  }
+
+  static void TearDownTestCase()
+  {
+    rclcpp::shutdown();
+  }
+};
+
+TEST_F(TestControllerInterface, realtime_buffers_are_cleared_on_activation)
+{
+  BufferedController controller;
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    controller.init(std::weak_ptr<hardware_interface::RobotHardware>(), "buffered_controller"));
+  expect_buffers_cleared_on_activation(controller);
+}
+
+TEST_F(TestControllerInterface, realtime_buffers_are_cleared_on_slim_activation)
+{
+  BufferedController controller;
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    controller.init(
+      std::weak_ptr<hardware_interface::RobotHardware>(), "buffered_controller",
+      std::make_shared<rclcpp::Node>("controller_manager")));
+  expect_buffers_cleared_on_activation(controller);
+}
+
+TEST_F(TestControllerInterface, node_is_accessible_in_both_modes)
+{
+  BufferedController controller;
+  controller.init(std::weak_ptr<hardware_interface::RobotHardware>(), "buffered_controller");
+  ASSERT_NE(nullptr, controller.get_node_base_interface());
+  EXPECT_STREQ("buffered_controller", controller.get_node_base_interface()->get_name());
+  EXPECT_NE(nullptr, controller.get_node_parameters_interface());
+  EXPECT_NE(nullptr, controller.get_node_topics_interface());
+  EXPECT_EQ(controller.get_lifecycle_node()->get_clock(), controller.get_clock());
+  EXPECT_NE(0, controller.now().nanoseconds());
+
+  BufferedController lightweight_controller;
+  const auto node = std::make_shared<rclcpp::Node>("controller_manager");
+  lightweight_controller.init(
+    std::weak_ptr<hardware_interface::RobotHardware>(), "buffered_controller", node);
+  ASSERT_EQ(nullptr, lightweight_controller.get_lifecycle_node());
+  EXPECT_EQ(node->get_node_base_interface(), lightweight_controller.get_node_base_interface());
+  EXPECT_EQ(
+    node->get_node_parameters_interface(),
+    lightweight_controller.get_node_parameters_interface());
+  EXPECT_EQ(node->get_node_topics_interface(), lightweight_controller.get_node_topics_interface());
+  EXPECT_EQ(node->get_clock(), lightweight_controller.get_clock());
+  EXPECT_NE(0, lightweight_controller.now().nanoseconds());
+  EXPECT_STREQ(
+    "controller_manager.buffered_controller", lightweight_controller.get_logger().get_name());
+}
@@ -0,0 +1,89 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "controller_interface/realtime_buffer.hpp"
+
+TEST(TestRealtimeBuffer, read_returns_latest_value)
+{
+  controller_interface::RealtimeBuffer<int> buffer;
+  EXPECT_EQ(nullptr, buffer.read());
+  EXPECT_FALSE(buffer.has_new_data());
+
+  buffer.write(1);
+  buffer.write(2);
+  EXPECT_TRUE(buffer.has_new_data());
+  ASSERT_NE(nullptr, buffer.read());
+  EXPECT_EQ(2, *buffer.read());
+  EXPECT_FALSE(buffer.has_new_data());
+
+  buffer.writable() = 3;
+  buffer.commit();
+  EXPECT_EQ(3, *buffer.read());
+}
+
+TEST(TestRealtimeBuffer, clear_drops_pending_and_latest_value)
+{
+  controller_interface::RealtimeBuffer<int> buffer;
+  buffer.write(1);
+  EXPECT_EQ(1, *buffer.read());
+  buffer.clear();
+  EXPECT_EQ(nullptr, buffer.read());
+
+  buffer.write(2);
+  buffer.clear();
+  EXPECT_EQ(nullptr, buffer.read());
+
+  buffer.write(3);
+  EXPECT_EQ(3, *buffer.read());
+}
+
+TEST(TestRealtimeBuffer, reader_sees_consistent_values)
+{
+  // each value holds its sequence number in all elements, a torn read would mix them
+  controller_interface::RealtimeBuffer<std::vector<int>> buffer(std::vector<int>(64, 0));
+  constexpr int kIterations = 100000;
+  std::atomic<bool> done{false};
+
+  std::thread writer([&]() {
+      std::vector<int> value(64);
+      for (int i = 1; i <= kIterations; ++i) {
+        std::fill(value.begin(), value.end(), i);
+        buffer.write(value);
+      }
+      done = true;
+    });
+
+  int last_seen = 0;
+  while (!done || buffer.has_new_data()) {
+    const auto value = buffer.read();
+    if (value == nullptr) {
+      continue;
+    }
+    const int sequence = value->front();
+    for (const auto element : *value) {
+      ASSERT_EQ(sequence, element);
+    }
+    ASSERT_GE(sequence, last_seen);
+    last_seen = sequence;
+  }
+  writer.join();
+  EXPECT_EQ(kIterations, *buffer.read()->begin());
+}
@@ -0,0 +1,92 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "controller_interface/realtime_publisher.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+using lifecycle_msgs::msg::State;
+
+class TestRealtimePublisher : public ::testing::Test
+{
+public:
+  static void SetUpTestCase()
+  {
+    rclcpp::init(0, nullptr);
+  }
+
+  static void TearDownTestCase()
+  {
+    rclcpp::shutdown();
+  }
+
+protected:
+  void SetUp() override
+  {
+    node_ = std::make_shared<rclcpp::Node>("test_realtime_publisher");
+    // the last message is kept for the subscription, however late it is matched
+    subscription_ = node_->create_subscription<State>(
+      "state", rclcpp::QoS(1).transient_local(),
+      [this](const State::SharedPtr message) {received_.push_back(*message);});
+  }
+
+  /// Spins the node until the condition holds, false after a timeout
+  bool spin_until(const std::function<bool()> & condition)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      rclcpp::spin_some(node_);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  std::shared_ptr<rclcpp::Node> node_;
+  rclcpp::Subscription<State>::SharedPtr subscription_;
+  std::vector<State> received_;
+};
+
+TEST_F(TestRealtimePublisher, publishes_handed_over_messages)
+{
+  controller_interface::RealtimePublisher<State> publisher(
+    node_->create_publisher<State>("state", rclcpp::QoS(1).transient_local()));
+
+  State message;
+  message.id = State::PRIMARY_STATE_INACTIVE;
+  message.label = "inactive";
+  publisher.publish(message);
+  ASSERT_TRUE(spin_until([this]() {return !received_.empty();}));
+  EXPECT_EQ(State::PRIMARY_STATE_INACTIVE, received_.back().id);
+  EXPECT_EQ("inactive", received_.back().label);
+
+  // filled in place
+  auto & in_place_message = publisher.get_message();
+  in_place_message.id = State::PRIMARY_STATE_ACTIVE;
+  in_place_message.label = "active";
+  publisher.unlock_and_publish();
+  ASSERT_TRUE(
+    spin_until([this]() {return received_.back().id == State::PRIMARY_STATE_ACTIVE;}));
+  EXPECT_EQ("active", received_.back().label);
+}
@@ -0,0 +1,126 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_MANAGER__ALLOCATION_TRACKER_HPP_
+#define CONTROLLER_MANAGER__ALLOCATION_TRACKER_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "controller_manager/visibility_control.h"
+
+namespace controller_manager
+{
+
+/**
+ * Tracking of heap allocations made by a thread, used to find code allocating in the realtime
+ * loop.
+ *
+ * Allocations are only seen if the allocation hooks are loaded into the process, e.g. with
+ * LD_PRELOAD=libcontroller_manager_allocation_hooks.so (Linux with glibc only). The hooks
+ * forward every malloc, calloc, realloc, memalign, aligned_alloc and posix_memalign to
+ * on_allocation(), which does nothing unless the calling thread enabled tracking.
+ *
+ * Plugin authors can assert that their update() does not allocate:
+ * @code
+ * ASSERT_TRUE(controller_manager::allocation_tracker::hooks_installed());
+ * controller_manager::allocation_tracker::ScopedTracking tracking("my_controller");
+ * controller->update();
+ * EXPECT_EQ(0u, tracking.get_allocations());
+ * @endcode
+ */
+namespace allocation_tracker
+{
+
+enum class Mode : std::uint8_t
+{
+  /// Allocations are not tracked
+  OFF = 0,
+  /// Allocations are counted
+  COUNT = 1,
+  /// The first allocation aborts the process after printing the current context
+  TRAP = 2,
+};
+
+/**
+ * @brief parse_mode Parses "off", "count" or "trap".
+ * @throws std::invalid_argument on any other value
+ */
+CONTROLLER_MANAGER_PUBLIC
+Mode parse_mode(const std::string & mode);
+
+/// Returns true if the allocation hooks are loaded, allocations cannot be seen otherwise
+CONTROLLER_MANAGER_PUBLIC
+bool hooks_installed();
+
+/// Called by the allocation hooks when they are loaded
+CONTROLLER_MANAGER_PUBLIC
+void set_hooks_installed();
+
+/**
+ * @brief set_mode Starts or stops tracking the allocations of the calling thread.
+ * Allocation free.
+ */
+CONTROLLER_MANAGER_PUBLIC
+void set_mode(Mode mode);
+
+CONTROLLER_MANAGER_PUBLIC
+Mode get_mode();
+
+/**
+ * @brief set_context Names the code running on the calling thread, printed when trapping.
+ * Allocation free.
+ * @param context null terminated name, which must outlive its use as the context
+ */
+CONTROLLER_MANAGER_PUBLIC
+void set_context(const char * context);
+
+/// Number of allocations tracked on the calling thread since it started, allocation free
+CONTROLLER_MANAGER_PUBLIC
+std::uint64_t get_allocations();
+
+/// Called by the allocation hooks for every allocation
+CONTROLLER_MANAGER_PUBLIC
+void on_allocation() noexcept;
+
+/**
+ * @brief The ScopedTracking class tracks the allocations of the calling thread during its
+ * lifetime, restoring the previous mode and context when destroyed.
+ */
+class ScopedTracking
+{
+public:
+  CONTROLLER_MANAGER_PUBLIC
+  explicit ScopedTracking(const char * context, Mode mode = Mode::COUNT);
+
+  CONTROLLER_MANAGER_PUBLIC
+  ~ScopedTracking();
+
+  ScopedTracking(const ScopedTracking &) = delete;
+  ScopedTracking & operator=(const ScopedTracking &) = delete;
+
+  /// Number of allocations since the construction
+  CONTROLLER_MANAGER_PUBLIC
+  std::uint64_t get_allocations() const;
+
+private:
+  Mode previous_mode_;
+  const char * previous_context_;
+  std::uint64_t allocations_at_start_;
+};
+
+}  // namespace allocation_tracker
+}  // namespace controller_manager
+
+#endif  // CONTROLLER_MANAGER__ALLOCATION_TRACKER_HPP_
@@ -15,22 +15,37 @@
 #ifndef CONTROLLER_MANAGER__CONTROLLER_MANAGER_HPP_
 #define CONTROLLER_MANAGER__CONTROLLER_MANAGER_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
 
+#include "controller_manager/allocation_tracker.hpp"
 #include "controller_manager/controller_spec.hpp"
+#include "controller_manager/dynamic_joint_state_publisher.hpp"
+#include "controller_manager/hardware_state_snapshot.hpp"
 #include "controller_manager/visibility_control.h"
+#include "controller_manager/watchdog.hpp"
+#include "controller_manager_msgs/msg/controller_event.hpp"
 #include "controller_manager_msgs/srv/list_controllers.hpp"
 #include "controller_manager_msgs/srv/list_controller_types.hpp"
+#include "controller_manager_msgs/srv/list_hardware_interfaces.hpp"
 #include "controller_manager_msgs/srv/load_controller.hpp"
+#include "controller_manager_msgs/srv/load_controllers.hpp"
 #include "controller_manager_msgs/srv/reload_controller_libraries.hpp"
 #include "controller_manager_msgs/srv/switch_controller.hpp"
 #include "controller_manager_msgs/srv/unload_controller.hpp"
+#include "controller_manager_msgs/srv/write_trace.hpp"
 
+#include "hardware_interface/recorder.hpp"
 #include "hardware_interface/robot_hardware.hpp"
 
 #include "pluginlib/class_loader.hpp"
@@ -47,6 +62,11 @@ public:
   static constexpr bool WAIT_FOR_ALL_RESOURCES = false;
   static constexpr double INFINITE_TIMEOUT = 0.0;
 
+  /**
+   * @param executor executor spinning the controller manager node, also used for the controller
+   * nodes unless the "controller_executor_threads" parameter is set. Spin it with a
+   * MultiThreadedExecutor to keep the list services responsive while others are busy.
+   */
   CONTROLLER_MANAGER_PUBLIC
   ControllerManager(
     std::shared_ptr<hardware_interface::RobotHardware> hw,
@@ -55,7 +75,7 @@ public:
 
   CONTROLLER_MANAGER_PUBLIC
   virtual
-  ~ControllerManager() = default;
+  ~ControllerManager();
 
   CONTROLLER_MANAGER_PUBLIC
   controller_interface::ControllerInterfaceSharedPtr
@@ -71,6 +91,22 @@ public:
   load_controller(
     const std::string & controller_name);
 
+  /**
+   * @brief load_controllers loads several controllers at once, the types must be defined in the
+   * parameter server.
+   *
+   * The controllers are initialized and configured concurrently on a pool of loader threads and
+   * handed over to the realtime thread with a single switch of the controllers list.
+   * @param controller_names names of the controllers to load
+   * @param max_threads maximum number of loader threads, 0 uses one per hardware thread
+   * @return one entry per requested controller, nullptr if that controller could not be loaded
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  std::vector<controller_interface::ControllerInterfaceSharedPtr>
+  load_controllers(
+    const std::vector<std::string> & controller_names,
+    size_t max_threads = 0);
+
   CONTROLLER_MANAGER_PUBLIC
   controller_interface::return_type unload_controller(
     const std::string & controller_name);
@@ -107,10 +143,82 @@ public:
     bool start_asap = WAIT_FOR_ALL_RESOURCES,
     const rclcpp::Duration & timeout = rclcpp::Duration(INFINITE_TIMEOUT));
 
+  /**
+   * @brief read Reads the hardware, monitored by the watchdog if it is enabled.
+   * To be called by the realtime loop before update().
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  controller_interface::return_type
+  read();
+
   CONTROLLER_MANAGER_PUBLIC
   controller_interface::return_type
   update();
 
+  /**
+   * @brief write Writes the hardware, monitored by the watchdog if it is enabled.
+   * Commands not written by any controller within their timeout are replaced by the fallback
+   * of the hardware first, see RobotHardware::set_command_timeout().
+   * To be called by the realtime loop after update().
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  controller_interface::return_type
+  write();
+
+  /**
+   * @brief get_watchdog Monitor of the deadlines of read(), update(), the controllers and
+   * write(), created if any of the "watchdog.*_deadline" parameters is set
+   * @return nullptr if the watchdog is disabled
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  const Watchdog * get_watchdog() const;
+
+  /**
+   * @brief enable_stepping Switches to deterministic stepping on simulated time, e.g. to run
+   * faster than real time in tests.
+   *
+   * The loop is then driven by step() instead of a realtime thread calling update(). Switches
+   * are performed synchronously by switch_controller(), between two cycles of step() if it is
+   * called from another thread, e.g. by the switch_controller service. The clocks of this node
+   * and of the controllers are overridden with the simulated time, so now() returns it.
+   * Cannot be disabled again.
+   * @param period simulated time advanced by every step()
+   * @param start_time simulated time before the first step
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  void enable_stepping(
+    const rclcpp::Duration & period,
+    const rclcpp::Time & start_time = rclcpp::Time(0, 0, RCL_ROS_TIME));
+
+  CONTROLLER_MANAGER_PUBLIC
+  bool is_stepping() const;
+
+  /**
+   * @brief step Advances the simulated time by one period and runs one cycle: read() of the
+   * hardware, update() and write() of the hardware.
+   * @param steps number of cycles to run
+   * @return ERROR as soon as a cycle fails, without running the remaining ones
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  controller_interface::return_type
+  step(std::size_t steps = 1);
+
+  /**
+   * @brief preload_controller_libraries Loads the libraries of all registered controller types
+   * and locks their pages in memory, so loading and switching controllers later on does not
+   * need to read from disk.
+   *
+   * Called on construction and after reloading the controller libraries if the
+   * "preload_controller_libraries" parameter is true.
+   * Symbols of the libraries are not bound by this call. pluginlib opens them with lazy binding,
+   * which a loaded library keeps even if opened again with RTLD_NOW, so they are only bound
+   * eagerly if the process runs with LD_BIND_NOW set.
+   * @return ERROR if any library could not be loaded, failing to lock pages only logs a warning
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  controller_interface::return_type
+  preload_controller_libraries();
+
 protected:
   CONTROLLER_MANAGER_PUBLIC
   controller_interface::ControllerInterfaceSharedPtr
@@ -122,6 +230,17 @@ protected:
   CONTROLLER_MANAGER_PUBLIC
   void stop_controllers();
 
+  /**
+   * @brief restart_stopped_controllers Activates the controllers stopped by stop_controllers()
+   * again, after the hardware failed to switch command modes.
+   *
+   * The hardware is expected to keep its previous command modes when the switch fails, so the
+   * controllers running before the switch are running again afterwards and none of the
+   * requested controllers is started. switch_controller() returns ERROR.
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  void restart_stopped_controllers();
+
   CONTROLLER_MANAGER_PUBLIC
   void start_controllers();
 
@@ -138,11 +257,26 @@ protected:
     const std::shared_ptr<controller_manager_msgs::srv::ListControllerTypes::Request> request,
     std::shared_ptr<controller_manager_msgs::srv::ListControllerTypes::Response> response);
 
+  CONTROLLER_MANAGER_PUBLIC
+  void list_hardware_interfaces_srv_cb(
+    const std::shared_ptr<controller_manager_msgs::srv::ListHardwareInterfaces::Request> request,
+    std::shared_ptr<controller_manager_msgs::srv::ListHardwareInterfaces::Response> response);
+
+  CONTROLLER_MANAGER_PUBLIC
+  void write_trace_srv_cb(
+    const std::shared_ptr<controller_manager_msgs::srv::WriteTrace::Request> request,
+    std::shared_ptr<controller_manager_msgs::srv::WriteTrace::Response> response);
+
   CONTROLLER_MANAGER_PUBLIC
   void load_controller_service_cb(
     const std::shared_ptr<controller_manager_msgs::srv::LoadController::Request> request,
     std::shared_ptr<controller_manager_msgs::srv::LoadController::Response> response);
 
+  CONTROLLER_MANAGER_PUBLIC
+  void load_controllers_service_cb(
+    const std::shared_ptr<controller_manager_msgs::srv::LoadControllers::Request> request,
+    std::shared_ptr<controller_manager_msgs::srv::LoadControllers::Response> response);
+
   CONTROLLER_MANAGER_PUBLIC
   void reload_controller_libraries_service_cb(
     const std::shared_ptr<controller_manager_msgs::srv::ReloadControllerLibraries::Request> request,
@@ -161,9 +295,195 @@ protected:
 private:
   std::vector<std::string> get_controller_names();
 
+  /**
+   * @brief get_controller_type reads the type of a controller from the "<name>.type" parameter
+   * @return false if the parameter is not defined
+   */
+  bool get_controller_type(const std::string & controller_name, std::string & controller_type);
+
+  /**
+   * @brief set_claimed_resources Queries the resources and reference interfaces claimed by a
+   * configured controller, computes its bitset of claimed interface slots and exports its
+   * reference interfaces
+   * @warning controllers_lock_ must be held
+   */
+  void set_claimed_resources(ControllerSpec & controller);
+
+  /**
+   * @brief set_watchdog_deadline Reads the deadline of a controller's update() from the
+   * "<name>.watchdog_deadline" parameter, "watchdog.controller_deadline" if it is not set
+   */
+  void set_watchdog_deadline(ControllerSpec & controller);
+
+  /**
+   * @brief on_overrun Logs a phase of the realtime loop which overran its deadline and
+   * schedules the configured reaction, called from the watchdog thread
+   */
+  void on_overrun(const Watchdog::Overrun & overrun);
+
+  /**
+   * @brief react_to_overrun Prepares starting the hold controller or stopping all controllers
+   * after an overrun, depending on the "watchdog.reaction" parameter, and hands it over to the
+   * realtime loop without waiting for it
+   */
+  void react_to_overrun();
+
+  /**
+   * @brief perform_overrun_reaction Stops and starts the controllers prepared by
+   * react_to_overrun(), called by the realtime loop before updating the controllers
+   */
+  void perform_overrun_reaction(std::vector<ControllerSpec> & rt_controller_list);
+
+  /**
+   * @brief init_controller Initializes a controller with its own LifecycleNode, or sharing this
+   * node if the "lightweight_controllers" parameter is set
+   */
+  controller_interface::return_type init_controller(
+    controller_interface::ControllerInterface & controller, const std::string & controller_name);
+
+  void add_controller_to_executor(controller_interface::ControllerInterface & controller);
+
+  void remove_controller_from_executor(controller_interface::ControllerInterface & controller);
+
+  /**
+   * @brief override_clocks Sets the clocks of this node and of all controllers to the
+   * simulated time, see enable_stepping()
+   */
+  void override_clocks(rcl_time_point_value_t time);
+
+  /**
+   * @brief switch_controller_impl Validates a switch and hands it over to the realtime loop,
+   * see switch_controller(), which publishes the resulting events
+   */
+  controller_interface::return_type switch_controller_impl(
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers,
+    int strictness,
+    bool start_asap,
+    const rclcpp::Duration & timeout);
+
+  /**
+   * @brief publish_controller_event Numbers an event and publishes it on ~/controller_events
+   */
+  void publish_controller_event(controller_manager_msgs::msg::ControllerEvent && event);
+
+  /**
+   * @brief report_rt_allocations Warns about controllers which allocated in update() since the
+   * last report
+   */
+  void report_rt_allocations();
+
+  /**
+   * @brief begin_hardware_allocation_tracking Tracks the allocations of the calling thread in
+   * the "hardware" context if rt_allocation_check is set, until
+   * end_hardware_allocation_tracking()
+   * @return the tracking mode to pass to end_hardware_allocation_tracking()
+   */
+  allocation_tracker::Mode begin_hardware_allocation_tracking();
+
+  /**
+   * @brief end_hardware_allocation_tracking Stops the tracking started by
+   * begin_hardware_allocation_tracking() and adds the allocations to rt_hardware_allocations_
+   */
+  void end_hardware_allocation_tracking(
+    allocation_tracker::Mode allocation_check, std::uint64_t allocations_at_start);
+
+  /**
+   * @brief publish_lifecycle_event Publishes a load or unload event with the current state of
+   * the controller
+   */
+  void publish_lifecycle_event(
+    std::uint8_t type, controller_interface::ControllerInterface & controller);
+
+  /**
+   * @brief connect_reference_interfaces Hands a controller about to be started the handles to
+   * the reference interfaces it claims from the controllers it is chained to
+   * @return false if a claimed reference interface is not exported by any of the controllers
+   */
+  bool connect_reference_interfaces(
+    const ControllerSpec & controller, const std::vector<ControllerSpec> & controllers);
+
   std::shared_ptr<hardware_interface::RobotHardware> hw_;
   std::shared_ptr<rclcpp::Executor> executor_;
+  /// Executor spinning the controller nodes, executor_ unless a dedicated one is configured
+  std::shared_ptr<rclcpp::Executor> controller_executor_;
+  /// Spins controller_executor_ if it is owned by the controller manager
+  std::thread controller_executor_thread_;
   std::shared_ptr<pluginlib::ClassLoader<controller_interface::ControllerInterface>> loader_;
+  bool preload_controller_libraries_ = false;
+  /// Publishes the registered joint and actuator values, only created if the
+  /// "publish_dynamic_joint_states" parameter is set
+  std::unique_ptr<DynamicJointStatePublisher> dynamic_joint_state_publisher_;
+  /// Values of the registered joints and actuators served by list_hardware_interfaces,
+  /// refreshed every update() cycle
+  std::unique_ptr<HardwareStateSnapshot> hardware_state_snapshot_;
+  /// Records the registered joints and actuators every update() cycle, only created if the
+  /// "record.file_path" parameter is set
+  std::unique_ptr<hardware_interface::Recorder> recorder_;
+
+  /// Tracking of allocations in read(), update() and write(), set by the "rt_allocation_check"
+  /// parameter
+  std::atomic<allocation_tracker::Mode> rt_allocation_check_{allocation_tracker::Mode::OFF};
+  /// Allocations in update() outside of the controllers
+  std::atomic<std::uint64_t> rt_allocations_{0};
+  /// Allocations of the hardware in read() and write()
+  std::atomic<std::uint64_t> rt_hardware_allocations_{0};
+  rclcpp::TimerBase::SharedPtr rt_allocation_report_timer_;
+  /// Allocations already reported per controller, only used by the report timer
+  std::unordered_map<std::string, std::uint64_t> reported_rt_allocations_;
+  std::uint64_t reported_manager_rt_allocations_ = 0;
+  std::uint64_t reported_hardware_rt_allocations_ = 0;
+  OnSetParametersCallbackHandle::SharedPtr parameters_callback_handle_;
+
+  /// Reaction of the controller manager to an overrun detected by the watchdog
+  enum class WatchdogReaction
+  {
+    /// Only log the overrun
+    LOG,
+    /// Switch to the controller named by the "watchdog.hold_controller" parameter
+    HOLD,
+    /// Stop all running controllers
+    STOP,
+  };
+
+  /// Deadlines of the phases of the realtime loop, zero if a phase is not monitored
+  std::chrono::nanoseconds read_deadline_{0};
+  std::chrono::nanoseconds update_deadline_{0};
+  std::chrono::nanoseconds write_deadline_{0};
+  std::chrono::nanoseconds controller_deadline_{0};
+  WatchdogReaction watchdog_reaction_ = WatchdogReaction::LOG;
+  std::string hold_controller_;
+  /// Set by the watchdog thread, the reaction is prepared by a timer in its own callback group
+  std::atomic<bool> overrun_reaction_pending_{false};
+  rclcpp::CallbackGroup::SharedPtr watchdog_callback_group_;
+  rclcpp::TimerBase::SharedPtr overrun_reaction_timer_;
+
+  /// Switch in reaction to an overrun, prepared by react_to_overrun() and performed by update()
+  struct OverrunReaction
+  {
+    std::vector<std::string> stop_controllers;
+    std::vector<std::string> start_controllers;
+    std::vector<hardware_interface::InterfaceResources> stop_interfaces;
+    std::vector<hardware_interface::InterfaceResources> start_interfaces;
+    /// False if the hardware cannot switch, the controllers are then only stopped
+    bool switch_command_modes = false;
+  };
+
+  enum class OverrunReactionState : std::uint8_t
+  {
+    /// overrun_reaction_ belongs to the timer
+    IDLE,
+    /// overrun_reaction_ belongs to the realtime loop until it performed the reaction
+    REQUESTED,
+  };
+
+  OverrunReaction overrun_reaction_;
+  std::atomic<OverrunReactionState> overrun_reaction_state_{OverrunReactionState::IDLE};
+  /// Serializes the preparation of the hardware by switches and by the reaction to overruns
+  std::mutex command_mode_switch_lock_;
+  /// Only created if any phase is monitored, reset first on destruction since it calls
+  /// on_overrun()
+  std::unique_ptr<Watchdog> watchdog_;
 
   /**
    * @brief The RTControllerListWrapper class wraps a double-buffered list of controllers
@@ -181,6 +501,67 @@ private:
 // *INDENT-OFF*
   public:
 // *INDENT-ON*
+    /**
+     * @brief The Transaction class batches several changes of the controllers list
+     * so they cost a single copy of the list and a single handoff to the RT thread.
+     *
+     * Beginning a transaction (constructing it) locks the controllers list and copies the
+     * "updated" list into the "unused by rt" one. add() and remove() modify that copy and
+     * commit() makes it the "updated" list. Destroying an uncommitted transaction discards
+     * its changes.
+     */
+    class Transaction
+    {
+// *INDENT-OFF*
+    public:
+// *INDENT-ON*
+      explicit Transaction(RTControllerListWrapper & wrapper);
+
+      ~Transaction();
+
+      Transaction(const Transaction &) = delete;
+      Transaction & operator=(const Transaction &) = delete;
+
+      /**
+       * @brief find Looks up a controller in the pending list
+       * @return pointer to the controller spec, nullptr if there is none with this name
+       */
+      ControllerSpec * find(const std::string & controller_name);
+
+      void add(const ControllerSpec & controller);
+
+      /**
+       * @brief order_chained_controllers Sorts the pending list so that every controller is
+       * updated before the controllers whose reference interfaces it writes, keeping the
+       * order of unrelated controllers
+       * @return false if the controllers are chained in a cycle, the list is left unchanged
+       */
+      bool order_chained_controllers();
+
+      /**
+       * @brief remove Removes a controller from the pending list
+       * @return false if there is no controller with this name
+       */
+      bool remove(const std::string & controller_name);
+
+      const std::vector<ControllerSpec> & get_list() const;
+
+      /**
+       * @brief commit Switches the lists once and waits until the RT thread is using the
+       * new one, then destroys the outdated list. Does not wait if nothing was changed.
+       */
+      void commit();
+
+// *INDENT-OFF*
+    private:
+// *INDENT-ON*
+      RTControllerListWrapper & wrapper_;
+      std::lock_guard<std::recursive_mutex> guard_;
+      std::vector<ControllerSpec> & list_;
+      bool modified_ = false;
+      bool committed_ = false;
+    };
+
     /**
      * @brief update_and_get_used_by_rt_list Makes the "updated" list the "used by rt" list
      * @warning Should only be called by the RT thread, no one should modify the
@@ -189,6 +570,13 @@ private:
      */
     std::vector<ControllerSpec> & update_and_get_used_by_rt_list();
 
+    /**
+     * @brief release_used_by_rt_list Marks that the realtime thread does not use any list until
+     * its next update_and_get_used_by_rt_list() call, so that changes need not wait for it
+     * @warning Should only be called by the RT thread, outside of update()
+     */
+    void release_used_by_rt_list();
+
     /**
      * @brief get_unused_list Waits until the "outdated" and "unused by rt"
      * lists match and returns a reference to it
@@ -214,10 +602,27 @@ private:
      */
     void switch_updated_list(const std::lock_guard<std::recursive_mutex> & guard);
 
+    /// Controller of the snapshot, not keeping the controller alive
+    struct SnapshotEntry
+    {
+      hardware_interface::ControllerInfo info;
+      std::weak_ptr<controller_interface::ControllerInterface> c;
+      std::shared_ptr<std::atomic<std::uint64_t>> rt_allocations;
+    };
+
+    /**
+     * @brief get_snapshot Returns the controllers of the updated list, taken at the last commit
+     * of a Transaction, without locking the controllers list
+     */
+    std::shared_ptr<const std::vector<SnapshotEntry>> get_snapshot() const;
+
     // Mutex protecting the controllers list
     // must be acquired before using any list other than the "used by rt"
     mutable std::recursive_mutex controllers_lock_;
 
+    /// Incremented whenever controllers are added, removed, started or stopped, starting at 1
+    std::atomic<std::uint64_t> generation_{1};
+
 // *INDENT-OFF*
   private:
 // *INDENT-ON*
@@ -235,18 +640,37 @@ private:
     int updated_controllers_index_ = 0;
     /// The index of the controllers list being used in the real-time thread.
     int used_by_realtime_controllers_index_ = -1;
+    /// Copy of the updated list, accessed atomically
+    std::shared_ptr<const std::vector<SnapshotEntry>> snapshot_ =
+      std::make_shared<const std::vector<SnapshotEntry>>();
   };
 
   RTControllerListWrapper rt_controllers_wrapper_;
   /// mutex copied from ROS1 Control, protects service callbacks
   /// not needed if we're guaranteed that the callbacks don't come from multiple threads
   std::mutex services_lock_;
+  /// Services changing the controllers run mutually exclusive, the read-only list services
+  /// in a separate group so they are not held up by a slow load or switch
+  rclcpp::CallbackGroup::SharedPtr services_callback_group_;
+  rclcpp::CallbackGroup::SharedPtr list_services_callback_group_;
+  /// Unfiltered list_controllers response, rebuilt when the generation of the controllers changes
+  std::mutex list_controllers_cache_lock_;
+  std::vector<controller_manager_msgs::msg::ControllerState> list_controllers_cache_;
+  std::uint64_t list_controllers_cache_generation_ = 0;
   rclcpp::Service<controller_manager_msgs::srv::ListControllers>::SharedPtr
     list_controllers_service_;
   rclcpp::Service<controller_manager_msgs::srv::ListControllerTypes>::SharedPtr
     list_controller_types_service_;
+  rclcpp::Service<controller_manager_msgs::srv::ListHardwareInterfaces>::SharedPtr
+    list_hardware_interfaces_service_;
+  rclcpp::Service<controller_manager_msgs::srv::WriteTrace>::SharedPtr write_trace_service_;
+  /// Only directory the write_trace service writes to, from the read-only "trace_directory"
+  /// parameter
+  std::string trace_directory_;
   rclcpp::Service<controller_manager_msgs::srv::LoadController>::SharedPtr
     load_controller_service_;
+  rclcpp::Service<controller_manager_msgs::srv::LoadControllers>::SharedPtr
+    load_controllers_service_;
   rclcpp::Service<controller_manager_msgs::srv::ReloadControllerLibraries>::SharedPtr
     reload_controller_libraries_service_;
   rclcpp::Service<controller_manager_msgs::srv::SwitchController>::SharedPtr
@@ -254,15 +678,22 @@ private:
   rclcpp::Service<controller_manager_msgs::srv::UnloadController>::SharedPtr
     unload_controller_service_;
 
+  /// Index of the bit assigned to each claimed "<resource>/<interface>" in ControllerSpec,
+  /// protected by controllers_lock_
+  std::unordered_map<std::string, size_t> resource_slots_;
+
   std::vector<std::string> start_request_, stop_request_;
-#ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
-//  std::list<hardware_interface::ControllerInfo> switch_start_list_, switch_stop_list_;
-#endif
+  /// Interfaces claimed by the controllers really being started and stopped, handed to the
+  /// hardware to switch command modes
+  std::vector<hardware_interface::InterfaceResources> switch_start_list_, switch_stop_list_;
 
   struct SwitchParams
   {
     bool do_switch = {false};
     bool started = {false};
+    bool hardware_switch_failed = {false};
+    /// Set when the reaction to an overrun cancelled the switch before it completed
+    bool aborted = {false};
     rclcpp::Time init_time = {rclcpp::Time::max()};
 
     // Switch options
@@ -272,6 +703,35 @@ private:
   };
 
   SwitchParams switch_params_;
+
+  /// Set by enable_stepping(), the simulated time is only changed by step()
+  bool stepping_ = false;
+  /// Held by every cycle of step() and by synchronous switches, so they never run concurrently
+  std::mutex step_lock_;
+  rclcpp::Duration step_period_{0, 0};
+  rcl_time_point_value_t simulated_time_ = 0;
+
+  /// Transition of a controller by the realtime loop during a switch
+  struct TransitionRecord
+  {
+    std::string controller;
+    /// State expected after the transition
+    std::uint8_t goal_state_id;
+    bool performed = false;
+    std::uint8_t state_id = 0;
+    std::chrono::system_clock::time_point start;
+    std::chrono::system_clock::time_point end;
+  };
+
+  /// One record per stop request followed by one per start request, allocated before the
+  /// switch is handed over to the realtime loop which only fills them in
+  std::vector<TransitionRecord> transition_records_;
+
+  rclcpp::Publisher<controller_manager_msgs::msg::ControllerEvent>::SharedPtr
+    controller_event_publisher_;
+  /// Keeps sequence numbers in publishing order
+  std::mutex controller_event_lock_;
+  std::uint64_t controller_event_sequence_ = 0;
 };
 
 }  // namespace controller_manager
@@ -19,11 +19,17 @@
 #ifndef CONTROLLER_MANAGER__CONTROLLER_SPEC_HPP_
 #define CONTROLLER_MANAGER__CONTROLLER_SPEC_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "controller_interface/controller_interface.hpp"
 #include "hardware_interface/controller_info.hpp"
+#include "hardware_interface/interface_resources.hpp"
+#include "hardware_interface/joint_handle.hpp"
 
 namespace controller_manager
 {
@@ -38,6 +44,19 @@ struct ControllerSpec
 {
   hardware_interface::ControllerInfo info;
   controller_interface::ControllerInterfaceSharedPtr c;
+  /** Bitset over the interface slots of the controller manager, one bit per claimed resource. */
+  std::vector<std::uint64_t> claimed_slots;
+  /** Reference interfaces of other controllers written by the controller. */
+  std::vector<hardware_interface::InterfaceResources> claimed_reference_interfaces;
+  /** Names of the controllers the claimed reference interfaces belong to, updated after it. */
+  std::vector<std::string> chained_controllers;
+  /** Allocations made by update() in the realtime loop, counted if allocation checks are on. */
+  std::shared_ptr<std::atomic<std::uint64_t>> rt_allocations =
+    std::make_shared<std::atomic<std::uint64_t>>(0u);
+  /** Identifier of the controller in the watchdog of the controller manager. */
+  std::size_t watchdog_id = 0;
+  /** Time update() may take before the watchdog reports it, zero if it is not monitored. */
+  std::chrono::nanoseconds watchdog_deadline{0};
 };
 
 }  // namespace controller_manager
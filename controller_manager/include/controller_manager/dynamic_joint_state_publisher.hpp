@@ -0,0 +1,101 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_MANAGER__DYNAMIC_JOINT_STATE_PUBLISHER_HPP_
+#define CONTROLLER_MANAGER__DYNAMIC_JOINT_STATE_PUBLISHER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+
+#include "controller_manager/visibility_control.h"
+
+#include "hardware_interface/robot_hardware.hpp"
+
+#include "rclcpp/node.hpp"
+#include "rclcpp/publisher.hpp"
+
+namespace controller_manager
+{
+
+/**
+ * @brief The DynamicJointStatePublisher class publishes the values of all joints and actuators
+ * registered in a RobotHardware on "~/dynamic_joint_states" and "~/dynamic_actuator_states".
+ *
+ * update() is called from the realtime thread and copies the values into a preallocated
+ * snapshot without allocating or blocking. A non-realtime thread owned by this class publishes
+ * the latest snapshot, using loaned messages when the middleware supports them.
+ */
+class DynamicJointStatePublisher
+{
+public:
+  /**
+   * @param node node used to create the publishers
+   * @param hw hardware whose registered joints and actuators are published
+   * @param poll_period how often the publishing thread checks for a new snapshot
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  DynamicJointStatePublisher(
+    rclcpp::Node & node,
+    std::shared_ptr<hardware_interface::RobotHardware> hw,
+    std::chrono::nanoseconds poll_period = std::chrono::milliseconds(1));
+
+  CONTROLLER_MANAGER_PUBLIC
+  ~DynamicJointStatePublisher();
+
+  DynamicJointStatePublisher(const DynamicJointStatePublisher &) = delete;
+  DynamicJointStatePublisher & operator=(const DynamicJointStatePublisher &) = delete;
+
+  /**
+   * @brief update Takes a snapshot of the current values to be published, realtime safe.
+   * Skips the snapshot if the publishing thread is copying the previous one.
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  void update();
+
+private:
+  void publishing_loop();
+
+  void publish(
+    rclcpp::Publisher<control_msgs::msg::DynamicJointState> & publisher,
+    const control_msgs::msg::DynamicJointState & message);
+
+  std::shared_ptr<hardware_interface::RobotHardware> hw_;
+  rclcpp::Clock::SharedPtr clock_;
+  rclcpp::Publisher<control_msgs::msg::DynamicJointState>::SharedPtr joint_state_publisher_;
+  rclcpp::Publisher<control_msgs::msg::DynamicJointState>::SharedPtr actuator_state_publisher_;
+  std::chrono::nanoseconds poll_period_;
+
+  /// Written by the realtime thread, protected by snapshot_mutex_
+  control_msgs::msg::DynamicJointState joint_state_snapshot_;
+  control_msgs::msg::DynamicJointState actuator_state_snapshot_;
+  std::mutex snapshot_mutex_;
+
+  /// Only used by the publishing thread, keep the capacity of the snapshots
+  control_msgs::msg::DynamicJointState joint_state_message_;
+  control_msgs::msg::DynamicJointState actuator_state_message_;
+
+  std::atomic<bool> new_snapshot_{false};
+  std::atomic<bool> layout_changed_{true};
+  std::atomic<bool> keep_running_{true};
+  std::thread publishing_thread_;
+};
+
+}  // namespace controller_manager
+
+#endif  // CONTROLLER_MANAGER__DYNAMIC_JOINT_STATE_PUBLISHER_HPP_
@@ -0,0 +1,91 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_MANAGER__HARDWARE_STATE_SNAPSHOT_HPP_
+#define CONTROLLER_MANAGER__HARDWARE_STATE_SNAPSHOT_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+
+#include "controller_manager/visibility_control.h"
+
+#include "hardware_interface/robot_hardware.hpp"
+
+namespace controller_manager
+{
+
+/**
+ * @brief The HardwareStateSnapshot class keeps a double-buffered copy of the values of all
+ * joints and actuators registered in a RobotHardware.
+ *
+ * update() is called from the realtime thread and fills the buffer not holding the latest
+ * snapshot, skipping the cycle instead of blocking if a reader still uses it. get() copies the
+ * latest complete snapshot, so all values of a snapshot come from the same cycle.
+ */
+class HardwareStateSnapshot
+{
+public:
+  CONTROLLER_MANAGER_PUBLIC
+  explicit HardwareStateSnapshot(std::shared_ptr<hardware_interface::RobotHardware> hw);
+
+  HardwareStateSnapshot(const HardwareStateSnapshot &) = delete;
+  HardwareStateSnapshot & operator=(const HardwareStateSnapshot &) = delete;
+
+  /**
+   * @brief update Takes a snapshot of the current values, realtime safe.
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  void update();
+
+  /**
+   * @brief get Copies the latest snapshot, not realtime safe.
+   * @param[out] joint_state registered joints, interfaces and their values
+   * @param[out] actuator_state registered actuators, interfaces and their values
+   * @return time the snapshot was taken in nanoseconds since the epoch, 0 if no snapshot was
+   * taken since the layout was last (re)allocated, the values are left empty in that case
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  std::int64_t get(
+    control_msgs::msg::DynamicJointState & joint_state,
+    control_msgs::msg::DynamicJointState & actuator_state);
+
+private:
+  /// (Re)allocates both buffers after joints or interfaces were registered
+  void allocate_buffers();
+
+  struct Buffer
+  {
+    control_msgs::msg::DynamicJointState joint_state;
+    control_msgs::msg::DynamicJointState actuator_state;
+    std::int64_t stamp = 0;
+    std::mutex mutex;
+  };
+
+  std::shared_ptr<hardware_interface::RobotHardware> hw_;
+  std::array<Buffer, 2> buffers_;
+  /// Index of the buffer with the latest complete snapshot, -1 if there is none
+  std::atomic<int> latest_buffer_{-1};
+  std::atomic<bool> layout_changed_{false};
+  /// Serializes readers, the realtime thread never takes it
+  std::mutex reader_mutex_;
+};
+
+}  // namespace controller_manager
+
+#endif  // CONTROLLER_MANAGER__HARDWARE_STATE_SNAPSHOT_HPP_
@@ -0,0 +1,165 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_MANAGER__WATCHDOG_HPP_
+#define CONTROLLER_MANAGER__WATCHDOG_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller_manager/visibility_control.h"
+
+namespace controller_manager
+{
+
+/**
+ * @brief The Watchdog class detects phases of the realtime loop overrunning their deadline,
+ * e.g. a hardware read() blocked on a bus timeout.
+ *
+ * The realtime thread publishes the start and deadline of every phase with a few atomic stores,
+ * without locks. A watchdog thread polls them and reports a phase as soon as it has run for
+ * longer than its deadline, while it still runs, once per phase. The realtime thread counts the
+ * phases which end late itself, so that overruns shorter than the polling period are seen too.
+ *
+ * Controller updates run within the update phase and are monitored in addition to it.
+ */
+class Watchdog
+{
+public:
+  enum class Phase : std::uint8_t
+  {
+    IDLE = 0,
+    READ = 1,
+    UPDATE = 2,
+    WRITE = 3,
+    CONTROLLER = 4,
+  };
+
+  /// A phase found running past its deadline
+  struct Overrun
+  {
+    Phase phase;
+    /// Name of the controller, empty unless the phase is Phase::CONTROLLER
+    std::string controller;
+    std::chrono::nanoseconds deadline;
+    /// Time the phase had been running for when the overrun was detected
+    std::chrono::nanoseconds elapsed;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  using OverrunCallback = std::function<void (const Overrun &)>;
+
+  /**
+   * @brief Watchdog Starts the watchdog thread.
+   * @param check_period time between two checks of the running phases
+   * @param callback called from the watchdog thread for every overrun detected
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  Watchdog(std::chrono::nanoseconds check_period, OverrunCallback callback);
+
+  /// Stops the watchdog thread
+  CONTROLLER_MANAGER_PUBLIC
+  ~Watchdog();
+
+  Watchdog(const Watchdog &) = delete;
+  Watchdog & operator=(const Watchdog &) = delete;
+
+  /// Identifier of a controller to pass to begin_controller(), the same for the same name
+  CONTROLLER_MANAGER_PUBLIC
+  std::size_t register_controller(const std::string & name);
+
+  /**
+   * @brief begin_phase Marks the start of a read, update or write phase, ending the previous one.
+   * Realtime safe.
+   * @param deadline time the phase may take, zero if it is not monitored
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  void begin_phase(Phase phase, std::chrono::nanoseconds deadline) noexcept;
+
+  /// Marks the end of the current read, update or write phase, realtime safe
+  CONTROLLER_MANAGER_PUBLIC
+  void end_phase() noexcept;
+
+  /**
+   * @brief begin_controller Marks the start of the update of a controller, realtime safe.
+   * @param controller identifier returned by register_controller()
+   * @param deadline time the update may take, zero if it is not monitored
+   */
+  CONTROLLER_MANAGER_PUBLIC
+  void begin_controller(std::size_t controller, std::chrono::nanoseconds deadline) noexcept;
+
+  /// Marks the end of the update of the current controller, realtime safe
+  CONTROLLER_MANAGER_PUBLIC
+  void end_controller() noexcept;
+
+  /// Number of phases of the given kind which ended after their deadline
+  CONTROLLER_MANAGER_PUBLIC
+  std::uint64_t get_late_count(Phase phase) const;
+
+  /// The most recent overruns detected by the watchdog thread, oldest first
+  CONTROLLER_MANAGER_PUBLIC
+  std::vector<Overrun> get_overruns() const;
+
+  CONTROLLER_MANAGER_PUBLIC
+  static const char * phase_name(Phase phase);
+
+  /// Number of overruns kept for get_overruns()
+  static constexpr std::size_t kMaxOverruns = 100;
+
+private:
+  /// Running phase, written by the realtime thread only and read consistently with a seqlock
+  struct Slot
+  {
+    std::atomic<std::uint32_t> sequence{0};
+    std::atomic<std::uint8_t> phase{static_cast<std::uint8_t>(Phase::IDLE)};
+    std::atomic<std::size_t> controller{0};
+    std::atomic<std::int64_t> start{0};
+    std::atomic<std::int64_t> deadline{0};
+    /// Sequence of the phase reported last, used by the watchdog thread only
+    std::uint32_t reported_sequence = 0;
+  };
+
+  void publish(
+    Slot & slot, Phase phase, std::size_t controller, std::chrono::nanoseconds deadline) noexcept;
+  void finish(Slot & slot) noexcept;
+  void check(Slot & slot, std::int64_t now);
+  void run();
+
+  Slot loop_slot_;
+  Slot controller_slot_;
+  std::array<std::atomic<std::uint64_t>, 5> late_counts_;
+
+  std::chrono::nanoseconds check_period_;
+  OverrunCallback callback_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::string> controller_names_;
+  std::deque<Overrun> overruns_;
+  std::condition_variable stop_condition_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace controller_manager
+
+#endif  // CONTROLLER_MANAGER__WATCHDOG_HPP_
@@ -0,0 +1,89 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Interposes the glibc allocation functions to report every allocation to the allocation
+// tracker, load with LD_PRELOAD=libcontroller_manager_allocation_hooks.so.
+// operator new allocates through malloc or, when over-aligned, aligned_alloc and is therefore
+// covered as well.
+
+#include <cerrno>
+#include <cstddef>
+
+#include "controller_manager/allocation_tracker.hpp"
+
+extern "C" {
+
+void * __libc_malloc(std::size_t size);
+void * __libc_calloc(std::size_t count, std::size_t size);
+void * __libc_realloc(void * ptr, std::size_t size);
+void * __libc_memalign(std::size_t alignment, std::size_t size);
+
+void * malloc(std::size_t size)
+{
+  controller_manager::allocation_tracker::on_allocation();
+  return __libc_malloc(size);
+}
+
+void * calloc(std::size_t count, std::size_t size)
+{
+  controller_manager::allocation_tracker::on_allocation();
+  return __libc_calloc(count, size);
+}
+
+void * realloc(void * ptr, std::size_t size)
+{
+  controller_manager::allocation_tracker::on_allocation();
+  return __libc_realloc(ptr, size);
+}
+
+void * memalign(std::size_t alignment, std::size_t size)
+{
+  controller_manager::allocation_tracker::on_allocation();
+  return __libc_memalign(alignment, size);
+}
+
+void * aligned_alloc(std::size_t alignment, std::size_t size)
+{
+  controller_manager::allocation_tracker::on_allocation();
+  return __libc_memalign(alignment, size);
+}
+
+// glibc exports no __libc_posix_memalign, the checks of posix_memalign are done here
+int posix_memalign(void ** ptr, std::size_t alignment, std::size_t size)
+{
+  controller_manager::allocation_tracker::on_allocation();
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment % sizeof(void *) != 0) {
+    return EINVAL;
+  }
+  void * allocated = __libc_memalign(alignment, size);
+  if (allocated == nullptr) {
+    return ENOMEM;
+  }
+  *ptr = allocated;
+  return 0;
+}
+
+}  // extern "C"
+
+namespace
+{
+struct HooksInstaller
+{
+  HooksInstaller()
+  {
+    controller_manager::allocation_tracker::set_hooks_installed();
+  }
+};
+const HooksInstaller installer;
+}  // namespace
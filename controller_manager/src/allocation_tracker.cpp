@@ -0,0 +1,148 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_manager/allocation_tracker.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// The state is read by the allocation hooks, possibly before the thread ran any other code of
+// this library. Static TLS needs no allocation on first access, unlike the dynamic model.
+#if defined(__GNUC__) && !defined(_WIN32)
+#define CONTROLLER_MANAGER_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define CONTROLLER_MANAGER_TLS_MODEL
+#endif
+
+namespace controller_manager
+{
+namespace allocation_tracker
+{
+
+namespace
+{
+/// Trivial so that it is zero initialized without a TLS constructor
+struct ThreadState
+{
+  Mode mode;
+  const char * context;
+  std::uint64_t allocations;
+};
+
+thread_local ThreadState thread_state CONTROLLER_MANAGER_TLS_MODEL;
+std::atomic<bool> hooks_loaded{false};
+
+void write_to_stderr(const char * text)
+{
+#ifndef _WIN32
+  // fprintf may allocate
+  const auto ignored = ::write(STDERR_FILENO, text, std::strlen(text));
+  (void) ignored;
+#else
+  std::fputs(text, stderr);
+#endif
+}
+}  // namespace
+
+Mode parse_mode(const std::string & mode)
+{
+  if (mode == "off") {
+    return Mode::OFF;
+  }
+  if (mode == "count") {
+    return Mode::COUNT;
+  }
+  if (mode == "trap") {
+    return Mode::TRAP;
+  }
+  throw std::invalid_argument(
+          "Unknown allocation tracking mode '" + mode + "', expected off, count or trap");
+}
+
+bool hooks_installed()
+{
+  return hooks_loaded;
+}
+
+void set_hooks_installed()
+{
+  hooks_loaded = true;
+}
+
+void set_mode(Mode mode)
+{
+  thread_state.mode = mode;
+}
+
+Mode get_mode()
+{
+  return thread_state.mode;
+}
+
+void set_context(const char * context)
+{
+  thread_state.context = context;
+}
+
+std::uint64_t get_allocations()
+{
+  return thread_state.allocations;
+}
+
+void on_allocation() noexcept
+{
+  auto & state = thread_state;
+  if (state.mode == Mode::OFF) {
+    return;
+  }
+  ++state.allocations;
+  if (state.mode == Mode::TRAP) {
+    state.mode = Mode::OFF;
+    write_to_stderr("[controller_manager] Heap allocation in realtime context '");
+    write_to_stderr(state.context != nullptr ? state.context : "unknown");
+    write_to_stderr("', aborting\n");
+    std::abort();
+  }
+}
+
+ScopedTracking::ScopedTracking(const char * context, Mode mode)
+: previous_mode_(thread_state.mode),
+  previous_context_(thread_state.context),
+  allocations_at_start_(thread_state.allocations)
+{
+  thread_state.context = context;
+  thread_state.mode = mode;
+}
+
+ScopedTracking::~ScopedTracking()
+{
+  thread_state.mode = previous_mode_;
+  thread_state.context = previous_context_;
+}
+
+std::uint64_t ScopedTracking::get_allocations() const
+{
+  return thread_state.allocations - allocations_at_start_;
+}
+
+}  // namespace allocation_tracker
+}  // namespace controller_manager
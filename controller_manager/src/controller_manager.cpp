@@ -14,17 +14,42 @@
 
 #include "controller_manager/controller_manager.hpp"
 
+#ifndef _WIN32
+#include <link.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
 
 #include "controller_manager_msgs/srv/switch_controller.hpp"
 
+#include "hardware_interface/tracing.hpp"
+
 #include "lifecycle_msgs/msg/state.hpp"
 
+#include "rcl/error_handling.h"
+#include "rcl/time.h"
+
 #include "rclcpp/rclcpp.hpp"
 
 namespace controller_manager
@@ -35,15 +60,142 @@ static constexpr const char * kControllerInterface = "controller_interface::Cont
 
 inline bool is_controller_running(controller_interface::ControllerInterface & controller)
 {
-  return controller.get_lifecycle_node()->get_current_state().id() ==
+  return controller.get_current_state().id() ==
          lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE;
 }
 
+/// Label of a primary lifecycle state, without querying the controller
+const char * primary_state_label(std::uint8_t state_id)
+{
+  switch (state_id) {
+    case lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED:
+      return "unconfigured";
+    case lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE:
+      return "inactive";
+    case lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE:
+      return "active";
+    case lifecycle_msgs::msg::State::PRIMARY_STATE_FINALIZED:
+      return "finalized";
+    default:
+      return "unknown";
+  }
+}
+
+rclcpp::Time to_ros_time(const std::chrono::system_clock::time_point & time_point)
+{
+  return rclcpp::Time(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(time_point.time_since_epoch()).count());
+}
+
+/// Matches '*' to any sequence of characters and '?' to any single one, an empty pattern to all
+bool matches_glob_pattern(const std::string & name, const std::string & pattern)
+{
+  if (pattern.empty()) {
+    return true;
+  }
+  size_t n = 0, p = 0;
+  size_t star = std::string::npos, star_match = 0;
+  while (n < name.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+      ++n;
+      ++p;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      star_match = n;
+    } else if (star != std::string::npos) {
+      // let the last star match one more character
+      p = star + 1;
+      n = ++star_match;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+std::chrono::nanoseconds to_deadline(double seconds)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(seconds));
+}
+
 bool controller_name_compare(const ControllerSpec & a, const std::string & name)
 {
   return a.info.name == name;
 }
 
+/**
+ * @brief lock_library_pages Locks the pages of a loaded shared library in memory,
+ * faulting them in
+ * @param library_path path the library was loaded from
+ * @return error message, empty on success
+ */
+std::string lock_library_pages(const std::string & library_path)
+{
+#ifndef _WIN32
+  struct LockRequest
+  {
+    std::string real_path;
+    bool found;
+    std::string error;
+  };
+
+  char * real_path = realpath(library_path.c_str(), nullptr);
+  if (real_path == nullptr) {
+    return "cannot resolve path: " + std::string(std::strerror(errno));
+  }
+  LockRequest request{real_path, false, ""};
+  free(real_path);
+
+  dl_iterate_phdr(
+    [](struct dl_phdr_info * info, size_t, void * data) -> int
+    {
+      auto request = static_cast<LockRequest *>(data);
+      if (info->dlpi_name == nullptr || info->dlpi_name[0] == '\0') {
+        return 0;
+      }
+      char * object_path = realpath(info->dlpi_name, nullptr);
+      if (object_path == nullptr) {
+        return 0;
+      }
+      const bool is_library = request->real_path == object_path;
+      free(object_path);
+      if (!is_library) {
+        return 0;
+      }
+
+      const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+      for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const auto & segment = info->dlpi_phdr[i];
+        if (segment.p_type != PT_LOAD || segment.p_memsz == 0) {
+          continue;
+        }
+        const auto begin = static_cast<uintptr_t>(info->dlpi_addr + segment.p_vaddr);
+        const auto page_begin = begin & ~(page_size - 1);
+        if (mlock(
+            reinterpret_cast<void *>(page_begin),
+            begin - page_begin + segment.p_memsz) != 0)
+        {
+          request->error = "mlock failed: " + std::string(std::strerror(errno));
+        }
+      }
+      request->found = true;
+      return 1;
+    }, &request);
+
+  if (!request.found) {
+    return "library is not loaded";
+  }
+  return request.error;
+#else
+  (void)library_path;
+  return "locking library pages is not supported on this platform";
+#endif
+}
+
 rclcpp::NodeOptions get_cm_node_options()
 {
   rclcpp::NodeOptions node_options;
@@ -63,32 +215,205 @@ ControllerManager::ControllerManager(
       kControllerInterfaceName, kControllerInterface))
 {
   using namespace std::placeholders;
+  services_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+  list_services_callback_group_ =
+    create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+
   list_controllers_service_ = create_service<controller_manager_msgs::srv::ListControllers>(
     "~/list_controllers", std::bind(
       &ControllerManager::list_controllers_srv_cb, this, _1,
-      _2));
+      _2),
+    rmw_qos_profile_services_default, list_services_callback_group_);
   list_controller_types_service_ =
     create_service<controller_manager_msgs::srv::ListControllerTypes>(
     "~/list_controller_types", std::bind(
       &ControllerManager::list_controller_types_srv_cb, this, _1,
-      _2));
+      _2),
+    rmw_qos_profile_services_default, list_services_callback_group_);
+  list_hardware_interfaces_service_ =
+    create_service<controller_manager_msgs::srv::ListHardwareInterfaces>(
+    "~/list_hardware_interfaces", std::bind(
+      &ControllerManager::list_hardware_interfaces_srv_cb, this, _1,
+      _2),
+    rmw_qos_profile_services_default, list_services_callback_group_);
   load_controller_service_ = create_service<controller_manager_msgs::srv::LoadController>(
     "~/load_controller", std::bind(
       &ControllerManager::load_controller_service_cb, this, _1,
-      _2));
+      _2),
+    rmw_qos_profile_services_default, services_callback_group_);
+  load_controllers_service_ = create_service<controller_manager_msgs::srv::LoadControllers>(
+    "~/load_controllers", std::bind(
+      &ControllerManager::load_controllers_service_cb, this, _1,
+      _2),
+    rmw_qos_profile_services_default, services_callback_group_);
   reload_controller_libraries_service_ =
     create_service<controller_manager_msgs::srv::ReloadControllerLibraries>(
     "~/reload_controller_libraries", std::bind(
       &ControllerManager::reload_controller_libraries_service_cb, this, _1,
-      _2));
+      _2),
+    rmw_qos_profile_services_default, services_callback_group_);
   switch_controller_service_ = create_service<controller_manager_msgs::srv::SwitchController>(
     "~/switch_controller", std::bind(
       &ControllerManager::switch_controller_service_cb, this, _1,
-      _2));
+      _2),
+    rmw_qos_profile_services_default, services_callback_group_);
   unload_controller_service_ = create_service<controller_manager_msgs::srv::UnloadController>(
     "~/unload_controller", std::bind(
       &ControllerManager::unload_controller_service_cb, this, _1,
-      _2));
+      _2),
+    rmw_qos_profile_services_default, services_callback_group_);
+  write_trace_service_ = create_service<controller_manager_msgs::srv::WriteTrace>(
+    "~/write_trace", std::bind(
+      &ControllerManager::write_trace_srv_cb, this, _1,
+      _2),
+    rmw_qos_profile_services_default, services_callback_group_);
+
+  // latched, so that late joiners still see the recent history of the controllers
+  controller_event_publisher_ = create_publisher<controller_manager_msgs::msg::ControllerEvent>(
+    "~/controller_events", rclcpp::QoS(100).transient_local().reliable());
+
+  rcl_interfaces::msg::ParameterDescriptor preload_descriptor;
+  preload_descriptor.description =
+    "Load the controller libraries on startup and lock their pages in memory. Their symbols are "
+    "only bound on load if the controller manager runs with LD_BIND_NOW=1.";
+  preload_controller_libraries_ =
+    declare_parameter("preload_controller_libraries", false, preload_descriptor);
+  if (preload_controller_libraries_) {
+    preload_controller_libraries();
+  }
+
+  hardware_state_snapshot_ = std::make_unique<HardwareStateSnapshot>(hw_);
+
+  const auto record_file_path = declare_parameter("record.file_path", std::string());
+  hardware_interface::RecorderOptions record_options;
+  record_options.buffer_cycles = static_cast<std::size_t>(
+    declare_parameter("record.buffer_cycles", 1024));
+  record_options.delta_compression = declare_parameter("record.delta_compression", false);
+  if (!record_file_path.empty()) {
+    try {
+      recorder_ = std::make_unique<hardware_interface::Recorder>(
+        hw_, record_file_path, record_options);
+      RCLCPP_INFO(get_logger(), "Recording the hardware to '%s'", record_file_path.c_str());
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(get_logger(), "Cannot record the hardware: %s", e.what());
+    }
+  }
+
+  // phases of the realtime loop running past their deadline are reported by a watchdog thread,
+  // deadlines in seconds, zero to not monitor a phase
+  read_deadline_ = to_deadline(declare_parameter("watchdog.read_deadline", 0.0));
+  update_deadline_ = to_deadline(declare_parameter("watchdog.update_deadline", 0.0));
+  write_deadline_ = to_deadline(declare_parameter("watchdog.write_deadline", 0.0));
+  controller_deadline_ = to_deadline(declare_parameter("watchdog.controller_deadline", 0.0));
+  const auto watchdog_check_period = to_deadline(declare_parameter("watchdog.check_period", 0.001));
+  const auto watchdog_reaction = declare_parameter("watchdog.reaction", std::string("log"));
+  hold_controller_ = declare_parameter("watchdog.hold_controller", std::string());
+  if (watchdog_reaction == "hold" && !hold_controller_.empty()) {
+    watchdog_reaction_ = WatchdogReaction::HOLD;
+  } else if (watchdog_reaction == "stop") {
+    watchdog_reaction_ = WatchdogReaction::STOP;
+  } else if (watchdog_reaction != "log") {
+    RCLCPP_WARN(
+      get_logger(), "Unknown watchdog reaction '%s' or no hold controller set, only logging "
+      "overruns", watchdog_reaction.c_str());
+  }
+  if (read_deadline_.count() > 0 || update_deadline_.count() > 0 ||
+    write_deadline_.count() > 0 || controller_deadline_.count() > 0)
+  {
+    watchdog_ = std::make_unique<Watchdog>(
+      watchdog_check_period, std::bind(&ControllerManager::on_overrun, this, _1));
+    if (watchdog_reaction_ != WatchdogReaction::LOG) {
+      // not held up by a switch service waiting for the stalled realtime loop
+      watchdog_callback_group_ =
+        create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+      overrun_reaction_timer_ = create_wall_timer(
+        watchdog_check_period, std::bind(&ControllerManager::react_to_overrun, this),
+        watchdog_callback_group_);
+    }
+  }
+
+  if (declare_parameter("publish_dynamic_joint_states", false)) {
+    dynamic_joint_state_publisher_ = std::make_unique<DynamicJointStatePublisher>(*this, hw_);
+  }
+
+  // lightweight controllers share this node instead of creating a LifecycleNode each
+  declare_parameter("lightweight_controllers", false);
+
+  // allocations in update() are tracked if the allocation hooks are preloaded, the mode can be
+  // changed at runtime
+  const auto rt_allocation_check = declare_parameter("rt_allocation_check", std::string("off"));
+  try {
+    rt_allocation_check_ = allocation_tracker::parse_mode(rt_allocation_check);
+  } catch (const std::invalid_argument & e) {
+    RCLCPP_WARN(get_logger(), "%s, allocations are not tracked", e.what());
+    rt_allocation_check_ = allocation_tracker::Mode::OFF;
+  }
+  // update() and the controllers are traced while set, see the write_trace service
+  hardware_interface::tracing::set_enabled(declare_parameter("enable_tracing", false));
+  // read-only, so that clients of the write_trace service cannot write anywhere else
+  rcl_interfaces::msg::ParameterDescriptor trace_directory_descriptor;
+  trace_directory_descriptor.read_only = true;
+  trace_directory_ =
+    declare_parameter("trace_directory", std::string("."), trace_directory_descriptor);
+  parameters_callback_handle_ = add_on_set_parameters_callback(
+    [this](const std::vector<rclcpp::Parameter> & parameters) {
+      rcl_interfaces::msg::SetParametersResult result;
+      result.successful = true;
+      for (const auto & parameter : parameters) {
+        if (parameter.get_name() == "enable_tracing") {
+          if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_BOOL) {
+            result.successful = false;
+            result.reason = "enable_tracing must be a bool";
+            continue;
+          }
+          hardware_interface::tracing::set_enabled(parameter.as_bool());
+          continue;
+        }
+        if (parameter.get_name() != "rt_allocation_check") {
+          continue;
+        }
+        try {
+          rt_allocation_check_ = allocation_tracker::parse_mode(parameter.as_string());
+        } catch (const std::exception & e) {
+          result.successful = false;
+          result.reason = e.what();
+        }
+      }
+      return result;
+    });
+  if (rt_allocation_check_ != allocation_tracker::Mode::OFF &&
+    !allocation_tracker::hooks_installed())
+  {
+    RCLCPP_WARN(
+      get_logger(), "Allocations in the realtime loop cannot be tracked, preload "
+      "libcontroller_manager_allocation_hooks.so to enable rt_allocation_check");
+  }
+  rt_allocation_report_timer_ = create_wall_timer(
+    std::chrono::seconds(1), std::bind(&ControllerManager::report_rt_allocations, this),
+    list_services_callback_group_);
+
+  // controller nodes are spun apart from the manager services by a dedicated executor, so that
+  // slow controller callbacks cannot delay service handling
+  const auto controller_executor_threads = declare_parameter("controller_executor_threads", 0);
+  if (controller_executor_threads > 0) {
+    controller_executor_ = std::make_shared<rclcpp::executors::MultiThreadedExecutor>(
+      rclcpp::ExecutorOptions(), static_cast<size_t>(controller_executor_threads));
+    controller_executor_thread_ = std::thread([this]() {controller_executor_->spin();});
+    RCLCPP_INFO(
+      get_logger(), "Spinning controller nodes with %d dedicated threads",
+      controller_executor_threads);
+  } else {
+    controller_executor_ = executor_;
+  }
+}
+
+ControllerManager::~ControllerManager()
+{
+  watchdog_.reset();
+  if (controller_executor_thread_.joinable()) {
+    controller_executor_->cancel();
+    controller_executor_thread_.join();
+  }
 }
 
 controller_interface::ControllerInterfaceSharedPtr ControllerManager::load_controller(
@@ -115,41 +440,154 @@ controller_interface::ControllerInterfaceSharedPtr ControllerManager::load_contr
 controller_interface::ControllerInterfaceSharedPtr ControllerManager::load_controller(
   const std::string & controller_name)
 {
-  const std::string param_name = controller_name + ".type";
   std::string controller_type;
+  if (!get_controller_type(controller_name, controller_type)) {
+    return nullptr;
+  }
+  return load_controller(controller_name, controller_type);
+}
 
-  // We cannot declare the parameters for the controllers that will be loaded in the future,
-  // because they are plugins and we cannot be aware of all of them.
-  // So when we're told to load a controller by name, we need to declare the parameter if
-  // we haven't done so, and then read it.
+std::vector<controller_interface::ControllerInterfaceSharedPtr>
+ControllerManager::load_controllers(
+  const std::vector<std::string> & controller_names,
+  size_t max_threads)
+{
+  std::vector<controller_interface::ControllerInterfaceSharedPtr> loaded_controllers(
+    controller_names.size());
+  std::vector<ControllerSpec> controller_specs(controller_names.size());
+
+  // Resolve the types on this thread, parameters are declared on the fly
+  const auto already_loaded = get_controller_names();
+  size_t controllers_to_load = 0;
+  for (size_t i = 0; i < controller_names.size(); ++i) {
+    const auto & controller_name = controller_names[i];
+    RCLCPP_INFO(get_logger(), "Loading controller '%s'", controller_name.c_str());
+    if (std::find(already_loaded.begin(), already_loaded.end(), controller_name) !=
+      already_loaded.end() ||
+      std::find(controller_names.begin(), controller_names.begin() + i, controller_name) !=
+      controller_names.begin() + i)
+    {
+      RCLCPP_ERROR(
+        get_logger(),
+        "A controller named '%s' was already loaded inside the controller manager",
+        controller_name.c_str());
+      continue;
+    }
+    std::string controller_type;
+    if (!get_controller_type(controller_name, controller_type)) {
+      continue;
+    }
+    if (!loader_->isClassAvailable(controller_type)) {
+      RCLCPP_ERROR(get_logger(), "Loader for controller '%s' not found", controller_name.c_str());
+      continue;
+    }
+    controller_specs[i].info.name = controller_name;
+    controller_specs[i].info.type = controller_type;
+    ++controllers_to_load;
+  }
+  if (controllers_to_load == 0) {
+    return loaded_controllers;
+  }
 
-  // Check if parameter has been declared
-  if (!has_parameter(param_name)) {
-    declare_parameter(param_name, rclcpp::ParameterValue());
+  // pluginlib's loader bookkeeping is not thread safe and dlopen is serialized anyway,
+  // the expensive part running concurrently is creating and configuring the nodes
+  std::mutex loader_mutex;
+  std::atomic<size_t> next_controller{0};
+  auto load_worker = [&]()
+    {
+      for (size_t i = next_controller++; i < controller_specs.size(); i = next_controller++) {
+        auto & controller_spec = controller_specs[i];
+        if (controller_spec.info.type.empty()) {
+          continue;
+        }
+        try {
+          controller_interface::ControllerInterfaceSharedPtr controller;
+          {
+            std::lock_guard<std::mutex> guard(loader_mutex);
+            controller = loader_->createSharedInstance(controller_spec.info.type);
+          }
+          if (init_controller(*controller, controller_spec.info.name) !=
+            controller_interface::return_type::SUCCESS)
+          {
+            RCLCPP_ERROR(
+              get_logger(), "Could not initialize controller '%s'",
+              controller_spec.info.name.c_str());
+            continue;
+          }
+          controller->configure();
+          controller_spec.c = controller;
+        } catch (const std::exception & e) {
+          RCLCPP_ERROR(
+            get_logger(), "Could not load controller '%s': %s",
+            controller_spec.info.name.c_str(), e.what());
+        }
+      }
+    };
+
+  if (max_threads == 0) {
+    max_threads = std::max(1u, std::thread::hardware_concurrency());
   }
-  if (!get_parameter(param_name, controller_type)) {
-    RCLCPP_ERROR(get_logger(), "'type' param not defined for %s", controller_name.c_str());
-    return nullptr;
+  std::vector<std::thread> loader_threads;
+  for (size_t i = 1; i < std::min(max_threads, controllers_to_load); ++i) {
+    loader_threads.emplace_back(load_worker);
   }
-  return load_controller(controller_name, controller_type);
+  load_worker();
+  for (auto & loader_thread : loader_threads) {
+    loader_thread.join();
+  }
+
+  RTControllerListWrapper::Transaction transaction(rt_controllers_wrapper_);
+  for (size_t i = 0; i < controller_specs.size(); ++i) {
+    auto & controller_spec = controller_specs[i];
+    if (!controller_spec.c) {
+      continue;
+    }
+    // A controller with the same name may have been added while loading
+    if (transaction.find(controller_spec.info.name) != nullptr) {
+      RCLCPP_ERROR(
+        get_logger(),
+        "A controller named '%s' was already loaded inside the controller manager",
+        controller_spec.info.name.c_str());
+      controller_spec.c->cleanup();
+      continue;
+    }
+    add_controller_to_executor(*controller_spec.c);
+    set_watchdog_deadline(controller_spec);
+    set_claimed_resources(controller_spec);
+    transaction.add(controller_spec);
+    if (!transaction.order_chained_controllers()) {
+      RCLCPP_ERROR(
+        get_logger(),
+        "Could not add controller '%s' since it is chained to other controllers in a cycle",
+        controller_spec.info.name.c_str());
+      transaction.remove(controller_spec.info.name);
+      remove_controller_from_executor(*controller_spec.c);
+      controller_spec.c->cleanup();
+      continue;
+    }
+    loaded_controllers[i] = controller_spec.c;
+  }
+
+  // Destroys the old controllers list when the realtime thread is finished with it.
+  RCLCPP_DEBUG(get_logger(), "Realtime switches over to new controller list");
+  transaction.commit();
+
+  for (const auto & controller : loaded_controllers) {
+    if (controller) {
+      publish_lifecycle_event(controller_manager_msgs::msg::ControllerEvent::LOADED, *controller);
+    }
+  }
+  return loaded_controllers;
 }
 
 controller_interface::return_type ControllerManager::unload_controller(
   const std::string & controller_name)
 {
-  std::lock_guard<std::recursive_mutex> guard(rt_controllers_wrapper_.controllers_lock_);
-  std::vector<ControllerSpec> & to = rt_controllers_wrapper_.get_unused_list(guard);
-  const std::vector<ControllerSpec> & from = rt_controllers_wrapper_.get_updated_list(guard);
-
-  // Transfers the running controllers over, skipping the one to be removed and the running ones.
-  to = from;
+  RTControllerListWrapper::Transaction transaction(rt_controllers_wrapper_);
 
-  auto found_it = std::find_if(
-    to.begin(), to.end(),
-    std::bind(controller_name_compare, std::placeholders::_1, controller_name));
-  if (found_it == to.end()) {
+  auto controller = transaction.find(controller_name);
+  if (controller == nullptr) {
     // Fails if we could not remove the controllers
-    to.clear();
     RCLCPP_ERROR(
       get_logger(),
       "Could not unload controller with name '%s' because no controller with this name exists",
@@ -157,10 +595,7 @@ controller_interface::return_type ControllerManager::unload_controller(
     return controller_interface::return_type::ERROR;
   }
 
-  auto & controller = *found_it;
-
-  if (is_controller_running(*controller.c)) {
-    to.clear();
+  if (is_controller_running(*controller->c)) {
     RCLCPP_ERROR(
       get_logger(),
       "Could not unload controller with name '%s' because it is still running",
@@ -169,18 +604,17 @@ controller_interface::return_type ControllerManager::unload_controller(
   }
 
   RCLCPP_DEBUG(get_logger(), "Cleanup controller");
-  controller.c->get_lifecycle_node()->cleanup();
-  executor_->remove_node(controller.c->get_lifecycle_node()->get_node_base_interface());
-  to.erase(found_it);
+  auto unloaded_controller = controller->c;
+  unloaded_controller->cleanup();
+  remove_controller_from_executor(*unloaded_controller);
+  transaction.remove(controller_name);
 
   // Destroys the old controllers list when the realtime thread is finished with it.
   RCLCPP_DEBUG(get_logger(), "Realtime switches over to new controller list");
-  rt_controllers_wrapper_.switch_updated_list(guard);
-  std::vector<ControllerSpec> & new_unused_list = rt_controllers_wrapper_.get_unused_list(
-    guard);
-  RCLCPP_DEBUG(get_logger(), "Destruct controller");
-  new_unused_list.clear();
-  RCLCPP_DEBUG(get_logger(), "Destruct controller finished");
+  transaction.commit();
+
+  publish_lifecycle_event(
+    controller_manager_msgs::msg::ControllerEvent::UNLOADED, *unloaded_controller);
 
   RCLCPP_DEBUG(get_logger(), "Successfully unloaded controller '%s'", controller_name.c_str());
   return controller_interface::return_type::SUCCESS;
@@ -198,6 +632,64 @@ controller_interface::return_type ControllerManager::switch_controller(
   int strictness,
   bool start_asap,
   const rclcpp::Duration & timeout)
+{
+  using controller_manager_msgs::msg::ControllerEvent;
+
+  const auto switch_start = std::chrono::system_clock::now();
+  const auto ret = switch_controller_impl(
+    start_controllers, stop_controllers, strictness, start_asap, timeout);
+  const auto switch_end = std::chrono::system_clock::now();
+
+  // the records were filled in by the realtime loop, which is done with them by now
+  for (const auto & record : transition_records_) {
+    if (!record.performed) {
+      continue;
+    }
+    ControllerEvent event;
+    event.stamp = to_ros_time(record.end);
+    if (record.state_id != record.goal_state_id) {
+      event.type = ControllerEvent::TRANSITION_FAILED;
+    } else if (record.goal_state_id == lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE) {
+      event.type = ControllerEvent::ACTIVATED;
+    } else {
+      event.type = ControllerEvent::DEACTIVATED;
+    }
+    event.controller = record.controller;
+    event.state = primary_state_label(record.state_id);
+    event.duration = rclcpp::Duration(record.end - record.start);
+    publish_controller_event(std::move(event));
+  }
+  transition_records_.clear();
+
+  ControllerEvent event;
+  event.stamp = to_ros_time(switch_end);
+  event.start_controllers = start_controllers;
+  event.stop_controllers = stop_controllers;
+  event.duration = rclcpp::Duration(switch_end - switch_start);
+  if (ret == controller_interface::return_type::SUCCESS) {
+    event.type = ControllerEvent::SWITCH_SUCCEEDED;
+  } else {
+    event.type = ControllerEvent::SWITCH_FAILED;
+    if (switch_params_.hardware_switch_failed) {
+      event.message =
+        "Hardware failed to switch command modes, the stopped controllers were restarted";
+    } else if (switch_params_.aborted) {
+      event.message = "Switch aborted by the reaction to an overrun";
+    } else {
+      event.message = "Switch rejected, see the controller manager log for details";
+    }
+  }
+  publish_controller_event(std::move(event));
+
+  return ret;
+}
+
+controller_interface::return_type ControllerManager::switch_controller_impl(
+  const std::vector<std::string> & start_controllers,
+  const std::vector<std::string> & stop_controllers,
+  int strictness,
+  bool start_asap,
+  const rclcpp::Duration & timeout)
 {
   switch_params_ = SwitchParams();
 
@@ -286,12 +778,8 @@ controller_interface::return_type ControllerManager::switch_controller(
     return ret;
   }
 
-#ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
-  // Do the resource management checking
-  std::list<hardware_interface::ControllerInfo> info_list;
   switch_start_list_.clear();
   switch_stop_list_.clear();
-#endif
 
   // lock controllers
   std::lock_guard<std::recursive_mutex> guard(rt_controllers_wrapper_.controllers_lock_);
@@ -299,6 +787,12 @@ controller_interface::return_type ControllerManager::switch_controller(
   const std::vector<ControllerSpec> & controllers =
     rt_controllers_wrapper_.get_updated_list(guard);
 
+  // Do the resource management checking, collecting the interface slots claimed by all
+  // controllers that will be running after the switch
+  std::vector<std::uint64_t> claimed_slots;
+  std::vector<std::string> conflicting_controllers;
+  std::vector<std::string> running_after_switch;
+
   for (const auto & controller : controllers) {
     auto stop_list_it = std::find(
       stop_request_.begin(), stop_request_.end(), controller.info.name);
@@ -348,11 +842,13 @@ controller_interface::return_type ControllerManager::switch_controller(
       start_request_.erase(start_list_it);
     }
 
-#ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
+    const auto & claimed_resources = controller.info.claimed_resources;
     if (is_running && in_stop_list && !in_start_list) {  // running and real stop
-      switch_stop_list_.push_back(info);
+      switch_stop_list_.insert(
+        switch_stop_list_.end(), claimed_resources.begin(), claimed_resources.end());
     } else if (!is_running && !in_stop_list && in_start_list) {  // start, but no restart
-      switch_start_list_.push_back(info);
+      switch_start_list_.insert(
+        switch_start_list_.end(), claimed_resources.begin(), claimed_resources.end());
     }
 
     bool add_to_list = is_running;
@@ -364,21 +860,85 @@ controller_interface::return_type ControllerManager::switch_controller(
     }
 
     if (add_to_list) {
-      info_list.push_back(info);
+      running_after_switch.push_back(controller.info.name);
+      const auto & controller_slots = controller.claimed_slots;
+      if (claimed_slots.size() < controller_slots.size()) {
+        claimed_slots.resize(controller_slots.size(), 0u);
+      }
+      bool in_conflict = false;
+      for (size_t word = 0; word < controller_slots.size(); ++word) {
+        in_conflict = in_conflict || (claimed_slots[word] & controller_slots[word]) != 0u;
+        claimed_slots[word] |= controller_slots[word];
+      }
+      if (in_conflict) {
+        conflicting_controllers.push_back(controller.info.name);
+      }
     }
-#endif
   }
 
-#ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
-  bool in_conflict = robot_hw_->checkForConflict(info_list);
-  if (in_conflict) {
+  if (!conflicting_controllers.empty()) {
+    for (const auto & controller_name : conflicting_controllers) {
+      RCLCPP_ERROR(
+        get_logger(),
+        "Controller '%s' claims resources already claimed by another running controller",
+        controller_name.c_str());
+    }
     RCLCPP_ERROR(get_logger(), "Could not switch controllers, due to resource conflict");
     stop_request_.clear();
     start_request_.clear();
     return controller_interface::return_type::ERROR;
   }
 
-  if (!robot_hw_->prepareSwitch(switch_start_list_, switch_stop_list_)) {
+  // Chained controllers write the reference interfaces of controllers updated after them in
+  // the same cycle, which therefore have to be running as well
+  for (const auto & controller : controllers) {
+    if (std::find(running_after_switch.begin(), running_after_switch.end(), controller.info.name) ==
+      running_after_switch.end())
+    {
+      continue;
+    }
+    for (const auto & chained_controller : controller.chained_controllers) {
+      if (std::find(running_after_switch.begin(), running_after_switch.end(), chained_controller) ==
+        running_after_switch.end())
+      {
+        RCLCPP_ERROR(
+          get_logger(),
+          "Could not switch controllers, controller '%s' writes reference interfaces of "
+          "controller '%s' which would not be running",
+          controller.info.name.c_str(), chained_controller.c_str());
+        stop_request_.clear();
+        start_request_.clear();
+        return controller_interface::return_type::ERROR;
+      }
+    }
+    const bool is_started = std::find(
+      start_request_.begin(), start_request_.end(), controller.info.name) != start_request_.end();
+    if (is_started && !connect_reference_interfaces(controller, controllers)) {
+      RCLCPP_ERROR(get_logger(), "Could not switch controllers, due to missing references");
+      stop_request_.clear();
+      start_request_.clear();
+      return controller_interface::return_type::ERROR;
+    }
+  }
+
+  if (start_request_.empty() && stop_request_.empty()) {
+    RCLCPP_INFO(get_logger(), "Empty start and stop list, not requesting switch");
+    return controller_interface::return_type::SUCCESS;
+  }
+
+  // a reaction to an overrun prepares the hardware too, it either comes before this switch is
+  // prepared, or after the switch is handed to the realtime loop and then aborts it
+  std::unique_lock<std::mutex> command_mode_guard(command_mode_switch_lock_);
+  if (overrun_reaction_state_.load(std::memory_order_acquire) != OverrunReactionState::IDLE) {
+    RCLCPP_ERROR(get_logger(), "Could not switch controllers while reacting to an overrun");
+    stop_request_.clear();
+    start_request_.clear();
+    return controller_interface::return_type::ERROR;
+  }
+
+  if (hw_->prepare_command_mode_switch(switch_start_list_, switch_stop_list_) !=
+    hardware_interface::return_type::OK)
+  {
     RCLCPP_ERROR(
       get_logger(),
       "Could not switch controllers. The hardware interface combination "
@@ -387,31 +947,71 @@ controller_interface::return_type ControllerManager::switch_controller(
     start_request_.clear();
     return controller_interface::return_type::ERROR;
   }
-#endif
 
-  if (start_request_.empty() && stop_request_.empty()) {
-    RCLCPP_INFO(get_logger(), "Empty start and stop list, not requesting switch");
-    return controller_interface::return_type::SUCCESS;
+  // the realtime loop only fills in these records, one per stop request followed by one per
+  // start request
+  transition_records_.clear();
+  transition_records_.reserve(stop_request_.size() + start_request_.size());
+  for (const auto & request : stop_request_) {
+    TransitionRecord record;
+    record.controller = request;
+    record.goal_state_id = lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE;
+    transition_records_.push_back(record);
+  }
+  for (const auto & request : start_request_) {
+    TransitionRecord record;
+    record.controller = request;
+    record.goal_state_id = lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE;
+    transition_records_.push_back(record);
+  }
+
+  // when stepping, the switch parameters are only ever touched between two cycles of step(),
+  // which may run on another thread
+  std::unique_lock<std::mutex> step_guard(step_lock_, std::defer_lock);
+  if (stepping_) {
+    step_guard.lock();
   }
 
   // start the atomic controller switching
   switch_params_.strictness = strictness;
   switch_params_.start_asap = start_asap;
-  switch_params_.init_time = rclcpp::Clock().now();
+  switch_params_.init_time = now();
   switch_params_.timeout = timeout;
-  switch_params_.do_switch = true;
 
-  // wait until switch is finished
-  RCLCPP_DEBUG(get_logger(), "Request atomic controller switch from realtime loop");
-  while (rclcpp::ok() && switch_params_.do_switch) {
-    if (!rclcpp::ok()) {
-      return controller_interface::return_type::ERROR;
+  if (stepping_) {
+    // switch right away as it would in the next cycle, do_switch is never raised so update()
+    // does not switch a second time
+    RCLCPP_DEBUG(get_logger(), "Performing controller switch synchronously");
+    override_clocks(simulated_time_);
+    manage_switch();
+    rt_controllers_wrapper_.release_used_by_rt_list();
+    switch_params_.do_switch = false;
+    step_guard.unlock();
+    command_mode_guard.unlock();
+  } else {
+    switch_params_.do_switch = true;
+    command_mode_guard.unlock();
+
+    // wait until switch is finished
+    RCLCPP_DEBUG(get_logger(), "Request atomic controller switch from realtime loop");
+    while (rclcpp::ok() && switch_params_.do_switch) {
+      if (!rclcpp::ok()) {
+        return controller_interface::return_type::ERROR;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
-    std::this_thread::sleep_for(std::chrono::microseconds(100));
   }
   start_request_.clear();
   stop_request_.clear();
 
+  if (switch_params_.hardware_switch_failed) {
+    return controller_interface::return_type::ERROR;
+  }
+  if (switch_params_.aborted) {
+    RCLCPP_ERROR(get_logger(), "Controller switch aborted by the reaction to an overrun");
+    return controller_interface::return_type::ERROR;
+  }
+
   RCLCPP_DEBUG(get_logger(), "Successfully switched controllers");
   return controller_interface::return_type::SUCCESS;
 }
@@ -420,21 +1020,10 @@ controller_interface::ControllerInterfaceSharedPtr
 ControllerManager::add_controller_impl(
   const ControllerSpec & controller)
 {
-  // lock controllers
-  std::lock_guard<std::recursive_mutex> guard(rt_controllers_wrapper_.controllers_lock_);
-
-  std::vector<ControllerSpec> & to = rt_controllers_wrapper_.get_unused_list(guard);
-  const std::vector<ControllerSpec> & from = rt_controllers_wrapper_.get_updated_list(guard);
+  RTControllerListWrapper::Transaction transaction(rt_controllers_wrapper_);
 
-  // Copy all controllers from the 'from' list to the 'to' list
-  to = from;
-
-  auto found_it = std::find_if(
-    to.begin(), to.end(),
-    std::bind(controller_name_compare, std::placeholders::_1, controller.info.name));
   // Checks that we're not duplicating controllers
-  if (found_it != to.end()) {
-    to.clear();
+  if (transaction.find(controller.info.name) != nullptr) {
     RCLCPP_ERROR(
       get_logger(),
       "A controller named '%s' was already loaded inside the controller manager",
@@ -442,39 +1031,59 @@ ControllerManager::add_controller_impl(
     return nullptr;
   }
 
-  controller.c->init(hw_, controller.info.name);
+  init_controller(*controller.c, controller.info.name);
 
   // TODO(v-lopez) this should only be done if controller_manager is configured.
   // Probably the whole load_controller part should fail if the controller_manager
   // is not configured, should it implement a LifecycleNodeInterface
   // https://github.com/ros-controls/ros2_control/issues/152
-  controller.c->get_lifecycle_node()->configure();
-  executor_->add_node(controller.c->get_lifecycle_node()->get_node_base_interface());
-  to.emplace_back(controller);
+  controller.c->configure();
+  add_controller_to_executor(*controller.c);
+  ControllerSpec controller_spec = controller;
+  set_watchdog_deadline(controller_spec);
+  set_claimed_resources(controller_spec);
+  transaction.add(controller_spec);
+  if (!transaction.order_chained_controllers()) {
+    RCLCPP_ERROR(
+      get_logger(),
+      "Could not add controller '%s' since it is chained to other controllers in a cycle",
+      controller.info.name.c_str());
+    remove_controller_from_executor(*controller.c);
+    controller.c->cleanup();
+    return nullptr;
+  }
 
   // Destroys the old controllers list when the realtime thread is finished with it.
   RCLCPP_DEBUG(get_logger(), "Realtime switches over to new controller list");
-  rt_controllers_wrapper_.switch_updated_list(guard);
-  RCLCPP_DEBUG(get_logger(), "Destruct controller");
-  std::vector<ControllerSpec> & new_unused_list = rt_controllers_wrapper_.get_unused_list(
-    guard);
-  new_unused_list.clear();
-  RCLCPP_DEBUG(get_logger(), "Destruct controller finished");
+  transaction.commit();
 
-  return to.back().c;
+  publish_lifecycle_event(controller_manager_msgs::msg::ControllerEvent::LOADED, *controller.c);
+  return controller.c;
 }
 
 void ControllerManager::manage_switch()
 {
-#ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
-  // switch hardware interfaces (if any)
+  hardware_interface::tracing::Scope trace_scope("manage_switch", "controller_manager");
+  stop_controllers();
+
+  // switch hardware command modes (if any) in the same cycle, between stopping and starting
   if (!switch_params_.started) {
-    robot_hw_->doSwitch(switch_start_list_, switch_stop_list_);
     switch_params_.started = true;
+    hardware_interface::tracing::Scope hardware_trace_scope(
+      "perform_command_mode_switch", "hardware");
+    if (hw_->perform_command_mode_switch(switch_start_list_, switch_stop_list_) !=
+      hardware_interface::return_type::OK)
+    {
+      RCLCPP_ERROR(
+        get_logger(),
+        "Hardware failed to switch command modes, restarting the stopped controllers instead of "
+        "starting the requested ones");
+      switch_params_.hardware_switch_failed = true;
+      restart_stopped_controllers();
+      switch_params_.do_switch = false;
+      return;
+    }
   }
-#endif
-
-  stop_controllers();
 
   // start controllers once the switch is fully complete
   if (!switch_params_.start_asap) {
@@ -490,7 +1099,8 @@ void ControllerManager::stop_controllers()
   std::vector<ControllerSpec> & rt_controller_list =
     rt_controllers_wrapper_.update_and_get_used_by_rt_list();
   // stop controllers
-  for (const auto & request : stop_request_) {
+  for (size_t i = 0; i < stop_request_.size(); ++i) {
+    const auto & request = stop_request_[i];
     auto found_it = std::find_if(
       rt_controller_list.begin(), rt_controller_list.end(),
       std::bind(controller_name_compare, std::placeholders::_1, request));
@@ -503,7 +1113,16 @@ void ControllerManager::stop_controllers()
     }
     auto controller = found_it->c;
     if (is_controller_running(*controller)) {
-      const auto new_state = controller->get_lifecycle_node()->deactivate();
+      const auto transition_start = std::chrono::system_clock::now();
+      const auto & new_state = controller->deactivate();
+      ++rt_controllers_wrapper_.generation_;
+      if (i < transition_records_.size()) {
+        auto & record = transition_records_[i];
+        record.performed = true;
+        record.state_id = new_state.id();
+        record.start = transition_start;
+        record.end = std::chrono::system_clock::now();
+      }
       if (new_state.id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE) {
         RCLCPP_ERROR(
           get_logger(),
@@ -515,6 +1134,37 @@ void ControllerManager::stop_controllers()
   }
 }
 
+void ControllerManager::restart_stopped_controllers()
+{
+  std::vector<ControllerSpec> & rt_controller_list =
+    rt_controllers_wrapper_.update_and_get_used_by_rt_list();
+  // every stop request was running when the switch was validated
+  for (size_t i = 0; i < stop_request_.size(); ++i) {
+    const auto & request = stop_request_[i];
+    auto found_it = std::find_if(
+      rt_controller_list.begin(), rt_controller_list.end(),
+      std::bind(controller_name_compare, std::placeholders::_1, request));
+    if (found_it == rt_controller_list.end() || is_controller_running(*found_it->c)) {
+      continue;
+    }
+    const auto & new_state = found_it->c->activate();
+    ++rt_controllers_wrapper_.generation_;
+    if (i < transition_records_.size()) {
+      // reported as a failed stop, in the state it ended up in
+      auto & record = transition_records_[i];
+      record.state_id = new_state.id();
+      record.end = std::chrono::system_clock::now();
+    }
+    if (new_state.id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE) {
+      RCLCPP_ERROR(
+        get_logger(),
+        "After restarting, controller %s is in state %s, expected Active",
+        request.c_str(),
+        new_state.label().c_str());
+    }
+  }
+}
+
 void ControllerManager::start_controllers()
 {
 #ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
@@ -546,7 +1196,8 @@ void ControllerManager::start_controllers()
   //  Dummy implementation, replace with the code above when migrated
   std::vector<ControllerSpec> & rt_controller_list =
     rt_controllers_wrapper_.update_and_get_used_by_rt_list();
-  for (const auto & request : start_request_) {
+  for (size_t i = 0; i < start_request_.size(); ++i) {
+    const auto & request = start_request_[i];
     auto found_it = std::find_if(
       rt_controller_list.begin(), rt_controller_list.end(),
       std::bind(controller_name_compare, std::placeholders::_1, request));
@@ -558,12 +1209,22 @@ void ControllerManager::start_controllers()
       continue;
     }
     auto controller = found_it->c;
-    const auto new_state = controller->get_lifecycle_node()->activate();
+    const auto transition_start = std::chrono::system_clock::now();
+    const auto & new_state = controller->activate();
+    ++rt_controllers_wrapper_.generation_;
+    const size_t record_index = stop_request_.size() + i;
+    if (record_index < transition_records_.size()) {
+      auto & record = transition_records_[record_index];
+      record.performed = true;
+      record.state_id = new_state.id();
+      record.start = transition_start;
+      record.end = std::chrono::system_clock::now();
+    }
     if (new_state.id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE) {
       RCLCPP_ERROR(
         get_logger(),
         "After activating, controller %s is in state %s, expected Active",
-        controller->get_lifecycle_node()->get_name(),
+        controller->get_name().c_str(),
         new_state.label().c_str());
     }
   }
@@ -619,40 +1280,57 @@ void ControllerManager::start_controllers_asap()
 }
 
 void ControllerManager::list_controllers_srv_cb(
-  const std::shared_ptr<controller_manager_msgs::srv::ListControllers::Request>,
+  const std::shared_ptr<controller_manager_msgs::srv::ListControllers::Request> request,
   std::shared_ptr<controller_manager_msgs::srv::ListControllers::Response> response)
 {
-  // lock services
+  // neither the services nor the controllers are locked, listing never waits for a switch
   RCLCPP_DEBUG(get_logger(), "list controller service called");
-  std::lock_guard<std::mutex> services_guard(services_lock_);
-  RCLCPP_DEBUG(get_logger(), "list controller service locked");
 
-  // lock controllers
-  std::lock_guard<std::recursive_mutex> guard(rt_controllers_wrapper_.controllers_lock_);
-  const std::vector<ControllerSpec> & controllers =
-    rt_controllers_wrapper_.get_updated_list(guard);
-  response->controller.resize(controllers.size());
+  response->generation = rt_controllers_wrapper_.generation_;
+  if (request->known_generation == response->generation) {
+    response->unchanged = true;
+    RCLCPP_DEBUG(get_logger(), "list controller service finished, nothing changed");
+    return;
+  }
 
-  for (size_t i = 0; i < controllers.size(); ++i) {
-    controller_manager_msgs::msg::ControllerState & cs = response->controller[i];
-    cs.name = controllers[i].info.name;
-    cs.type = controllers[i].info.type;
-    cs.state = controllers[i].c->get_lifecycle_node()->get_current_state().label();
+  std::lock_guard<std::mutex> cache_guard(list_controllers_cache_lock_);
+  if (list_controllers_cache_generation_ != response->generation) {
+    // a change during the rebuild only leaves the cache older than its contents
+    const auto controllers = rt_controllers_wrapper_.get_snapshot();
+    list_controllers_cache_.resize(controllers->size());
+    size_t listed = 0;
+    for (const auto & controller : *controllers) {
+      const auto controller_interface = controller.c.lock();
+      if (!controller_interface) {
+        continue;  // unloaded since the snapshot was taken
+      }
+      controller_manager_msgs::msg::ControllerState & cs = list_controllers_cache_[listed++];
+      cs.name = controller.info.name;
+      cs.type = controller.info.type;
+      cs.state = controller_interface->get_current_state().label();
+
+      cs.claimed_resources.clear();
+      for (const auto & c_resource : controller.info.claimed_resources) {
+        controller_manager_msgs::msg::HardwareInterfaceResources iface_res;
+        iface_res.hardware_interface = c_resource.hardware_interface;
+        iface_res.resources = c_resource.resources;
+        cs.claimed_resources.push_back(iface_res);
+      }
+    }
+    list_controllers_cache_.resize(listed);
+    list_controllers_cache_generation_ = response->generation;
+  }
 
-#ifdef TODO_IMPLEMENT_RESOURCE_CHECKING
-    cs.claimed_resources.clear();
-    typedef std::vector<hardware_interface::InterfaceResources> ClaimedResVec;
-    typedef ClaimedResVec::const_iterator ClaimedResIt;
-    const ClaimedResVec & c_resources = controllers[i].info.claimed_resources;
-    for (const auto & c_resource : c_resources) {
-      controller_manager_msgs::HardwareInterfaceResources iface_res;
-      iface_res.hardware_interface = c_resource.hardware_interface;
-      std::copy(
-        c_resource.resources.begin(), c_resource.resources.end(),
-        std::back_inserter(iface_res.resources));
-      cs.claimed_resources.push_back(iface_res);
+  const auto matches_any = [](const std::vector<std::string> & filter, const std::string & value)
+    {
+      return filter.empty() || std::find(filter.begin(), filter.end(), value) != filter.end();
+    };
+  for (const auto & cs : list_controllers_cache_) {
+    if (matches_any(request->states, cs.state) && matches_any(request->types, cs.type) &&
+      matches_glob_pattern(cs.name, request->name_pattern))
+    {
+      response->controller.push_back(cs);
     }
-#endif
   }
 
   RCLCPP_DEBUG(get_logger(), "list controller service finished");
@@ -677,6 +1355,74 @@ void ControllerManager::list_controller_types_srv_cb(
   RCLCPP_DEBUG(get_logger(), "list types service finished");
 }
 
+void ControllerManager::list_hardware_interfaces_srv_cb(
+  const std::shared_ptr<controller_manager_msgs::srv::ListHardwareInterfaces::Request>,
+  std::shared_ptr<controller_manager_msgs::srv::ListHardwareInterfaces::Response> response)
+{
+  // served from the snapshot without services_lock_, a pending switch does not delay it
+  RCLCPP_DEBUG(get_logger(), "list hardware interfaces service called");
+  control_msgs::msg::DynamicJointState joint_state;
+  control_msgs::msg::DynamicJointState actuator_state;
+  const auto stamp = hardware_state_snapshot_->get(joint_state, actuator_state);
+  response->stamp = rclcpp::Time(stamp);
+
+  const auto to_component_states = [](
+    const control_msgs::msg::DynamicJointState & state,
+    std::vector<controller_manager_msgs::msg::HardwareComponentState> & component_states)
+    {
+      component_states.resize(state.joint_names.size());
+      for (size_t i = 0; i < state.joint_names.size(); ++i) {
+        component_states[i].name = state.joint_names[i];
+        component_states[i].interface_names = state.interface_values[i].interface_names;
+        component_states[i].values = state.interface_values[i].values;
+      }
+    };
+  to_component_states(joint_state, response->joints);
+  to_component_states(actuator_state, response->actuators);
+
+  RCLCPP_DEBUG(get_logger(), "list hardware interfaces service finished");
+}
+
+void ControllerManager::write_trace_srv_cb(
+  const std::shared_ptr<controller_manager_msgs::srv::WriteTrace::Request> request,
+  std::shared_ptr<controller_manager_msgs::srv::WriteTrace::Response> response)
+{
+  RCLCPP_DEBUG(get_logger(), "write trace service called");
+  const auto & file_name = request->file_name;
+  if (file_name.empty() || file_name == "." || file_name == ".." ||
+    file_name.find_first_of("/\\") != std::string::npos)
+  {
+    response->ok = false;
+    response->message = "'" + file_name + "' is not a file name in the trace directory";
+    RCLCPP_ERROR(get_logger(), "%s", response->message.c_str());
+    return;
+  }
+  response->file_path = trace_directory_ + "/" + file_name;
+  std::ofstream file(response->file_path);
+  if (!file) {
+    response->ok = false;
+    response->message = "Could not open '" + response->file_path + "' for writing";
+    RCLCPP_ERROR(get_logger(), "%s", response->message.c_str());
+    return;
+  }
+  const auto result = hardware_interface::tracing::write_chrome_trace(file);
+  file.close();
+  response->events = result.events;
+  response->dropped_events = result.dropped_events;
+  response->ok = static_cast<bool>(file);
+  if (!response->ok) {
+    response->message = "Failed to write '" + response->file_path + "'";
+    RCLCPP_ERROR(get_logger(), "%s", response->message.c_str());
+    return;
+  }
+  if (result.dropped_events > 0) {
+    RCLCPP_WARN(
+      get_logger(), "%" PRIu64 " trace events were dropped, write the trace more often",
+      result.dropped_events);
+  }
+  RCLCPP_DEBUG(get_logger(), "write trace service finished");
+}
+
 void ControllerManager::load_controller_service_cb(
   const std::shared_ptr<controller_manager_msgs::srv::LoadController::Request> request,
   std::shared_ptr<controller_manager_msgs::srv::LoadController::Response> response)
@@ -693,6 +1439,27 @@ void ControllerManager::load_controller_service_cb(
     request->name.c_str());
 }
 
+void ControllerManager::load_controllers_service_cb(
+  const std::shared_ptr<controller_manager_msgs::srv::LoadControllers::Request> request,
+  std::shared_ptr<controller_manager_msgs::srv::LoadControllers::Response> response)
+{
+  // lock services
+  RCLCPP_DEBUG(
+    get_logger(), "loading service called for %zu controllers", request->names.size());
+  std::lock_guard<std::mutex> guard(services_lock_);
+  RCLCPP_DEBUG(get_logger(), "loading service locked");
+
+  const auto controllers = load_controllers(request->names);
+  response->ok = true;
+  response->loaded.resize(controllers.size());
+  for (size_t i = 0; i < controllers.size(); ++i) {
+    response->loaded[i] = static_cast<bool>(controllers[i]);
+    response->ok = response->ok && response->loaded[i];
+  }
+
+  RCLCPP_DEBUG(get_logger(), "loading service finished");
+}
+
 void ControllerManager::reload_controller_libraries_service_cb(
   const std::shared_ptr<controller_manager_msgs::srv::ReloadControllerLibraries::Request> request,
   std::shared_ptr<controller_manager_msgs::srv::ReloadControllerLibraries::Response> response)
@@ -739,14 +1506,34 @@ void ControllerManager::reload_controller_libraries_service_cb(
       response->ok = false;
       return;
     }
-    for (const auto & controller : loaded_controllers) {
-      if (unload_controller(controller) != controller_interface::return_type::SUCCESS) {
-        RCLCPP_ERROR(
-          get_logger(), "Controller manager: Cannot reload controller libraries because "
-          "failed to unload controller '%s'",
-          controller.c_str());
-        response->ok = false;
-        return;
+    {
+      // unload all controllers with a single handoff to the realtime thread
+      RTControllerListWrapper::Transaction transaction(rt_controllers_wrapper_);
+      for (const auto & controller : transaction.get_list()) {
+        if (is_controller_running(*controller.c)) {
+          RCLCPP_ERROR(
+            get_logger(), "Controller manager: Cannot reload controller libraries because "
+            "failed to unload controller '%s'",
+            controller.info.name.c_str());
+          response->ok = false;
+          return;
+        }
+      }
+      std::vector<controller_interface::ControllerInterfaceSharedPtr> unloaded_controllers;
+      for (const auto & controller_name : loaded_controllers) {
+        auto controller = transaction.find(controller_name);
+        if (controller == nullptr) {
+          continue;
+        }
+        controller->c->cleanup();
+        remove_controller_from_executor(*controller->c);
+        unloaded_controllers.push_back(controller->c);
+        transaction.remove(controller_name);
+      }
+      transaction.commit();
+      for (const auto & controller : unloaded_controllers) {
+        publish_lifecycle_event(
+          controller_manager_msgs::msg::ControllerEvent::UNLOADED, *controller);
       }
     }
     loaded_controllers = get_controller_names();
@@ -759,6 +1546,9 @@ void ControllerManager::reload_controller_libraries_service_cb(
   RCLCPP_INFO(
     get_logger(), "Controller manager: reloaded controller libraries for '%s'",
     kControllerInterfaceName);
+  if (preload_controller_libraries_) {
+    preload_controller_libraries();
+  }
 
   response->ok = true;
 
@@ -811,31 +1601,596 @@ std::vector<std::string> ControllerManager::get_controller_names()
   return names;
 }
 
+controller_interface::return_type ControllerManager::preload_controller_libraries()
+{
+  auto ret = controller_interface::return_type::SUCCESS;
+  std::set<std::string> library_paths;
+  for (const auto & controller_type : loader_->getDeclaredClasses()) {
+    // The first load has to go through pluginlib so the plugin factories get registered,
+    // the library then stays loaded as long as the loader is alive
+    try {
+      loader_->loadLibraryForClass(controller_type);
+      library_paths.insert(loader_->getClassLibraryPath(controller_type));
+    } catch (const pluginlib::PluginlibException & e) {
+      RCLCPP_ERROR(
+        get_logger(), "Could not preload library of controller type '%s': %s",
+        controller_type.c_str(), e.what());
+      ret = controller_interface::return_type::ERROR;
+    }
+  }
+
+  for (const auto & library_path : library_paths) {
+    const auto error = lock_library_pages(library_path);
+    if (!error.empty()) {
+      RCLCPP_WARN(
+        get_logger(), "Could not lock pages of controller library '%s' in memory: %s",
+        library_path.c_str(), error.c_str());
+    }
+  }
+
+  if (std::getenv("LD_BIND_NOW") == nullptr) {
+    RCLCPP_WARN(
+      get_logger(),
+      "Preloaded %zu controller libraries, but symbols are resolved lazily on first use. "
+      "Set LD_BIND_NOW=1 when starting the controller manager to resolve them on load.",
+      library_paths.size());
+  } else {
+    RCLCPP_INFO(get_logger(), "Preloaded %zu controller libraries", library_paths.size());
+  }
+  return ret;
+}
+
+void ControllerManager::set_claimed_resources(ControllerSpec & controller)
+{
+  controller.info.claimed_resources = controller.c->get_claimed_resources();
+  controller.claimed_reference_interfaces = controller.c->get_claimed_reference_interfaces();
+  // locks the registration, the handles are only taken when a controller claiming them is started
+  // since the storage is released when the controller is cleaned up
+  controller.c->export_reference_interfaces();
+
+  controller.chained_controllers.clear();
+  for (const auto & interface_resources : controller.claimed_reference_interfaces) {
+    for (const auto & resource : interface_resources.resources) {
+      const auto chained_controller = resource.substr(0, resource.find('/'));
+      if (std::find(
+          controller.chained_controllers.begin(), controller.chained_controllers.end(),
+          chained_controller) == controller.chained_controllers.end())
+      {
+        controller.chained_controllers.push_back(chained_controller);
+      }
+    }
+  }
+
+  // a reference interface cannot be written by two running controllers either, it takes an
+  // interface slot just like a hardware resource
+  controller.claimed_slots.clear();
+  for (const auto * claimed : {
+      &controller.info.claimed_resources, &controller.claimed_reference_interfaces})
+  {
+    for (const auto & interface_resources : *claimed) {
+      for (const auto & resource : interface_resources.resources) {
+        // slots are assigned on first claim, so the bitsets only grow with the claimed resources
+        const auto slot_key = resource + "/" + interface_resources.hardware_interface;
+        const auto slot = resource_slots_.emplace(slot_key, resource_slots_.size()).first->second;
+        const size_t word = slot / 64;
+        if (controller.claimed_slots.size() <= word) {
+          controller.claimed_slots.resize(word + 1, 0u);
+        }
+        controller.claimed_slots[word] |= std::uint64_t{1} << (slot % 64);
+      }
+    }
+  }
+}
+
+void ControllerManager::set_watchdog_deadline(ControllerSpec & controller)
+{
+  if (!watchdog_) {
+    return;
+  }
+  controller.watchdog_id = watchdog_->register_controller(controller.info.name);
+  controller.watchdog_deadline = controller_deadline_;
+
+  const std::string param_name = controller.info.name + ".watchdog_deadline";
+  if (!has_parameter(param_name)) {
+    declare_parameter(param_name, rclcpp::ParameterValue());
+  }
+  double deadline = 0.0;
+  try {
+    if (get_parameter(param_name, deadline)) {
+      controller.watchdog_deadline = to_deadline(deadline);
+    }
+  } catch (const rclcpp::ParameterTypeException & e) {
+    RCLCPP_WARN(
+      get_logger(), "Ignoring '%s', the deadline must be given in seconds: %s",
+      param_name.c_str(), e.what());
+  }
+}
+
+controller_interface::return_type ControllerManager::init_controller(
+  controller_interface::ControllerInterface & controller, const std::string & controller_name)
+{
+  bool lightweight_controllers = false;
+  get_parameter("lightweight_controllers", lightweight_controllers);
+  if (lightweight_controllers) {
+    return controller.init(hw_, controller_name, create_sub_node(controller_name));
+  }
+  return controller.init(hw_, controller_name);
+}
+
+void ControllerManager::add_controller_to_executor(
+  controller_interface::ControllerInterface & controller)
+{
+  // lightweight controllers have no node of their own, their entities are spun with this node
+  if (controller.get_lifecycle_node()) {
+    controller_executor_->add_node(controller.get_lifecycle_node()->get_node_base_interface());
+  }
+}
+
+void ControllerManager::remove_controller_from_executor(
+  controller_interface::ControllerInterface & controller)
+{
+  if (controller.get_lifecycle_node()) {
+    controller_executor_->remove_node(controller.get_lifecycle_node()->get_node_base_interface());
+  }
+}
+
+void ControllerManager::publish_controller_event(
+  controller_manager_msgs::msg::ControllerEvent && event)
+{
+  std::lock_guard<std::mutex> guard(controller_event_lock_);
+  event.sequence = ++controller_event_sequence_;
+  controller_event_publisher_->publish(event);
+}
+
+void ControllerManager::report_rt_allocations()
+{
+  const std::uint64_t manager_allocations = rt_allocations_;
+  if (manager_allocations != reported_manager_rt_allocations_) {
+    RCLCPP_WARN(
+      get_logger(),
+      "The controller manager allocated memory %" PRIu64 " times in update(), %" PRIu64 " in total",
+      manager_allocations - reported_manager_rt_allocations_, manager_allocations);
+    reported_manager_rt_allocations_ = manager_allocations;
+  }
+
+  const std::uint64_t hardware_allocations = rt_hardware_allocations_;
+  if (hardware_allocations != reported_hardware_rt_allocations_) {
+    RCLCPP_WARN(
+      get_logger(),
+      "The hardware allocated memory %" PRIu64 " times in read() or write(), %" PRIu64 " in total",
+      hardware_allocations - reported_hardware_rt_allocations_, hardware_allocations);
+    reported_hardware_rt_allocations_ = hardware_allocations;
+  }
+
+  for (const auto & controller : *rt_controllers_wrapper_.get_snapshot()) {
+    const std::uint64_t allocations = *controller.rt_allocations;
+    auto & reported_allocations = reported_rt_allocations_[controller.info.name];
+    if (allocations < reported_allocations) {
+      // reloaded under the same name
+      reported_allocations = 0;
+    }
+    if (allocations != reported_allocations) {
+      RCLCPP_WARN(
+        get_logger(),
+        "Controller '%s' allocated memory %" PRIu64 " times in update(), %" PRIu64 " in total",
+        controller.info.name.c_str(), allocations - reported_allocations, allocations);
+      reported_allocations = allocations;
+    }
+  }
+}
+
+void ControllerManager::on_overrun(const Watchdog::Overrun & overrun)
+{
+  const auto to_ms = [](std::chrono::nanoseconds duration) {
+      return std::chrono::duration<double, std::milli>(duration).count();
+    };
+  if (overrun.phase == Watchdog::Phase::CONTROLLER) {
+    RCLCPP_ERROR(
+      get_logger(), "Controller '%s' has been updating for %.3f ms, past its deadline of %.3f ms",
+      overrun.controller.c_str(), to_ms(overrun.elapsed), to_ms(overrun.deadline));
+  } else {
+    RCLCPP_ERROR(
+      get_logger(), "The %s phase has been running for %.3f ms, past its deadline of %.3f ms",
+      Watchdog::phase_name(overrun.phase), to_ms(overrun.elapsed), to_ms(overrun.deadline));
+  }
+  if (watchdog_reaction_ != WatchdogReaction::LOG) {
+    overrun_reaction_pending_ = true;
+  }
+}
+
+void ControllerManager::react_to_overrun()
+{
+  // the previous reaction is still waiting for the realtime loop
+  if (overrun_reaction_state_.load(std::memory_order_acquire) != OverrunReactionState::IDLE ||
+    !overrun_reaction_pending_.exchange(false))
+  {
+    return;
+  }
+
+  auto & reaction = overrun_reaction_;
+  reaction.stop_controllers.clear();
+  reaction.start_controllers.clear();
+  reaction.stop_interfaces.clear();
+  reaction.start_interfaces.clear();
+  // the snapshot is read without taking the controllers lock, held by a switch in progress
+  for (const auto & entry : *rt_controllers_wrapper_.get_snapshot()) {
+    const auto controller = entry.c.lock();
+    if (!controller) {
+      continue;
+    }
+    const auto & claimed_resources = entry.info.claimed_resources;
+    const bool is_hold_controller = watchdog_reaction_ == WatchdogReaction::HOLD &&
+      entry.info.name == hold_controller_;
+    if (is_controller_running(*controller) && !is_hold_controller) {
+      reaction.stop_controllers.push_back(entry.info.name);
+      reaction.stop_interfaces.insert(
+        reaction.stop_interfaces.end(), claimed_resources.begin(), claimed_resources.end());
+    } else if (!is_controller_running(*controller) && is_hold_controller) {
+      reaction.start_controllers.push_back(entry.info.name);
+      reaction.start_interfaces.insert(
+        reaction.start_interfaces.end(), claimed_resources.begin(), claimed_resources.end());
+    }
+  }
+  if (reaction.start_controllers.empty() && reaction.stop_controllers.empty()) {
+    return;
+  }
+
+  // not interleaved with the preparation of a controller switch
+  std::lock_guard<std::mutex> command_mode_guard(command_mode_switch_lock_);
+  reaction.switch_command_modes = hw_->prepare_command_mode_switch(
+    reaction.start_interfaces, reaction.stop_interfaces) == hardware_interface::return_type::OK;
+  if (!reaction.switch_command_modes && !reaction.start_controllers.empty()) {
+    RCLCPP_ERROR(
+      get_logger(), "The hardware cannot switch to the hold controller '%s', stopping all "
+      "controllers instead", hold_controller_.c_str());
+    reaction.start_controllers.clear();
+    reaction.start_interfaces.clear();
+    reaction.switch_command_modes = hw_->prepare_command_mode_switch(
+      reaction.start_interfaces, reaction.stop_interfaces) == hardware_interface::return_type::OK;
+  }
+
+  if (!reaction.start_controllers.empty()) {
+    RCLCPP_WARN(
+      get_logger(), "Switching to the hold controller '%s' after an overrun",
+      hold_controller_.c_str());
+  } else {
+    RCLCPP_WARN(get_logger(), "Stopping all controllers after an overrun");
+  }
+  // performed by the realtime loop at the start of its next update(), without waiting for it
+  overrun_reaction_state_.store(OverrunReactionState::REQUESTED, std::memory_order_release);
+}
+
+void ControllerManager::perform_overrun_reaction(std::vector<ControllerSpec> & rt_controller_list)
+{
+  hardware_interface::tracing::Scope trace_scope("overrun_reaction", "controller_manager");
+  const auto find_controller = [&rt_controller_list](const std::string & name) {
+      return std::find_if(
+        rt_controller_list.begin(), rt_controller_list.end(),
+        std::bind(controller_name_compare, std::placeholders::_1, name));
+    };
+
+  for (const auto & name : overrun_reaction_.stop_controllers) {
+    const auto found_it = find_controller(name);
+    if (found_it != rt_controller_list.end() && is_controller_running(*found_it->c)) {
+      found_it->c->deactivate();
+      ++rt_controllers_wrapper_.generation_;
+    }
+  }
+
+  if (overrun_reaction_.switch_command_modes &&
+    hw_->perform_command_mode_switch(
+      overrun_reaction_.start_interfaces, overrun_reaction_.stop_interfaces) !=
+    hardware_interface::return_type::OK)
+  {
+    RCLCPP_ERROR(
+      get_logger(), "Hardware failed to switch command modes, not starting the hold controller");
+    return;
+  }
+
+  for (const auto & name : overrun_reaction_.start_controllers) {
+    const auto found_it = find_controller(name);
+    if (found_it != rt_controller_list.end() && !is_controller_running(*found_it->c)) {
+      found_it->c->activate();
+      ++rt_controllers_wrapper_.generation_;
+    }
+  }
+}
+
+void ControllerManager::publish_lifecycle_event(
+  std::uint8_t type, controller_interface::ControllerInterface & controller)
+{
+  controller_manager_msgs::msg::ControllerEvent event;
+  event.stamp = to_ros_time(std::chrono::system_clock::now());
+  event.type = type;
+  event.controller = controller.get_name();
+  event.state = controller.get_current_state().label();
+  publish_controller_event(std::move(event));
+}
+
+bool ControllerManager::connect_reference_interfaces(
+  const ControllerSpec & controller, const std::vector<ControllerSpec> & controllers)
+{
+  std::vector<hardware_interface::JointHandle> handles;
+  for (const auto & interface_resources : controller.claimed_reference_interfaces) {
+    for (const auto & resource : interface_resources.resources) {
+      const auto chained_it = std::find_if(
+        controllers.begin(), controllers.end(),
+        std::bind(controller_name_compare, std::placeholders::_1, resource.substr(
+          0, resource.find('/'))));
+      if (chained_it != controllers.end()) {
+        const auto exported = chained_it->c->export_reference_interfaces();
+        const auto handle_it = std::find_if(
+          exported.begin(), exported.end(),
+          [&](const hardware_interface::JointHandle & handle) {
+            return handle.get_name() == resource &&
+                   handle.get_interface_name() == interface_resources.hardware_interface;
+          });
+        if (handle_it != exported.end()) {
+          handles.push_back(*handle_it);
+          continue;
+        }
+      }
+      RCLCPP_ERROR(
+        get_logger(), "Controller '%s' claims reference interface %s/%s which is not exported",
+        controller.info.name.c_str(), resource.c_str(),
+        interface_resources.hardware_interface.c_str());
+      return false;
+    }
+  }
+  controller.c->assign_reference_interfaces(std::move(handles));
+  return true;
+}
+
+bool ControllerManager::get_controller_type(
+  const std::string & controller_name, std::string & controller_type)
+{
+  const std::string param_name = controller_name + ".type";
+
+  // We cannot declare the parameters for the controllers that will be loaded in the future,
+  // because they are plugins and we cannot be aware of all of them.
+  // So when we're told to load a controller by name, we need to declare the parameter if
+  // we haven't done so, and then read it.
+
+  // Check if parameter has been declared
+  if (!has_parameter(param_name)) {
+    declare_parameter(param_name, rclcpp::ParameterValue());
+  }
+  if (!get_parameter(param_name, controller_type)) {
+    RCLCPP_ERROR(get_logger(), "'type' param not defined for %s", controller_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+controller_interface::return_type
+ControllerManager::read()
+{
+  if (hardware_interface::tracing::is_enabled()) {
+    // allocates the trace buffer of this thread once, before allocations are tracked
+    hardware_interface::tracing::register_thread("controller_manager update");
+  }
+  hardware_interface::tracing::Scope trace_scope("read", "hardware");
+  if (watchdog_) {
+    watchdog_->begin_phase(Watchdog::Phase::READ, read_deadline_);
+  }
+  const auto allocation_check = begin_hardware_allocation_tracking();
+  const auto allocations_at_start = allocation_tracker::get_allocations();
+  const auto ret = hw_->read();
+  end_hardware_allocation_tracking(allocation_check, allocations_at_start);
+  if (watchdog_) {
+    watchdog_->end_phase();
+  }
+  return ret == hardware_interface::return_type::OK ?
+         controller_interface::return_type::SUCCESS : controller_interface::return_type::ERROR;
+}
+
 controller_interface::return_type
 ControllerManager::update()
 {
+  if (hardware_interface::tracing::is_enabled()) {
+    // allocates the trace buffer of this thread once, before allocations are tracked
+    hardware_interface::tracing::register_thread("controller_manager update");
+  }
+  hardware_interface::tracing::Scope trace_scope("update", "controller_manager");
+  if (watchdog_) {
+    watchdog_->begin_phase(Watchdog::Phase::UPDATE, update_deadline_);
+  }
+
   std::vector<ControllerSpec> & rt_controller_list =
     rt_controllers_wrapper_.update_and_get_used_by_rt_list();
 
+  // before the controllers update, so the first cycle after a stall already holds
+  if (overrun_reaction_state_.load(std::memory_order_acquire) ==
+    OverrunReactionState::REQUESTED)
+  {
+    perform_overrun_reaction(rt_controller_list);
+    // a switch requested before the overrun would restart the controllers just stopped
+    if (switch_params_.do_switch) {
+      switch_params_.aborted = true;
+      switch_params_.do_switch = false;
+    }
+    overrun_reaction_state_.store(OverrunReactionState::IDLE, std::memory_order_release);
+  }
+
+  const auto allocation_check = rt_allocation_check_.load(std::memory_order_relaxed);
+  const auto allocations_at_start = allocation_tracker::get_allocations();
+  std::uint64_t allocations_in_controllers = 0;
+  if (allocation_check != allocation_tracker::Mode::OFF) {
+    allocation_tracker::set_context("controller_manager");
+    allocation_tracker::set_mode(allocation_check);
+  }
+
+  hardware_state_snapshot_->update();
+  if (recorder_) {
+    recorder_->record(
+      now().nanoseconds());
+  }
+  if (dynamic_joint_state_publisher_) {
+    dynamic_joint_state_publisher_->update();
+  }
+
   auto ret = controller_interface::return_type::SUCCESS;
-  for (auto loaded_controller : rt_controller_list) {
+  for (auto & loaded_controller : rt_controller_list) {
     // TODO(v-lopez) we could cache this information
     // https://github.com/ros-controls/ros2_control/issues/153
     if (is_controller_running(*loaded_controller.c)) {
+      hardware_interface::tracing::Scope controller_trace_scope(
+        loaded_controller.info.name.c_str(), "controller");
+      const auto controller_allocations_at_start = allocation_tracker::get_allocations();
+      if (allocation_check != allocation_tracker::Mode::OFF) {
+        allocation_tracker::set_context(loaded_controller.info.name.c_str());
+      }
+      if (watchdog_) {
+        watchdog_->begin_controller(
+          loaded_controller.watchdog_id, loaded_controller.watchdog_deadline);
+      }
       auto controller_ret = loaded_controller.c->update();
+      if (watchdog_) {
+        watchdog_->end_controller();
+      }
       if (controller_ret != controller_interface::return_type::SUCCESS) {
         ret = controller_ret;
       }
+      if (allocation_check != allocation_tracker::Mode::OFF) {
+        const auto controller_allocations =
+          allocation_tracker::get_allocations() - controller_allocations_at_start;
+        *loaded_controller.rt_allocations += controller_allocations;
+        allocations_in_controllers += controller_allocations;
+        allocation_tracker::set_context("controller_manager");
+      }
     }
   }
 
+  if (allocation_check != allocation_tracker::Mode::OFF) {
+    rt_allocations_ +=
+      allocation_tracker::get_allocations() - allocations_at_start - allocations_in_controllers;
+    // switching controllers runs their lifecycle transitions, which are allowed to allocate
+    allocation_tracker::set_mode(allocation_tracker::Mode::OFF);
+  }
+
   // there are controllers to start/stop
   if (switch_params_.do_switch) {
     manage_switch();
   }
+  if (watchdog_) {
+    watchdog_->end_phase();
+  }
   return ret;
 }
 
+controller_interface::return_type
+ControllerManager::write()
+{
+  hardware_interface::tracing::Scope trace_scope("write", "hardware");
+  if (watchdog_) {
+    watchdog_->begin_phase(Watchdog::Phase::WRITE, write_deadline_);
+  }
+  const auto allocation_check = begin_hardware_allocation_tracking();
+  const auto allocations_at_start = allocation_tracker::get_allocations();
+  hw_->enforce_command_timeouts();
+  const auto ret = hw_->write();
+  end_hardware_allocation_tracking(allocation_check, allocations_at_start);
+  if (watchdog_) {
+    watchdog_->end_phase();
+  }
+  return ret == hardware_interface::return_type::OK ?
+         controller_interface::return_type::SUCCESS : controller_interface::return_type::ERROR;
+}
+
+allocation_tracker::Mode ControllerManager::begin_hardware_allocation_tracking()
+{
+  const auto allocation_check = rt_allocation_check_.load(std::memory_order_relaxed);
+  if (allocation_check != allocation_tracker::Mode::OFF) {
+    allocation_tracker::set_context("hardware");
+    allocation_tracker::set_mode(allocation_check);
+  }
+  return allocation_check;
+}
+
+void ControllerManager::end_hardware_allocation_tracking(
+  allocation_tracker::Mode allocation_check, std::uint64_t allocations_at_start)
+{
+  if (allocation_check != allocation_tracker::Mode::OFF) {
+    allocation_tracker::set_mode(allocation_tracker::Mode::OFF);
+    rt_hardware_allocations_ += allocation_tracker::get_allocations() - allocations_at_start;
+  }
+}
+
+const Watchdog * ControllerManager::get_watchdog() const
+{
+  return watchdog_.get();
+}
+
+void ControllerManager::enable_stepping(
+  const rclcpp::Duration & period, const rclcpp::Time & start_time)
+{
+  stepping_ = true;
+  step_period_ = period;
+  simulated_time_ = start_time.nanoseconds();
+  override_clocks(simulated_time_);
+  RCLCPP_INFO(
+    get_logger(), "Stepping on simulated time with a period of %f s", period.seconds());
+}
+
+bool ControllerManager::is_stepping() const
+{
+  return stepping_;
+}
+
+controller_interface::return_type ControllerManager::step(std::size_t steps)
+{
+  if (!stepping_) {
+    RCLCPP_ERROR(get_logger(), "Stepping is not enabled, see enable_stepping()");
+    return controller_interface::return_type::ERROR;
+  }
+  for (std::size_t i = 0; i < steps; ++i) {
+    std::lock_guard<std::mutex> step_guard(step_lock_);
+    simulated_time_ += step_period_.nanoseconds();
+    override_clocks(simulated_time_);
+
+    if (read() != controller_interface::return_type::SUCCESS) {
+      RCLCPP_ERROR(get_logger(), "Hardware read failed while stepping");
+      return controller_interface::return_type::ERROR;
+    }
+    const auto ret = update();
+    // the list is not used until the next step, controllers can be changed without waiting
+    rt_controllers_wrapper_.release_used_by_rt_list();
+    if (ret != controller_interface::return_type::SUCCESS) {
+      return ret;
+    }
+    if (write() != controller_interface::return_type::SUCCESS) {
+      RCLCPP_ERROR(get_logger(), "Hardware write failed while stepping");
+      return controller_interface::return_type::ERROR;
+    }
+  }
+  return controller_interface::return_type::SUCCESS;
+}
+
+void ControllerManager::override_clocks(rcl_time_point_value_t time)
+{
+  const auto override_clock = [this, time](rclcpp::Clock & clock)
+    {
+      auto * clock_handle = clock.get_clock_handle();
+      if (rcl_enable_ros_time_override(clock_handle) != RCL_RET_OK ||
+        rcl_set_ros_time_override(clock_handle, time) != RCL_RET_OK)
+      {
+        rcl_reset_error();
+        RCLCPP_WARN_ONCE(
+          get_logger(), "Cannot override a clock with the simulated time, it is not a ROS clock");
+      }
+    };
+
+  // lightweight controllers share the clock of this node
+  override_clock(*get_clock());
+  const auto controllers = rt_controllers_wrapper_.get_snapshot();
+  for (const auto & entry : *controllers) {
+    const auto controller = entry.c.lock();
+    if (controller && controller->get_lifecycle_node()) {
+      override_clock(*controller->get_lifecycle_node()->get_clock());
+    }
+  }
+}
+
 std::vector<ControllerSpec> &
 ControllerManager::RTControllerListWrapper::update_and_get_used_by_rt_list()
 {
@@ -843,6 +2198,11 @@ ControllerManager::RTControllerListWrapper::update_and_get_used_by_rt_list()
   return controllers_lists_[used_by_realtime_controllers_index_];
 }
 
+void ControllerManager::RTControllerListWrapper::release_used_by_rt_list()
+{
+  used_by_realtime_controllers_index_ = -1;
+}
+
 std::vector<ControllerSpec> &
 ControllerManager::RTControllerListWrapper::get_unused_list(
   const std::lock_guard<std::recursive_mutex> &)
@@ -875,6 +2235,137 @@ void ControllerManager::RTControllerListWrapper::switch_updated_list(
   wait_until_rt_not_using(former_current_controllers_list_);
 }
 
+ControllerManager::RTControllerListWrapper::Transaction::Transaction(
+  RTControllerListWrapper & wrapper)
+: wrapper_(wrapper),
+  guard_(wrapper.controllers_lock_),
+  list_(wrapper.get_unused_list(guard_))
+{
+  // Copy all controllers from the updated list, the only copy done by this transaction
+  list_ = wrapper_.get_updated_list(guard_);
+}
+
+ControllerManager::RTControllerListWrapper::Transaction::~Transaction()
+{
+  if (!committed_) {
+    // Discard the pending changes
+    list_.clear();
+  }
+}
+
+ControllerSpec * ControllerManager::RTControllerListWrapper::Transaction::find(
+  const std::string & controller_name)
+{
+  auto found_it = std::find_if(
+    list_.begin(), list_.end(),
+    std::bind(controller_name_compare, std::placeholders::_1, controller_name));
+  return found_it == list_.end() ? nullptr : &(*found_it);
+}
+
+void ControllerManager::RTControllerListWrapper::Transaction::add(
+  const ControllerSpec & controller)
+{
+  list_.emplace_back(controller);
+  modified_ = true;
+}
+
+bool ControllerManager::RTControllerListWrapper::Transaction::order_chained_controllers()
+{
+  // Kahn's algorithm, a controller is ready once all controllers writing its reference
+  // interfaces are placed, the first ready controller in the current order is placed next
+  std::vector<size_t> pending_writers(list_.size(), 0u);
+  for (const auto & controller : list_) {
+    for (const auto & chained_controller : controller.chained_controllers) {
+      auto chained_it = std::find_if(
+        list_.begin(), list_.end(),
+        std::bind(controller_name_compare, std::placeholders::_1, chained_controller));
+      if (chained_it != list_.end()) {
+        ++pending_writers[std::distance(list_.begin(), chained_it)];
+      }
+    }
+  }
+
+  std::vector<size_t> order;
+  std::vector<bool> placed(list_.size(), false);
+  while (order.size() < list_.size()) {
+    size_t next = 0;
+    while (next < list_.size() && (placed[next] || pending_writers[next] != 0u)) {
+      ++next;
+    }
+    if (next == list_.size()) {
+      return false;
+    }
+    placed[next] = true;
+    order.push_back(next);
+    for (const auto & chained_controller : list_[next].chained_controllers) {
+      auto chained_it = std::find_if(
+        list_.begin(), list_.end(),
+        std::bind(controller_name_compare, std::placeholders::_1, chained_controller));
+      if (chained_it != list_.end()) {
+        --pending_writers[std::distance(list_.begin(), chained_it)];
+      }
+    }
+  }
+
+  std::vector<ControllerSpec> ordered_list;
+  ordered_list.reserve(list_.size());
+  for (const auto index : order) {
+    ordered_list.push_back(list_[index]);
+  }
+  list_.swap(ordered_list);
+  modified_ = true;
+  return true;
+}
+
+bool ControllerManager::RTControllerListWrapper::Transaction::remove(
+  const std::string & controller_name)
+{
+  auto found_it = std::find_if(
+    list_.begin(), list_.end(),
+    std::bind(controller_name_compare, std::placeholders::_1, controller_name));
+  if (found_it == list_.end()) {
+    return false;
+  }
+  list_.erase(found_it);
+  modified_ = true;
+  return true;
+}
+
+const std::vector<ControllerSpec> &
+ControllerManager::RTControllerListWrapper::Transaction::get_list() const
+{
+  return list_;
+}
+
+void ControllerManager::RTControllerListWrapper::Transaction::commit()
+{
+  if (committed_) {
+    return;
+  }
+  committed_ = true;
+  if (!modified_) {
+    list_.clear();
+    return;
+  }
+  wrapper_.switch_updated_list(guard_);
+  auto snapshot = std::make_shared<std::vector<SnapshotEntry>>();
+  snapshot->reserve(list_.size());
+  for (const auto & controller : list_) {
+    snapshot->push_back({controller.info, controller.c, controller.rt_allocations});
+  }
+  std::atomic_store(
+    &wrapper_.snapshot_, std::shared_ptr<const std::vector<SnapshotEntry>>(std::move(snapshot)));
+  ++wrapper_.generation_;
+  // The former updated list is no longer used by the RT thread, destroy the old controllers
+  wrapper_.get_unused_list(guard_).clear();
+}
+
+std::shared_ptr<const std::vector<ControllerManager::RTControllerListWrapper::SnapshotEntry>>
+ControllerManager::RTControllerListWrapper::get_snapshot() const
+{
+  return std::atomic_load(&snapshot_);
+}
+
 int ControllerManager::RTControllerListWrapper::get_other_list(int index) const
 {
   return (index + 1) % 2;
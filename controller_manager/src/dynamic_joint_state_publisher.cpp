@@ -0,0 +1,105 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_manager/dynamic_joint_state_publisher.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace controller_manager
+{
+
+DynamicJointStatePublisher::DynamicJointStatePublisher(
+  rclcpp::Node & node,
+  std::shared_ptr<hardware_interface::RobotHardware> hw,
+  std::chrono::nanoseconds poll_period)
+: hw_(hw),
+  clock_(node.get_clock()),
+  joint_state_publisher_(node.create_publisher<control_msgs::msg::DynamicJointState>(
+      "~/dynamic_joint_states", rclcpp::SystemDefaultsQoS())),
+  actuator_state_publisher_(node.create_publisher<control_msgs::msg::DynamicJointState>(
+      "~/dynamic_actuator_states", rclcpp::SystemDefaultsQoS())),
+  poll_period_(poll_period),
+  publishing_thread_(&DynamicJointStatePublisher::publishing_loop, this)
+{
+}
+
+DynamicJointStatePublisher::~DynamicJointStatePublisher()
+{
+  keep_running_ = false;
+  if (publishing_thread_.joinable()) {
+    publishing_thread_.join();
+  }
+}
+
+void DynamicJointStatePublisher::update()
+{
+  std::unique_lock<std::mutex> lock(snapshot_mutex_, std::try_to_lock);
+  if (!lock.owns_lock() || layout_changed_) {
+    return;
+  }
+  if (hw_->copy_joint_values(joint_state_snapshot_) != hardware_interface::return_type::OK ||
+    hw_->copy_actuator_values(actuator_state_snapshot_) != hardware_interface::return_type::OK)
+  {
+    // joints or interfaces were registered, the publishing thread reallocates the snapshots
+    layout_changed_ = true;
+    return;
+  }
+  new_snapshot_ = true;
+}
+
+void DynamicJointStatePublisher::publishing_loop()
+{
+  while (keep_running_) {
+    if (layout_changed_) {
+      std::lock_guard<std::mutex> guard(snapshot_mutex_);
+      joint_state_snapshot_ = hw_->get_registered_joint_state();
+      actuator_state_snapshot_ = hw_->get_registered_actuator_state();
+      new_snapshot_ = false;
+      layout_changed_ = false;
+    }
+    if (!new_snapshot_) {
+      std::this_thread::sleep_for(poll_period_);
+      continue;
+    }
+
+    {
+      // vectors of the same size are assigned without reallocating
+      std::lock_guard<std::mutex> guard(snapshot_mutex_);
+      joint_state_message_ = joint_state_snapshot_;
+      actuator_state_message_ = actuator_state_snapshot_;
+      new_snapshot_ = false;
+    }
+    const auto stamp = clock_->now();
+    joint_state_message_.header.stamp = stamp;
+    actuator_state_message_.header.stamp = stamp;
+    publish(*joint_state_publisher_, joint_state_message_);
+    publish(*actuator_state_publisher_, actuator_state_message_);
+  }
+}
+
+void DynamicJointStatePublisher::publish(
+  rclcpp::Publisher<control_msgs::msg::DynamicJointState> & publisher,
+  const control_msgs::msg::DynamicJointState & message)
+{
+  if (publisher.can_loan_messages()) {
+    auto loaned_message = publisher.borrow_loaned_message();
+    loaned_message.get() = message;
+    publisher.publish(std::move(loaned_message));
+  } else {
+    publisher.publish(message);
+  }
+}
+
+}  // namespace controller_manager
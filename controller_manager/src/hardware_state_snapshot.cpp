@@ -0,0 +1,103 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_manager/hardware_state_snapshot.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace controller_manager
+{
+
+HardwareStateSnapshot::HardwareStateSnapshot(
+  std::shared_ptr<hardware_interface::RobotHardware> hw)
+: hw_(hw)
+{
+  allocate_buffers();
+}
+
+void HardwareStateSnapshot::update()
+{
+  if (layout_changed_) {
+    return;
+  }
+  const int write_buffer = latest_buffer_ == 0 ? 1 : 0;
+  auto & buffer = buffers_[write_buffer];
+  std::unique_lock<std::mutex> lock(buffer.mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return;
+  }
+  if (hw_->copy_joint_values(buffer.joint_state) != hardware_interface::return_type::OK ||
+    hw_->copy_actuator_values(buffer.actuator_state) != hardware_interface::return_type::OK)
+  {
+    // joints or interfaces were registered, the next reader reallocates the buffers
+    layout_changed_ = true;
+    return;
+  }
+  buffer.stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  lock.unlock();
+  latest_buffer_ = write_buffer;
+}
+
+std::int64_t HardwareStateSnapshot::get(
+  control_msgs::msg::DynamicJointState & joint_state,
+  control_msgs::msg::DynamicJointState & actuator_state)
+{
+  std::lock_guard<std::mutex> reader_guard(reader_mutex_);
+  if (layout_changed_) {
+    allocate_buffers();
+  }
+
+  const int latest_buffer = latest_buffer_;
+  if (latest_buffer >= 0) {
+    // the realtime thread may have started refilling this buffer since, in which case we wait
+    // for it to finish and copy the newer, equally complete snapshot
+    auto & buffer = buffers_[latest_buffer];
+    std::lock_guard<std::mutex> guard(buffer.mutex);
+    // unless it failed halfway because the layout changed
+    if (!layout_changed_) {
+      joint_state = buffer.joint_state;
+      actuator_state = buffer.actuator_state;
+      return buffer.stamp;
+    }
+  }
+
+  joint_state = hw_->get_registered_joint_state();
+  actuator_state = hw_->get_registered_actuator_state();
+  for (auto & interface_values : joint_state.interface_values) {
+    interface_values.values.clear();
+  }
+  for (auto & interface_values : actuator_state.interface_values) {
+    interface_values.values.clear();
+  }
+  return 0;
+}
+
+void HardwareStateSnapshot::allocate_buffers()
+{
+  std::lock(buffers_[0].mutex, buffers_[1].mutex);
+  std::lock_guard<std::mutex> guard0(buffers_[0].mutex, std::adopt_lock);
+  std::lock_guard<std::mutex> guard1(buffers_[1].mutex, std::adopt_lock);
+  for (auto & buffer : buffers_) {
+    buffer.joint_state = hw_->get_registered_joint_state();
+    buffer.actuator_state = hw_->get_registered_actuator_state();
+    buffer.stamp = 0;
+  }
+  latest_buffer_ = -1;
+  layout_changed_ = false;
+}
+
+}  // namespace controller_manager
@@ -0,0 +1,203 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_manager/watchdog.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+std::int64_t steady_now() noexcept
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
+namespace controller_manager
+{
+
+constexpr std::size_t Watchdog::kMaxOverruns;
+
+Watchdog::Watchdog(std::chrono::nanoseconds check_period, OverrunCallback callback)
+: check_period_(check_period), callback_(std::move(callback))
+{
+  for (auto & late_count : late_counts_) {
+    late_count = 0;
+  }
+  thread_ = std::thread(&Watchdog::run, this);
+}
+
+Watchdog::~Watchdog()
+{
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  stop_condition_.notify_all();
+  thread_.join();
+}
+
+std::size_t Watchdog::register_controller(const std::string & name)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  const auto it = std::find(controller_names_.begin(), controller_names_.end(), name);
+  if (it != controller_names_.end()) {
+    return static_cast<std::size_t>(it - controller_names_.begin());
+  }
+  controller_names_.push_back(name);
+  return controller_names_.size() - 1;
+}
+
+void Watchdog::begin_phase(Phase phase, std::chrono::nanoseconds deadline) noexcept
+{
+  finish(loop_slot_);
+  publish(loop_slot_, phase, 0, deadline);
+}
+
+void Watchdog::end_phase() noexcept
+{
+  finish(loop_slot_);
+  publish(loop_slot_, Phase::IDLE, 0, std::chrono::nanoseconds(0));
+}
+
+void Watchdog::begin_controller(std::size_t controller, std::chrono::nanoseconds deadline) noexcept
+{
+  publish(controller_slot_, Phase::CONTROLLER, controller, deadline);
+}
+
+void Watchdog::end_controller() noexcept
+{
+  finish(controller_slot_);
+  publish(controller_slot_, Phase::IDLE, 0, std::chrono::nanoseconds(0));
+}
+
+std::uint64_t Watchdog::get_late_count(Phase phase) const
+{
+  return late_counts_[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed);
+}
+
+std::vector<Watchdog::Overrun> Watchdog::get_overruns() const
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  return std::vector<Overrun>(overruns_.begin(), overruns_.end());
+}
+
+const char * Watchdog::phase_name(Phase phase)
+{
+  switch (phase) {
+    case Phase::IDLE:
+      return "idle";
+    case Phase::READ:
+      return "read";
+    case Phase::UPDATE:
+      return "update";
+    case Phase::WRITE:
+      return "write";
+    case Phase::CONTROLLER:
+      return "controller update";
+  }
+  return "unknown";
+}
+
+void Watchdog::publish(
+  Slot & slot, Phase phase, std::size_t controller, std::chrono::nanoseconds deadline) noexcept
+{
+  const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.phase.store(static_cast<std::uint8_t>(phase), std::memory_order_relaxed);
+  slot.controller.store(controller, std::memory_order_relaxed);
+  slot.start.store(steady_now(), std::memory_order_relaxed);
+  slot.deadline.store(deadline.count(), std::memory_order_relaxed);
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void Watchdog::finish(Slot & slot) noexcept
+{
+  // only the realtime thread writes the slot, its own values need no synchronization
+  const auto phase = slot.phase.load(std::memory_order_relaxed);
+  const auto deadline = slot.deadline.load(std::memory_order_relaxed);
+  if (phase != static_cast<std::uint8_t>(Phase::IDLE) && deadline > 0 &&
+    steady_now() - slot.start.load(std::memory_order_relaxed) > deadline)
+  {
+    late_counts_[phase].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Watchdog::check(Slot & slot, std::int64_t now)
+{
+  std::uint32_t sequence;
+  Phase phase;
+  std::size_t controller;
+  std::int64_t start;
+  std::int64_t deadline;
+  do {
+    sequence = slot.sequence.load(std::memory_order_acquire);
+    phase = static_cast<Phase>(slot.phase.load(std::memory_order_relaxed));
+    controller = slot.controller.load(std::memory_order_relaxed);
+    start = slot.start.load(std::memory_order_relaxed);
+    deadline = slot.deadline.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 1u) != 0 || slot.sequence.load(std::memory_order_relaxed) != sequence);
+
+  if (phase == Phase::IDLE || deadline <= 0 || now - start <= deadline ||
+    sequence == slot.reported_sequence)
+  {
+    return;
+  }
+  slot.reported_sequence = sequence;
+
+  Overrun overrun;
+  overrun.phase = phase;
+  overrun.deadline = std::chrono::nanoseconds(deadline);
+  overrun.elapsed = std::chrono::nanoseconds(now - start);
+  overrun.start = std::chrono::steady_clock::time_point(
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::nanoseconds(start)));
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (phase == Phase::CONTROLLER && controller < controller_names_.size()) {
+      overrun.controller = controller_names_[controller];
+    }
+    overruns_.push_back(overrun);
+    if (overruns_.size() > kMaxOverruns) {
+      overruns_.pop_front();
+    }
+  }
+  if (callback_) {
+    callback_(overrun);
+  }
+}
+
+void Watchdog::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_condition_.wait_for(lock, check_period_, [this]() {return stop_;})) {
+    lock.unlock();
+    const auto now = steady_now();
+    check(loop_slot_, now);
+    check(controller_slot_, now);
+    lock.lock();
+  }
+}
+
+}  // namespace controller_manager
@@ -0,0 +1,256 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// End-to-end benchmarks of a ControllerManager driving a TestRobotHardware, or a
+// SyntheticRobotHardware of configurable size, with N running TestControllers. Besides the mean
+// time per iteration, every benchmark reports the latency distribution of the measured operation
+// (p50, p90, p99 and max in ns) and the heap allocations per operation. Write the results as
+// JSON to compare releases:
+//   benchmark_controller_manager --benchmark_out=result.json --benchmark_out_format=json
+// The allocations are those of the benchmark thread, counted by the allocation tracker, and only
+// reported with the allocation hooks preloaded:
+//   LD_PRELOAD=libcontroller_manager_allocation_hooks.so benchmark_controller_manager
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller_manager/allocation_tracker.hpp"
+#include "controller_manager/controller_manager.hpp"
+#include "controller_manager_msgs/srv/switch_controller.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "test_controller/test_controller.hpp"
+#include "test_robot_hardware/synthetic_robot_hardware.hpp"
+#include "test_robot_hardware/test_robot_hardware.hpp"
+
+namespace
+{
+
+constexpr auto STRICT = controller_manager_msgs::srv::SwitchController::Request::STRICT;
+
+namespace allocation_tracker = controller_manager::allocation_tracker;
+
+/// Records the latency of every operation into preallocated storage and reports the
+/// distribution and the allocations per operation on the calling thread as counters of the
+/// benchmark
+class LatencyRecorder
+{
+public:
+  explicit LatencyRecorder(benchmark::State & state, size_t max_samples = 1000000)
+  : state_(state)
+  {
+    samples_.reserve(max_samples);
+  }
+
+  void start()
+  {
+    allocations_at_start_ = allocation_tracker::get_allocations();
+    allocation_tracker::set_context("benchmark");
+    allocation_tracker::set_mode(allocation_tracker::Mode::COUNT);
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  void stop()
+  {
+    const auto end = std::chrono::steady_clock::now();
+    allocation_tracker::set_mode(allocation_tracker::Mode::OFF);
+    allocations_ += allocation_tracker::get_allocations() - allocations_at_start_;
+    ++operations_;
+    if (samples_.size() < samples_.capacity()) {
+      samples_.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count());
+    }
+  }
+
+  ~LatencyRecorder()
+  {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    const auto percentile = [this](double p)
+      {
+        return static_cast<double>(samples_[static_cast<size_t>(p * (samples_.size() - 1))]);
+      };
+    state_.counters["p50_ns"] = percentile(0.5);
+    state_.counters["p90_ns"] = percentile(0.9);
+    state_.counters["p99_ns"] = percentile(0.99);
+    state_.counters["max_ns"] = static_cast<double>(samples_.back());
+    if (allocation_tracker::hooks_installed()) {
+      state_.counters["allocs/op"] =
+        static_cast<double>(allocations_) / static_cast<double>(operations_);
+    }
+  }
+
+private:
+  benchmark::State & state_;
+  std::vector<std::int64_t> samples_;
+  std::chrono::steady_clock::time_point start_;
+  std::uint64_t allocations_at_start_ = 0;
+  std::uint64_t allocations_ = 0;
+  std::uint64_t operations_ = 0;
+};
+
+/// Controller manager with a number of loaded TestControllers
+class Fixture
+{
+public:
+  explicit Fixture(
+    int64_t controllers,
+    std::shared_ptr<hardware_interface::RobotHardware> robot =
+    std::make_shared<test_robot_hardware::TestRobotHardware>())
+  : robot_(robot)
+  {
+    if (!rclcpp::ok()) {
+      rclcpp::init(0, nullptr);
+    }
+    robot_->init();
+    cm_ = std::make_shared<controller_manager::ControllerManager>(
+      robot_, std::make_shared<rclcpp::executors::SingleThreadedExecutor>(),
+      "benchmark_controller_manager");
+    for (int64_t i = 0; i < controllers; ++i) {
+      controller_names_.push_back("controller_" + std::to_string(i));
+      cm_->add_controller(
+        std::make_shared<test_controller::TestController>(), controller_names_.back(),
+        test_controller::TEST_CONTROLLER_TYPE);
+    }
+  }
+
+  /// Requests a switch and runs the control loop until it is done, like the RT thread would
+  controller_interface::return_type switch_controllers(
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+  {
+    auto switch_future = std::async(
+      std::launch::async,
+      &controller_manager::ControllerManager::switch_controller, cm_,
+      start_controllers, stop_controllers, STRICT, true, rclcpp::Duration(0, 0));
+    while (switch_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      cycle();
+    }
+    return switch_future.get();
+  }
+
+  void cycle()
+  {
+    robot_->read();
+    cm_->update();
+    robot_->write();
+  }
+
+  std::shared_ptr<hardware_interface::RobotHardware> robot_;
+  std::shared_ptr<controller_manager::ControllerManager> cm_;
+  std::vector<std::string> controller_names_;
+};
+
+}  // namespace
+
+// One control cycle (read, update, write) with all controllers running, op = one cycle
+static void BM_control_cycle(benchmark::State & state)
+{
+  Fixture fixture(state.range(0));
+  if (fixture.switch_controllers(fixture.controller_names_, {}) !=
+    controller_interface::return_type::SUCCESS)
+  {
+    state.SkipWithError("Could not start the controllers");
+    return;
+  }
+
+  LatencyRecorder recorder(state);
+  for (auto _ : state) {
+    recorder.start();
+    fixture.cycle();
+    recorder.stop();
+  }
+}
+BENCHMARK(BM_control_cycle)->ArgName("controllers")->Arg(1)->Arg(10)->Arg(100);
+
+// One control cycle with 10 running controllers and a synthetic hardware of N joints with
+// 3 interfaces each, op = one cycle
+static void BM_control_cycle_synthetic_hardware(benchmark::State & state)
+{
+  test_robot_hardware::SyntheticRobotHardwareOptions options;
+  options.joints = static_cast<std::size_t>(state.range(0));
+  Fixture fixture(10, std::make_shared<test_robot_hardware::SyntheticRobotHardware>(options));
+  if (fixture.switch_controllers(fixture.controller_names_, {}) !=
+    controller_interface::return_type::SUCCESS)
+  {
+    state.SkipWithError("Could not start the controllers");
+    return;
+  }
+
+  LatencyRecorder recorder(state);
+  for (auto _ : state) {
+    recorder.start();
+    fixture.cycle();
+    recorder.stop();
+  }
+}
+BENCHMARK(BM_control_cycle_synthetic_hardware)->ArgName("joints")->Arg(10)->Arg(100)->Arg(1000)
+->Arg(5000);
+
+// Starting or stopping all controllers, from the request until switch_controller() returns
+// while the control loop keeps running, op = one switch. The allocations are those of the
+// control loop, the switch is requested from another thread.
+static void BM_switch_controllers(benchmark::State & state)
+{
+  Fixture fixture(state.range(0));
+  const std::vector<std::string> none;
+  bool running = false;
+
+  LatencyRecorder recorder(state);
+  for (auto _ : state) {
+    recorder.start();
+    const auto ret = running ?
+      fixture.switch_controllers(none, fixture.controller_names_) :
+      fixture.switch_controllers(fixture.controller_names_, none);
+    recorder.stop();
+    if (ret != controller_interface::return_type::SUCCESS) {
+      state.SkipWithError("Could not switch the controllers");
+      break;
+    }
+    running = !running;
+  }
+}
+BENCHMARK(BM_switch_controllers)->ArgName("controllers")->Arg(1)->Arg(10)->Arg(100)
+->UseRealTime();
+
+// Loading and unloading one more controller while the others are loaded,
+// op = one add_controller() and unload_controller()
+static void BM_load_unload_controller(benchmark::State & state)
+{
+  Fixture fixture(state.range(0));
+
+  LatencyRecorder recorder(state);
+  for (auto _ : state) {
+    auto controller = std::make_shared<test_controller::TestController>();
+    recorder.start();
+    fixture.cm_->add_controller(
+      controller, "loaded_controller", test_controller::TEST_CONTROLLER_TYPE);
+    const auto ret = fixture.cm_->unload_controller("loaded_controller");
+    recorder.stop();
+    if (ret != controller_interface::return_type::SUCCESS) {
+      state.SkipWithError("Could not unload the controller");
+      break;
+    }
+  }
+}
+BENCHMARK(BM_load_unload_controller)->ArgName("controllers")->Arg(1)->Arg(10)->Arg(100)
+->UseRealTime();
@@ -0,0 +1,171 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Runs with the allocation hooks preloaded
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <malloc.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller_manager/allocation_tracker.hpp"
+#include "controller_manager/controller_manager.hpp"
+#include "controller_manager_test_common.hpp"
+#include "test_robot_hardware/synthetic_robot_hardware.hpp"
+
+namespace allocation_tracker = controller_manager::allocation_tracker;
+
+TEST_F(TestControllerManager, scoped_tracking_counts_allocations)
+{
+  ASSERT_TRUE(allocation_tracker::hooks_installed());
+
+  allocation_tracker::ScopedTracking tracking("test");
+  EXPECT_EQ(0u, tracking.get_allocations());
+  auto value = std::make_shared<int>(42);
+  EXPECT_EQ(1u, tracking.get_allocations());
+  {
+    allocation_tracker::ScopedTracking nested_tracking("nested", allocation_tracker::Mode::OFF);
+    auto other_value = std::make_shared<int>(43);
+    EXPECT_EQ(0u, nested_tracking.get_allocations());
+  }
+  EXPECT_EQ(allocation_tracker::Mode::COUNT, allocation_tracker::get_mode());
+  EXPECT_EQ(1u, tracking.get_allocations());
+}
+
+TEST_F(TestControllerManager, aligned_allocations_are_tracked)
+{
+  ASSERT_TRUE(allocation_tracker::hooks_installed());
+
+  allocation_tracker::ScopedTracking tracking("test");
+  void * memory = nullptr;
+  ASSERT_EQ(0, posix_memalign(&memory, 64, 100));
+  std::free(memory);
+  EXPECT_EQ(1u, tracking.get_allocations());
+  memory = aligned_alloc(64, 128);
+  ASSERT_NE(nullptr, memory);
+  std::free(memory);
+  EXPECT_EQ(2u, tracking.get_allocations());
+  memory = memalign(64, 100);
+  ASSERT_NE(nullptr, memory);
+  std::free(memory);
+  EXPECT_EQ(3u, tracking.get_allocations());
+}
+
+TEST_F(TestControllerManager, synthetic_hardware_read_and_write_do_not_allocate)
+{
+  ASSERT_TRUE(allocation_tracker::hooks_installed());
+  test_robot_hardware::SyntheticRobotHardwareOptions options;
+  options.joints = 1000;
+  options.jitter = std::chrono::nanoseconds(1);
+  test_robot_hardware::SyntheticRobotHardware synthetic_robot(options);
+  ASSERT_EQ(hardware_interface::return_type::OK, synthetic_robot.init());
+
+  allocation_tracker::ScopedTracking tracking("synthetic_robot_hardware");
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(hardware_interface::return_type::OK, synthetic_robot.read());
+    ASSERT_EQ(hardware_interface::return_type::OK, synthetic_robot.write());
+  }
+  EXPECT_EQ(0u, tracking.get_allocations());
+}
+
+TEST_F(TestControllerManager, allocations_in_update_are_attributed_to_controllers)
+{
+  ASSERT_TRUE(allocation_tracker::hooks_installed());
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+  EXPECT_FALSE(
+    cm->set_parameter(rclcpp::Parameter("rt_allocation_check", "sometimes")).successful);
+  ASSERT_TRUE(cm->set_parameter(rclcpp::Parameter("rt_allocation_check", "count")).successful);
+
+  auto allocating_controller = std::make_shared<test_controller::TestController>();
+  allocating_controller->allocate_in_update = true;
+  auto test_controller = std::make_shared<test_controller::TestController>();
+  cm->add_controller(allocating_controller, "allocating_controller", "test_controller");
+  cm->add_controller(test_controller, "test_controller", "test_controller");
+
+  auto switch_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::switch_controller, cm,
+    std::vector<std::string>{"allocating_controller", "test_controller"},
+    std::vector<std::string>{}, STRICT, true, rclcpp::Duration(0, 0));
+  while (switch_future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+    cm->update();
+  }
+  ASSERT_EQ(controller_interface::return_type::SUCCESS, switch_future.get());
+
+  const auto loaded_controllers = cm->get_loaded_controllers();
+  ASSERT_EQ(2u, loaded_controllers.size());
+  ASSERT_EQ("allocating_controller", loaded_controllers[0].info.name);
+  const std::uint64_t allocations_at_start = *loaded_controllers[0].rt_allocations;
+  for (size_t i = 0; i < 10; ++i) {
+    cm->update();
+  }
+  EXPECT_EQ(10u, *loaded_controllers[0].rt_allocations - allocations_at_start);
+  EXPECT_EQ(0u, loaded_controllers[1].rt_allocations->load());
+
+  // switching it off stops counting
+  ASSERT_TRUE(cm->set_parameter(rclcpp::Parameter("rt_allocation_check", "off")).successful);
+  cm->update();
+  EXPECT_EQ(10u, *loaded_controllers[0].rt_allocations - allocations_at_start);
+  EXPECT_EQ(allocation_tracker::Mode::OFF, allocation_tracker::get_mode());
+}
+
+TEST_F(TestControllerManager, trap_mode_aborts_naming_the_controller)
+{
+  ASSERT_TRUE(allocation_tracker::hooks_installed());
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+  auto allocating_controller = std::make_shared<test_controller::TestController>();
+  allocating_controller->allocate_in_update = true;
+  cm->add_controller(allocating_controller, "allocating_controller", "test_controller");
+
+  auto switch_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::switch_controller, cm,
+    std::vector<std::string>{"allocating_controller"},
+    std::vector<std::string>{}, STRICT, true, rclcpp::Duration(0, 0));
+  while (switch_future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+    cm->update();
+  }
+  ASSERT_EQ(controller_interface::return_type::SUCCESS, switch_future.get());
+
+  ASSERT_TRUE(cm->set_parameter(rclcpp::Parameter("rt_allocation_check", "trap")).successful);
+  // the middleware runs threads, so the death test must not just fork
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  EXPECT_DEATH(cm->update(), "allocating_controller");
+}
+
+TEST_F(TestControllerManager, trap_mode_aborts_in_hardware_allocations)
+{
+  ASSERT_TRUE(allocation_tracker::hooks_installed());
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+  ASSERT_TRUE(cm->set_parameter(rclcpp::Parameter("rt_allocation_check", "trap")).successful);
+
+  // TestRobotHardware only allocates in write()
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, cm->read());
+  EXPECT_EQ(allocation_tracker::Mode::OFF, allocation_tracker::get_mode());
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  EXPECT_DEATH(cm->write(), "hardware");
+}
@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "lifecycle_msgs/msg/transition.hpp"
 
@@ -30,6 +31,19 @@ controller_interface::return_type
 TestController::update()
 {
   ++internal_counter;
+  if (allocate_in_update) {
+    last_update = std::make_shared<size_t>(internal_counter);
+  }
+  if (record_update_time) {
+    last_update_time = now();
+  }
+  for (auto & chained_reference : chained_reference_interfaces_) {
+    chained_reference.set_value(static_cast<double>(internal_counter));
+  }
+  reference_values.clear();
+  for (const auto & reference : reference_handles_) {
+    reference_values.push_back(reference.get_value());
+  }
   return controller_interface::return_type::SUCCESS;
 }
 
@@ -37,9 +51,44 @@ rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn
 TestController::on_configure(const rclcpp_lifecycle::State & previous_state)
 {
   (void) previous_state;
+  // the handles of a previous configuration point to released storage
+  reference_handles_.clear();
+  for (const auto & interface_resources : reference_interfaces) {
+    for (const auto & resource : interface_resources.resources) {
+      register_reference_interface(resource, interface_resources.hardware_interface);
+    }
+  }
+  // handles are only taken once all reference interfaces are registered
+  for (const auto & interface_resources : reference_interfaces) {
+    for (const auto & resource : interface_resources.resources) {
+      hardware_interface::JointHandle handle(resource, interface_resources.hardware_interface);
+      get_reference_interface_handle(handle);
+      reference_handles_.push_back(handle);
+    }
+  }
   return rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn::SUCCESS;
 }
 
+rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn
+TestController::on_activate(const rclcpp_lifecycle::State & previous_state)
+{
+  (void) previous_state;
+  ++activation_counter;
+  return rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn::SUCCESS;
+}
+
+std::vector<hardware_interface::InterfaceResources>
+TestController::get_claimed_resources() const
+{
+  return claimed_resources;
+}
+
+std::vector<hardware_interface::InterfaceResources>
+TestController::get_claimed_reference_interfaces() const
+{
+  return claimed_reference_interfaces;
+}
+
 }  // namespace test_controller
 
 #include "pluginlib/class_list_macros.hpp"
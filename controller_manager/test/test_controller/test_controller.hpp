@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "controller_manager/controller_manager.hpp"
 #include "controller_interface/visibility_control.h"
@@ -44,7 +45,37 @@ public:
   rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn
   on_configure(const rclcpp_lifecycle::State & previous_state) override;
 
+  CONTROLLER_MANAGER_PUBLIC
+  rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn
+  on_activate(const rclcpp_lifecycle::State & previous_state) override;
+
+  CONTROLLER_MANAGER_PUBLIC
+  std::vector<hardware_interface::InterfaceResources>
+  get_claimed_resources() const override;
+
+  CONTROLLER_MANAGER_PUBLIC
+  std::vector<hardware_interface::InterfaceResources>
+  get_claimed_reference_interfaces() const override;
+
   size_t internal_counter = 0;
+  // incremented every time the controller is activated
+  size_t activation_counter = 0;
+  std::vector<hardware_interface::InterfaceResources> claimed_resources;
+  // registered when configuring, written by chained controllers
+  std::vector<hardware_interface::InterfaceResources> reference_interfaces;
+  // set to the internal counter at every update
+  std::vector<hardware_interface::InterfaceResources> claimed_reference_interfaces;
+  // values of the own reference interfaces, read at every update
+  std::vector<double> reference_values;
+  // allocates at every update, to test the allocation tracking of the controller manager
+  bool allocate_in_update = false;
+  std::shared_ptr<size_t> last_update;
+  // set to the time of the controller at every update if record_update_time is set
+  bool record_update_time = false;
+  rclcpp::Time last_update_time;
+
+private:
+  std::vector<hardware_interface::JointHandle> reference_handles_;
 };
 
 }  // namespace test_controller
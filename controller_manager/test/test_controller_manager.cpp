@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -124,3 +126,154 @@ TEST_F(TestControllerManager, controller_lifecycle) {
     test_controller->get_lifecycle_node()->get_current_state().id());
   EXPECT_EQ(1, test_controller.use_count());
 }
+
+TEST_F(TestControllerManager, lightweight_controller_lifecycle) {
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+  cm->set_parameter(rclcpp::Parameter("lightweight_controllers", true));
+
+  auto test_controller = std::make_shared<test_controller::TestController>();
+  cm->add_controller(
+    test_controller, test_controller::TEST_CONTROLLER_NAME,
+    test_controller::TEST_CONTROLLER_TYPE);
+  EXPECT_EQ(nullptr, test_controller->get_lifecycle_node()) << "No LifecycleNode is created";
+  ASSERT_NE(nullptr, test_controller->get_node());
+  EXPECT_EQ(
+    test_controller::TEST_CONTROLLER_NAME, test_controller->get_node()->get_sub_namespace());
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    test_controller->get_current_state().id());
+
+  const auto switch_controllers = [&cm](
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+    {
+      auto switch_future = std::async(
+        std::launch::async,
+        &controller_manager::ControllerManager::switch_controller, cm,
+        start_controllers, stop_controllers,
+        STRICT, true, rclcpp::Duration(0, 0));
+      while (switch_future.wait_for(std::chrono::milliseconds(10)) !=
+        std::future_status::ready)
+      {
+        cm->update();
+      }
+      return switch_future.get();
+    };
+
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({test_controller::TEST_CONTROLLER_NAME}, {}));
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    test_controller->get_current_state().id());
+  const auto counter = test_controller->internal_counter;
+  // the controller reads the time of the node it shares with the controller manager
+  test_controller->record_update_time = true;
+  cm->update();
+  EXPECT_EQ(counter + 1, test_controller->internal_counter);
+  EXPECT_NE(0, test_controller->last_update_time.nanoseconds());
+
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({}, {test_controller::TEST_CONTROLLER_NAME}));
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    test_controller->get_current_state().id());
+
+  auto unload_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::unload_controller, cm,
+    test_controller::TEST_CONTROLLER_NAME);
+  while (unload_future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+    cm->update();
+  }
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, unload_future.get());
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED,
+    test_controller->get_current_state().id());
+}
+
+TEST_F(TestControllerManager, stepping_on_simulated_time) {
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+  EXPECT_FALSE(cm->is_stepping());
+  EXPECT_EQ(controller_interface::return_type::ERROR, cm->step());
+
+  const rclcpp::Duration period(0, 1000000);
+  cm->enable_stepping(period, rclcpp::Time(10, 0, RCL_ROS_TIME));
+  EXPECT_TRUE(cm->is_stepping());
+  EXPECT_EQ(rclcpp::Time(10, 0, RCL_ROS_TIME), cm->now());
+
+  auto test_controller = std::make_shared<test_controller::TestController>();
+  test_controller->record_update_time = true;
+  cm->add_controller(
+    test_controller, test_controller::TEST_CONTROLLER_NAME,
+    test_controller::TEST_CONTROLLER_TYPE);
+
+  // switches complete synchronously, no other thread needs to call update()
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    cm->switch_controller(
+      {test_controller::TEST_CONTROLLER_NAME}, {},
+      STRICT, true, rclcpp::Duration(0, 0)));
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    test_controller->get_current_state().id());
+  EXPECT_EQ(0u, test_controller->internal_counter);
+
+  // 100 simulated seconds
+  ASSERT_EQ(controller_interface::return_type::SUCCESS, cm->step(100000));
+  EXPECT_EQ(100000u, test_controller->internal_counter);
+  EXPECT_EQ(rclcpp::Time(110, 0, RCL_ROS_TIME), cm->now());
+  EXPECT_EQ(rclcpp::Time(110, 0, RCL_ROS_TIME), test_controller->last_update_time);
+
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    cm->switch_controller(
+      {}, {test_controller::TEST_CONTROLLER_NAME},
+      STRICT, true, rclcpp::Duration(0, 0)));
+  ASSERT_EQ(controller_interface::return_type::SUCCESS, cm->step());
+  EXPECT_EQ(100000u, test_controller->internal_counter);
+  EXPECT_EQ(
+    controller_interface::return_type::SUCCESS,
+    cm->unload_controller(test_controller::TEST_CONTROLLER_NAME));
+}
+
+TEST_F(TestControllerManager, switching_while_stepping_from_another_thread) {
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+  cm->enable_stepping(rclcpp::Duration(0, 1000000));
+  auto test_controller = std::make_shared<test_controller::TestController>();
+  cm->add_controller(
+    test_controller, test_controller::TEST_CONTROLLER_NAME,
+    test_controller::TEST_CONTROLLER_TYPE);
+
+  // as the switch_controller service would, while the simulation keeps stepping
+  auto switch_future = std::async(
+    std::launch::async, [&cm]() {
+      for (int i = 0; i < 100; ++i) {
+        const std::vector<std::string> controllers = {test_controller::TEST_CONTROLLER_NAME};
+        const std::vector<std::string> none;
+        const auto ret = cm->switch_controller(
+          i % 2 == 0 ? controllers : none, i % 2 == 0 ? none : controllers,
+          STRICT, true, rclcpp::Duration(0, 0));
+        if (ret != controller_interface::return_type::SUCCESS) {
+          return ret;
+        }
+      }
+      return controller_interface::return_type::SUCCESS;
+    });
+  while (switch_future.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+    ASSERT_EQ(controller_interface::return_type::SUCCESS, cm->step());
+  }
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, switch_future.get());
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    test_controller->get_current_state().id());
+  // update() must not have switched a second time
+  EXPECT_EQ(50u, test_controller->activation_counter);
+}
@@ -14,6 +14,8 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <fstream>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +26,9 @@
 #include "controller_manager_msgs/srv/switch_controller.hpp"
 #include "controller_manager_msgs/srv/list_controller_types.hpp"
 #include "controller_manager_msgs/srv/list_controllers.hpp"
+#include "controller_manager_msgs/srv/list_hardware_interfaces.hpp"
+#include "controller_manager_msgs/srv/load_controllers.hpp"
+#include "controller_manager_msgs/srv/write_trace.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 
 using ::testing::_;
@@ -135,6 +140,7 @@ TEST_F(TestControllerManagerSrvs, list_controllers_srv) {
     result->controller.size());
 
   auto test_controller = std::make_shared<test_controller::TestController>();
+  test_controller->claimed_resources = {{"position", {"joint1", "joint2"}}};
   auto abstract_test_controller = cm_->add_controller(
     test_controller, test_controller::TEST_CONTROLLER_NAME,
     test_controller::TEST_CONTROLLER_TYPE);
@@ -146,6 +152,11 @@ TEST_F(TestControllerManagerSrvs, list_controllers_srv) {
   ASSERT_EQ(test_controller::TEST_CONTROLLER_NAME, result->controller[0].name);
   ASSERT_EQ(test_controller::TEST_CONTROLLER_TYPE, result->controller[0].type);
   ASSERT_EQ("inactive", result->controller[0].state);
+  ASSERT_EQ(1u, result->controller[0].claimed_resources.size());
+  ASSERT_EQ("position", result->controller[0].claimed_resources[0].hardware_interface);
+  ASSERT_THAT(
+    result->controller[0].claimed_resources[0].resources,
+    ::testing::ElementsAre("joint1", "joint2"));
 
   cm_->switch_controller(
     {test_controller::TEST_CONTROLLER_NAME}, {},
@@ -178,6 +189,66 @@ TEST_F(TestControllerManagerSrvs, list_controllers_srv) {
     result->controller.size());
 }
 
+TEST_F(TestControllerManagerSrvs, list_controllers_srv_filters_and_generation) {
+  rclcpp::executors::SingleThreadedExecutor srv_executor;
+  rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
+  srv_executor.add_node(srv_node);
+  rclcpp::Client<controller_manager_msgs::srv::ListControllers>::SharedPtr client =
+    srv_node->create_client<controller_manager_msgs::srv::ListControllers>(
+    "test_controller_manager/list_controllers");
+  auto request = std::make_shared<controller_manager_msgs::srv::ListControllers::Request>();
+
+  cm_->add_controller(
+    std::make_shared<test_controller::TestController>(), "position_controller",
+    test_controller::TEST_CONTROLLER_TYPE);
+  cm_->add_controller(
+    std::make_shared<test_controller::TestController>(), "velocity_controller",
+    test_controller::TEST_CONTROLLER_TYPE);
+  cm_->switch_controller(
+    {"velocity_controller"}, {},
+    controller_manager_msgs::srv::SwitchController::Request::STRICT, true,
+    rclcpp::Duration(0, 0));
+
+  auto result = call_service_and_wait(*client, request, srv_executor);
+  ASSERT_EQ(2u, result->controller.size());
+  EXPECT_FALSE(result->unchanged);
+  const auto generation = result->generation;
+
+  request->states = {"active"};
+  result = call_service_and_wait(*client, request, srv_executor);
+  ASSERT_EQ(1u, result->controller.size());
+  EXPECT_EQ("velocity_controller", result->controller[0].name);
+
+  request->states.clear();
+  request->name_pattern = "pos*";
+  result = call_service_and_wait(*client, request, srv_executor);
+  ASSERT_EQ(1u, result->controller.size());
+  EXPECT_EQ("position_controller", result->controller[0].name);
+
+  request->name_pattern.clear();
+  request->types = {"unknown_type"};
+  result = call_service_and_wait(*client, request, srv_executor);
+  EXPECT_TRUE(result->controller.empty());
+
+  // polling with the known generation returns nothing until the controllers change
+  request->types.clear();
+  request->known_generation = generation;
+  result = call_service_and_wait(*client, request, srv_executor);
+  EXPECT_TRUE(result->unchanged);
+  EXPECT_TRUE(result->controller.empty());
+  EXPECT_EQ(generation, result->generation);
+
+  cm_->switch_controller(
+    {}, {"velocity_controller"},
+    controller_manager_msgs::srv::SwitchController::Request::STRICT, true,
+    rclcpp::Duration(0, 0));
+  result = call_service_and_wait(*client, request, srv_executor);
+  EXPECT_FALSE(result->unchanged);
+  EXPECT_NE(generation, result->generation);
+  ASSERT_EQ(2u, result->controller.size());
+  EXPECT_EQ("inactive", result->controller[1].state);
+}
+
 TEST_F(TestControllerManagerSrvs, reload_controller_libraries_srv) {
   rclcpp::executors::SingleThreadedExecutor srv_executor;
   rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
@@ -274,6 +345,31 @@ TEST_F(TestControllerManagerSrvs, load_controller_srv) {
   ASSERT_TRUE(result->ok);
 }
 
+TEST_F(TestControllerManagerSrvs, load_controllers_srv) {
+  rclcpp::executors::SingleThreadedExecutor srv_executor;
+  rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
+  srv_executor.add_node(srv_node);
+  rclcpp::Client<controller_manager_msgs::srv::LoadControllers>::SharedPtr client =
+    srv_node->create_client<controller_manager_msgs::srv::LoadControllers>(
+    "test_controller_manager/load_controllers");
+
+  auto request = std::make_shared<controller_manager_msgs::srv::LoadControllers::Request>();
+  request->names = {"test_controller_1", "test_controller_2"};
+  cm_->set_parameter(
+    rclcpp::Parameter("test_controller_1.type", test_controller::TEST_CONTROLLER_TYPE));
+  auto result = call_service_and_wait(*client, request, srv_executor, true);
+  ASSERT_FALSE(result->ok) << "There's no param specifying the type for test_controller_2";
+  ASSERT_THAT(result->loaded, ::testing::ElementsAre(true, false));
+  EXPECT_EQ(1u, cm_->get_loaded_controllers().size());
+
+  cm_->set_parameter(
+    rclcpp::Parameter("test_controller_2.type", test_controller::TEST_CONTROLLER_TYPE));
+  request->names = {"test_controller_2"};
+  result = call_service_and_wait(*client, request, srv_executor, true);
+  ASSERT_TRUE(result->ok);
+  EXPECT_EQ(2u, cm_->get_loaded_controllers().size());
+}
+
 TEST_F(TestControllerManagerSrvs, unload_controller_srv) {
   rclcpp::executors::SingleThreadedExecutor srv_executor;
   rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
@@ -297,3 +393,137 @@ TEST_F(TestControllerManagerSrvs, unload_controller_srv) {
   ASSERT_TRUE(result->ok);
   EXPECT_EQ(0u, cm_->get_loaded_controllers().size());
 }
+
+TEST_F(TestControllerManager, list_controllers_srv_responsive_during_switch) {
+  auto multi_threaded_executor = std::make_shared<rclcpp::executors::MultiThreadedExecutor>(
+    rclcpp::ExecutorOptions(), 2);
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, multi_threaded_executor, "test_controller_manager_mt");
+  auto test_controller = std::make_shared<test_controller::TestController>();
+  cm->add_controller(
+    test_controller, test_controller::TEST_CONTROLLER_NAME,
+    test_controller::TEST_CONTROLLER_TYPE);
+  multi_threaded_executor->add_node(cm);
+  auto executor_spin_future = std::async(
+    std::launch::async, [multi_threaded_executor]() -> void {
+      multi_threaded_executor->spin();
+    });
+
+  rclcpp::executors::SingleThreadedExecutor srv_executor;
+  rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
+  srv_executor.add_node(srv_node);
+  auto switch_client = srv_node->create_client<controller_manager_msgs::srv::SwitchController>(
+    "test_controller_manager_mt/switch_controller");
+  auto list_client = srv_node->create_client<controller_manager_msgs::srv::ListControllers>(
+    "test_controller_manager_mt/list_controllers");
+  ASSERT_TRUE(switch_client->wait_for_service(500ms));
+  ASSERT_TRUE(list_client->wait_for_service(500ms));
+
+  // the switch blocks in its service callback until the next update
+  auto switch_request =
+    std::make_shared<controller_manager_msgs::srv::SwitchController::Request>();
+  switch_request->start_controllers = {test_controller::TEST_CONTROLLER_NAME};
+  switch_request->strictness = controller_manager_msgs::srv::SwitchController::Request::STRICT;
+  auto switch_result = switch_client->async_send_request(switch_request);
+  EXPECT_EQ(
+    rclcpp::FutureReturnCode::TIMEOUT,
+    srv_executor.spin_until_future_complete(switch_result, 100ms));
+
+  auto list_result = list_client->async_send_request(
+    std::make_shared<controller_manager_msgs::srv::ListControllers::Request>());
+  ASSERT_EQ(
+    rclcpp::FutureReturnCode::SUCCESS,
+    srv_executor.spin_until_future_complete(list_result, 1s)) <<
+    "Listing controllers must not wait for the pending switch";
+  ASSERT_EQ(1u, list_result.get()->controller.size());
+
+  while (srv_executor.spin_until_future_complete(switch_result, 10ms) !=
+    rclcpp::FutureReturnCode::SUCCESS)
+  {
+    cm->update();
+  }
+  EXPECT_TRUE(switch_result.get()->ok);
+  multi_threaded_executor->cancel();
+}
+
+TEST_F(TestControllerManagerSrvs, list_hardware_interfaces_srv)
+{
+  using controller_manager_msgs::srv::ListHardwareInterfaces;
+  rclcpp::executors::SingleThreadedExecutor srv_executor;
+  rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
+  srv_executor.add_node(srv_node);
+  rclcpp::Client<ListHardwareInterfaces>::SharedPtr client =
+    srv_node->create_client<ListHardwareInterfaces>(
+    "test_controller_manager/list_hardware_interfaces");
+  auto request = std::make_shared<ListHardwareInterfaces::Request>();
+
+  // the update timer takes the snapshots
+  auto result = call_service_and_wait(*client, request, srv_executor);
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (rclcpp::Time(result->stamp).nanoseconds() == 0 &&
+    std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(10ms);
+    result = call_service_and_wait(*client, request, srv_executor);
+  }
+  ASSERT_NE(0, rclcpp::Time(result->stamp).nanoseconds());
+
+  const auto & expected_joints = robot_->get_registered_joint_state();
+  ASSERT_EQ(expected_joints.joint_names.size(), result->joints.size());
+  for (size_t i = 0; i < result->joints.size(); ++i) {
+    EXPECT_EQ(expected_joints.joint_names[i], result->joints[i].name);
+    EXPECT_EQ(
+      expected_joints.interface_values[i].interface_names,
+      result->joints[i].interface_names);
+    EXPECT_EQ(expected_joints.interface_values[i].values, result->joints[i].values);
+  }
+  EXPECT_EQ(1.1, result->joints[0].values[0]);
+  EXPECT_EQ(
+    robot_->get_registered_actuator_state().joint_names.size(), result->actuators.size());
+}
+
+TEST_F(TestControllerManagerSrvs, write_trace_srv)
+{
+  using controller_manager_msgs::srv::WriteTrace;
+  rclcpp::executors::SingleThreadedExecutor srv_executor;
+  rclcpp::Node::SharedPtr srv_node = std::make_shared<rclcpp::Node>("srv_client");
+  srv_executor.add_node(srv_node);
+  rclcpp::Client<WriteTrace>::SharedPtr client =
+    srv_node->create_client<WriteTrace>("test_controller_manager/write_trace");
+  auto request = std::make_shared<WriteTrace::Request>();
+
+  // nothing is recorded until tracing is enabled
+  request->file_name = "write_trace_srv_test.json";
+  auto result = call_service_and_wait(*client, request, srv_executor);
+  ASSERT_TRUE(result->ok);
+  EXPECT_EQ(0u, result->events);
+
+  ASSERT_TRUE(cm_->set_parameter(rclcpp::Parameter("enable_tracing", true)).successful);
+  // the update timer records the events
+  std::this_thread::sleep_for(100ms);
+  // reads are traced by the controller manager, whatever the hardware
+  cm_->read();
+  ASSERT_TRUE(cm_->set_parameter(rclcpp::Parameter("enable_tracing", false)).successful);
+  result = call_service_and_wait(*client, request, srv_executor);
+  ASSERT_TRUE(result->ok);
+  EXPECT_LT(0u, result->events);
+  EXPECT_EQ(0u, result->dropped_events);
+
+  // in the working directory by default
+  EXPECT_EQ("./write_trace_srv_test.json", result->file_path);
+  std::ifstream file(result->file_path);
+  const std::string trace(
+    (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  EXPECT_THAT(trace, ::testing::HasSubstr("\"name\":\"update\",\"cat\":\"controller_manager\""));
+  EXPECT_THAT(trace, ::testing::HasSubstr("\"name\":\"controller_manager update\""));
+  EXPECT_THAT(trace, ::testing::HasSubstr("\"name\":\"read\",\"cat\":\"hardware\""));
+
+  // only file names in the trace directory are accepted
+  for (const auto & file_name : {"/tmp/trace.json", "../trace.json", "..", ""}) {
+    request->file_name = file_name;
+    result = call_service_and_wait(*client, request, srv_executor);
+    EXPECT_FALSE(result->ok) << file_name;
+  }
+  EXPECT_FALSE(
+    cm_->set_parameter(rclcpp::Parameter("trace_directory", std::string("/tmp"))).successful);
+}
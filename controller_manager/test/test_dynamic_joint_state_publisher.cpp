@@ -0,0 +1,59 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "controller_manager/dynamic_joint_state_publisher.hpp"
+#include "controller_manager_test_common.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+using namespace std::chrono_literals;
+
+TEST_F(TestControllerManager, publishes_dynamic_joint_states)
+{
+  auto node = std::make_shared<rclcpp::Node>("test_dynamic_joint_state_publisher");
+  auto publisher = std::make_unique<controller_manager::DynamicJointStatePublisher>(
+    *node, robot_);
+
+  control_msgs::msg::DynamicJointState::SharedPtr received;
+  auto subscription = node->create_subscription<control_msgs::msg::DynamicJointState>(
+    "~/dynamic_joint_states", rclcpp::SystemDefaultsQoS(),
+    [&received](control_msgs::msg::DynamicJointState::SharedPtr msg) {received = msg;});
+
+  executor_->add_node(node);
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!received && std::chrono::steady_clock::now() < deadline) {
+    publisher->update();
+    executor_->spin_some();
+    std::this_thread::sleep_for(10ms);
+  }
+  executor_->remove_node(node);
+
+  ASSERT_TRUE(received);
+  const auto & expected = robot_->get_registered_joint_state();
+  ASSERT_EQ(expected.joint_names, received->joint_names);
+  ASSERT_EQ(expected.interface_values.size(), received->interface_values.size());
+  for (size_t i = 0; i < expected.interface_values.size(); ++i) {
+    EXPECT_EQ(
+      expected.interface_values[i].interface_names,
+      received->interface_values[i].interface_names);
+    EXPECT_EQ(expected.interface_values[i].values, received->interface_values[i].values);
+  }
+  EXPECT_EQ(1.1, received->interface_values[0].values[0]);
+}
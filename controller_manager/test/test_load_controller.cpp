@@ -14,6 +14,9 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +27,7 @@
 
 #include "controller_manager/controller_manager.hpp"
 
+#include "controller_manager_msgs/msg/controller_event.hpp"
 #include "controller_manager_msgs/srv/switch_controller.hpp"
 
 #include "lifecycle_msgs/msg/state.hpp"
@@ -88,6 +92,53 @@ TEST_F(TestControllerManager, load2_known_controller)
     abstract_test_controller2.c->get_lifecycle_node()->get_current_state().id());
 }
 
+TEST_F(TestControllerManager, load_controllers_in_parallel)
+{
+  controller_manager::ControllerManager cm(robot_, executor_, "test_controller_manager");
+  std::vector<std::string> controller_names;
+  for (size_t i = 0; i < 8; ++i) {
+    controller_names.push_back("test_controller_" + std::to_string(i));
+    cm.set_parameter(
+      rclcpp::Parameter(controller_names.back() + ".type", test_controller::TEST_CONTROLLER_TYPE));
+  }
+  // controllers without type parameter, with unknown type and duplicated are not loaded
+  controller_names.push_back("untyped_controller");
+  cm.set_parameter(rclcpp::Parameter("unknown_controller.type", "unknown_controller_type"));
+  controller_names.push_back("unknown_controller");
+  controller_names.push_back("test_controller_0");
+
+  const auto controllers = cm.load_controllers(controller_names, 4);
+  ASSERT_EQ(controller_names.size(), controllers.size());
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_NE(nullptr, controllers[i]);
+    EXPECT_STREQ(controller_names[i].c_str(), controllers[i]->get_lifecycle_node()->get_name());
+    EXPECT_EQ(
+      lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+      controllers[i]->get_lifecycle_node()->get_current_state().id());
+  }
+  EXPECT_EQ(nullptr, controllers[8]);
+  EXPECT_EQ(nullptr, controllers[9]);
+  EXPECT_EQ(nullptr, controllers[10]);
+  EXPECT_EQ(8u, cm.get_loaded_controllers().size());
+
+  // already loaded controllers are rejected
+  const auto reloaded = cm.load_controllers({"test_controller_1"});
+  ASSERT_EQ(1u, reloaded.size());
+  EXPECT_EQ(nullptr, reloaded[0]);
+  EXPECT_EQ(8u, cm.get_loaded_controllers().size());
+}
+
+TEST_F(TestControllerManager, preload_controller_libraries)
+{
+  controller_manager::ControllerManager cm(robot_, executor_, "test_controller_manager");
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, cm.preload_controller_libraries());
+  // preloading twice keeps the libraries loaded
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, cm.preload_controller_libraries());
+
+  ASSERT_NO_THROW(cm.load_controller("test_controller_01", test_controller::TEST_CONTROLLER_TYPE));
+  EXPECT_EQ(1u, cm.get_loaded_controllers().size());
+}
+
 TEST_F(TestControllerManager, update)
 {
   controller_manager::ControllerManager cm(robot_, executor_, "test_controller_manager");
@@ -426,3 +477,376 @@ TEST_F(TestControllerManager, switch_multiple_controllers)
       abstract_test_controller2.c->get_lifecycle_node()->get_current_state().id());
   }
 }
+
+TEST_F(TestControllerManager, switch_controllers_with_conflicting_resources)
+{
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+
+  auto position_controller = std::make_shared<test_controller::TestController>();
+  position_controller->claimed_resources = {{"position", {"joint1", "joint2"}}};
+  auto velocity_controller = std::make_shared<test_controller::TestController>();
+  velocity_controller->claimed_resources = {{"velocity", {"joint1", "joint2"}}};
+  auto joint2_position_controller = std::make_shared<test_controller::TestController>();
+  joint2_position_controller->claimed_resources = {{"position", {"joint2"}}};
+
+  cm->add_controller(position_controller, "position_controller", "test_controller");
+  cm->add_controller(velocity_controller, "velocity_controller", "test_controller");
+  cm->add_controller(joint2_position_controller, "joint2_position_controller", "test_controller");
+  ASSERT_EQ(3u, cm->get_loaded_controllers().size());
+  ASSERT_THAT(cm->get_loaded_controllers()[0].info.claimed_resources, ::testing::SizeIs(1));
+
+  const auto switch_controllers = [&cm](
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+    {
+      auto switch_future = std::async(
+        std::launch::async,
+        &controller_manager::ControllerManager::switch_controller, cm,
+        start_controllers, stop_controllers,
+        STRICT, true, rclcpp::Duration(0, 0));
+      while (switch_future.wait_for(std::chrono::milliseconds(10)) !=
+        std::future_status::ready)
+      {
+        cm->update();
+      }
+      return switch_future.get();
+    };
+
+  EXPECT_EQ(
+    controller_interface::return_type::ERROR,
+    switch_controllers({"position_controller", "joint2_position_controller"}, {})) <<
+    "Both controllers claim the position interface of joint2";
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    position_controller->get_lifecycle_node()->get_current_state().id());
+
+  EXPECT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({"position_controller", "velocity_controller"}, {})) <<
+    "Different interfaces of the same joints do not conflict";
+
+  EXPECT_EQ(
+    controller_interface::return_type::ERROR,
+    switch_controllers({"joint2_position_controller"}, {})) <<
+    "Conflicts with the running position_controller";
+
+  EXPECT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({"joint2_position_controller"}, {"position_controller"})) <<
+    "Stopping position_controller releases joint2";
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    joint2_position_controller->get_lifecycle_node()->get_current_state().id());
+}
+
+TEST_F(TestControllerManager, switch_controllers_switches_hardware_command_modes)
+{
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+
+  auto position_controller = std::make_shared<test_controller::TestController>();
+  position_controller->claimed_resources = {{"position", {"joint1"}}};
+  auto effort_controller = std::make_shared<test_controller::TestController>();
+  effort_controller->claimed_resources = {{"effort", {"joint1"}}};
+  cm->add_controller(position_controller, "position_controller", "test_controller");
+  cm->add_controller(effort_controller, "effort_controller", "test_controller");
+
+  auto switch_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::switch_controller, cm,
+    std::vector<std::string>{"position_controller"}, std::vector<std::string>{},
+    STRICT, true, rclcpp::Duration(0, 0));
+  ASSERT_EQ(
+    std::future_status::timeout,
+    switch_future.wait_for(std::chrono::milliseconds(100))) <<
+    "switch_controller should be blocking until next update cycle";
+  EXPECT_EQ(1u, robot_->prepared_command_mode_switches);
+  EXPECT_EQ(0u, robot_->performed_command_mode_switches) << "Only performed in the RT cycle";
+  cm->update();
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, switch_future.get());
+  EXPECT_EQ(1u, robot_->performed_command_mode_switches);
+  ASSERT_EQ(1u, robot_->start_interfaces.size());
+  EXPECT_EQ("position", robot_->start_interfaces[0].hardware_interface);
+  EXPECT_TRUE(robot_->stop_interfaces.empty());
+
+  // switch joint1 from position to effort control in a single cycle
+  switch_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::switch_controller, cm,
+    std::vector<std::string>{"effort_controller"}, std::vector<std::string>{"position_controller"},
+    STRICT, true, rclcpp::Duration(0, 0));
+  ASSERT_EQ(
+    std::future_status::timeout,
+    switch_future.wait_for(std::chrono::milliseconds(100)));
+  cm->update();
+  EXPECT_EQ(controller_interface::return_type::SUCCESS, switch_future.get());
+  EXPECT_EQ(2u, robot_->performed_command_mode_switches);
+  ASSERT_EQ(1u, robot_->start_interfaces.size());
+  EXPECT_EQ("effort", robot_->start_interfaces[0].hardware_interface);
+  ASSERT_EQ(1u, robot_->stop_interfaces.size());
+  EXPECT_EQ("position", robot_->stop_interfaces[0].hardware_interface);
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    effort_controller->get_lifecycle_node()->get_current_state().id());
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    position_controller->get_lifecycle_node()->get_current_state().id());
+
+  // unfeasible combinations are rejected before anything is stopped
+  robot_->fail_command_mode_switch = true;
+  EXPECT_EQ(
+    controller_interface::return_type::ERROR,
+    cm->switch_controller({"position_controller"}, {"effort_controller"}, STRICT));
+  EXPECT_EQ(2u, robot_->performed_command_mode_switches);
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    effort_controller->get_lifecycle_node()->get_current_state().id());
+}
+
+TEST_F(TestControllerManager, failed_hardware_switch_restarts_the_stopped_controllers)
+{
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+
+  auto position_controller = std::make_shared<test_controller::TestController>();
+  position_controller->claimed_resources = {{"position", {"joint1"}}};
+  auto effort_controller = std::make_shared<test_controller::TestController>();
+  effort_controller->claimed_resources = {{"effort", {"joint1"}}};
+  cm->add_controller(position_controller, "position_controller", "test_controller");
+  cm->add_controller(effort_controller, "effort_controller", "test_controller");
+
+  const auto switch_controllers = [&cm](
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+    {
+      auto switch_future = std::async(
+        std::launch::async,
+        &controller_manager::ControllerManager::switch_controller, cm,
+        start_controllers, stop_controllers,
+        STRICT, true, rclcpp::Duration(0, 0));
+      while (switch_future.wait_for(std::chrono::milliseconds(10)) !=
+        std::future_status::ready)
+      {
+        cm->update();
+      }
+      return switch_future.get();
+    };
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS, switch_controllers({"position_controller"}, {}));
+
+  // the hardware keeps position control, so does the controller manager
+  robot_->fail_perform_command_mode_switch = true;
+  EXPECT_EQ(
+    controller_interface::return_type::ERROR,
+    switch_controllers({"effort_controller"}, {"position_controller"}));
+  EXPECT_EQ(2u, robot_->performed_command_mode_switches);
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    position_controller->get_lifecycle_node()->get_current_state().id());
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    effort_controller->get_lifecycle_node()->get_current_state().id());
+
+  // the failed switch leaves nothing pending behind
+  robot_->fail_perform_command_mode_switch = false;
+  EXPECT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({"effort_controller"}, {"position_controller"}));
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+    effort_controller->get_lifecycle_node()->get_current_state().id());
+}
+
+TEST_F(TestControllerManager, chained_controllers_are_updated_in_order)
+{
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+
+  auto inner_controller = std::make_shared<test_controller::TestController>();
+  inner_controller->reference_interfaces = {{"position", {"joint1"}}};
+  auto outer_controller = std::make_shared<test_controller::TestController>();
+  outer_controller->claimed_reference_interfaces = {{"position", {"inner_controller/joint1"}}};
+  auto cyclic_controller = std::make_shared<test_controller::TestController>();
+  cyclic_controller->reference_interfaces = {{"position", {"joint1"}}};
+  cyclic_controller->claimed_reference_interfaces = {{"position", {"cyclic_controller/joint1"}}};
+
+  cm->add_controller(inner_controller, "inner_controller", "test_controller");
+  cm->add_controller(outer_controller, "outer_controller", "test_controller");
+  EXPECT_EQ(
+    nullptr, cm->add_controller(cyclic_controller, "cyclic_controller", "test_controller"));
+  auto loaded_controllers = cm->get_loaded_controllers();
+  ASSERT_EQ(2u, loaded_controllers.size());
+  EXPECT_EQ("outer_controller", loaded_controllers[0].info.name) <<
+    "Controllers writing reference interfaces are updated first";
+  EXPECT_EQ("inner_controller", loaded_controllers[1].info.name);
+
+  const auto switch_controllers = [&cm](
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+    {
+      auto switch_future = std::async(
+        std::launch::async,
+        &controller_manager::ControllerManager::switch_controller, cm,
+        start_controllers, stop_controllers,
+        STRICT, true, rclcpp::Duration(0, 0));
+      while (switch_future.wait_for(std::chrono::milliseconds(10)) !=
+        std::future_status::ready)
+      {
+        cm->update();
+      }
+      return switch_future.get();
+    };
+
+  EXPECT_EQ(
+    controller_interface::return_type::ERROR,
+    switch_controllers({"outer_controller"}, {})) <<
+    "The controller owning the reference interface is not running";
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({"outer_controller", "inner_controller"}, {}));
+
+  // the reference written by the outer controller is used by the inner one in the same cycle
+  cm->update();
+  ASSERT_THAT(inner_controller->reference_values, ::testing::SizeIs(1));
+  EXPECT_EQ(
+    static_cast<double>(outer_controller->internal_counter),
+    inner_controller->reference_values[0]);
+  cm->update();
+  EXPECT_EQ(
+    static_cast<double>(outer_controller->internal_counter),
+    inner_controller->reference_values[0]);
+
+  EXPECT_EQ(
+    controller_interface::return_type::ERROR,
+    switch_controllers({}, {"inner_controller"})) <<
+    "The running outer controller still writes the reference interface";
+  EXPECT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({}, {"inner_controller", "outer_controller"}));
+}
+
+TEST_F(TestControllerManager, chained_controllers_can_be_reconfigured)
+{
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+
+  auto inner_controller = std::make_shared<test_controller::TestController>();
+  inner_controller->reference_interfaces = {{"position", {"joint1"}}};
+  auto outer_controller = std::make_shared<test_controller::TestController>();
+  outer_controller->claimed_reference_interfaces = {{"position", {"inner_controller/joint1"}}};
+  cm->add_controller(inner_controller, "inner_controller", "test_controller");
+  cm->add_controller(outer_controller, "outer_controller", "test_controller");
+
+  const auto switch_controllers = [&cm](
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+    {
+      auto switch_future = std::async(
+        std::launch::async,
+        &controller_manager::ControllerManager::switch_controller, cm,
+        start_controllers, stop_controllers,
+        STRICT, true, rclcpp::Duration(0, 0));
+      while (switch_future.wait_for(std::chrono::milliseconds(10)) !=
+        std::future_status::ready)
+      {
+        cm->update();
+      }
+      return switch_future.get();
+    };
+
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({"outer_controller", "inner_controller"}, {}));
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({}, {"outer_controller", "inner_controller"}));
+
+  // the reference interfaces are registered again, into new storage
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED,
+    inner_controller->cleanup().id());
+  EXPECT_EQ(
+    lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE,
+    inner_controller->configure().id());
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS,
+    switch_controllers({"outer_controller", "inner_controller"}, {}));
+
+  cm->update();
+  ASSERT_THAT(inner_controller->reference_values, ::testing::SizeIs(1));
+  EXPECT_EQ(
+    static_cast<double>(outer_controller->internal_counter),
+    inner_controller->reference_values[0]);
+}
+
+TEST_F(TestControllerManager, controller_events_are_published_in_order)
+{
+  using controller_manager_msgs::msg::ControllerEvent;
+  auto cm = std::make_shared<controller_manager::ControllerManager>(
+    robot_, executor_,
+    "test_controller_manager");
+
+  auto test_controller = std::make_shared<test_controller::TestController>();
+  cm->add_controller(test_controller, "test_controller", "test_controller");
+
+  const auto switch_controllers = [&cm](
+    const std::vector<std::string> & start_controllers,
+    const std::vector<std::string> & stop_controllers)
+    {
+      auto switch_future = std::async(
+        std::launch::async,
+        &controller_manager::ControllerManager::switch_controller, cm,
+        start_controllers, stop_controllers,
+        STRICT, true, rclcpp::Duration(0, 0));
+      while (switch_future.wait_for(std::chrono::milliseconds(10)) !=
+        std::future_status::ready)
+      {
+        cm->update();
+      }
+      return switch_future.get();
+    };
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS, switch_controllers({"test_controller"}, {}));
+  ASSERT_EQ(
+    controller_interface::return_type::SUCCESS, switch_controllers({}, {"test_controller"}));
+  ASSERT_EQ(
+    controller_interface::return_type::ERROR,
+    cm->switch_controller({"unknown_controller"}, {}, STRICT));
+  ASSERT_EQ(controller_interface::return_type::SUCCESS, cm->unload_controller("test_controller"));
+
+  // the events are latched, a late subscriber still receives all of them
+  std::vector<ControllerEvent> events;
+  auto listener_node = std::make_shared<rclcpp::Node>("controller_event_listener");
+  auto subscription = listener_node->create_subscription<ControllerEvent>(
+    "/test_controller_manager/controller_events", rclcpp::QoS(100).transient_local().reliable(),
+    [&events](ControllerEvent::UniquePtr event) {events.push_back(*event);});
+  executor_->add_node(listener_node);
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (events.size() < 7u && std::chrono::steady_clock::now() < deadline) {
+    executor_->spin_some(std::chrono::milliseconds(10));
+  }
+  executor_->remove_node(listener_node);
+
+  ASSERT_EQ(7u, events.size());
+  const std::vector<std::uint8_t> expected_types = {
+    ControllerEvent::LOADED, ControllerEvent::ACTIVATED, ControllerEvent::SWITCH_SUCCEEDED,
+    ControllerEvent::DEACTIVATED, ControllerEvent::SWITCH_SUCCEEDED,
+    ControllerEvent::SWITCH_FAILED, ControllerEvent::UNLOADED};
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(i + 1, events[i].sequence);
+    EXPECT_EQ(expected_types[i], events[i].type) << "event " << i;
+  }
+  EXPECT_EQ("test_controller", events[1].controller);
+  EXPECT_EQ("active", events[1].state);
+  EXPECT_EQ("inactive", events[3].state);
+  EXPECT_THAT(events[2].start_controllers, ::testing::ElementsAre("test_controller"));
+  EXPECT_THAT(events[4].stop_controllers, ::testing::ElementsAre("test_controller"));
+  EXPECT_FALSE(events[5].message.empty());
+  EXPECT_EQ("test_controller", events[6].controller);
+}
@@ -0,0 +1,102 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "controller_manager/watchdog.hpp"
+
+using controller_manager::Watchdog;
+using namespace std::chrono_literals;
+
+TEST(TestWatchdog, stalled_phase_is_reported_while_running)
+{
+  std::promise<Watchdog::Overrun> reported;
+  std::atomic<int> reports{0};
+  Watchdog watchdog(
+    1ms, [&](const Watchdog::Overrun & overrun) {
+      if (reports++ == 0) {
+        reported.set_value(overrun);
+      }
+    });
+
+  watchdog.begin_phase(Watchdog::Phase::READ, 5ms);
+  auto future = reported.get_future();
+  ASSERT_EQ(std::future_status::ready, future.wait_for(1s));
+  const auto overrun = future.get();
+  EXPECT_EQ(Watchdog::Phase::READ, overrun.phase);
+  EXPECT_TRUE(overrun.controller.empty());
+  EXPECT_EQ(5ms, overrun.deadline);
+  EXPECT_GT(overrun.elapsed, 5ms);
+
+  // reported once per phase, however long it stalls
+  std::this_thread::sleep_for(20ms);
+  watchdog.end_phase();
+  EXPECT_EQ(1, reports);
+  EXPECT_EQ(1u, watchdog.get_overruns().size());
+  EXPECT_EQ(1u, watchdog.get_late_count(Watchdog::Phase::READ));
+  EXPECT_EQ(0u, watchdog.get_late_count(Watchdog::Phase::WRITE));
+}
+
+TEST(TestWatchdog, controller_overrun_names_the_controller)
+{
+  std::promise<Watchdog::Overrun> reported;
+  std::atomic<int> reports{0};
+  Watchdog watchdog(
+    1ms, [&](const Watchdog::Overrun & overrun) {
+      if (reports++ == 0) {
+        reported.set_value(overrun);
+      }
+    });
+  watchdog.register_controller("fast_controller");
+  const auto slow_controller = watchdog.register_controller("slow_controller");
+  EXPECT_EQ(slow_controller, watchdog.register_controller("slow_controller"));
+
+  // the update phase itself is not monitored
+  watchdog.begin_phase(Watchdog::Phase::UPDATE, 0ms);
+  watchdog.begin_controller(slow_controller, 2ms);
+  auto future = reported.get_future();
+  ASSERT_EQ(std::future_status::ready, future.wait_for(1s));
+  watchdog.end_controller();
+  watchdog.end_phase();
+
+  const auto overrun = future.get();
+  EXPECT_EQ(Watchdog::Phase::CONTROLLER, overrun.phase);
+  EXPECT_EQ("slow_controller", overrun.controller);
+  EXPECT_EQ(1u, watchdog.get_late_count(Watchdog::Phase::CONTROLLER));
+  EXPECT_EQ(0u, watchdog.get_late_count(Watchdog::Phase::UPDATE));
+}
+
+TEST(TestWatchdog, short_overruns_are_counted_by_the_realtime_thread)
+{
+  std::atomic<int> reports{0};
+  // the watchdog thread does not check before the end of the test
+  Watchdog watchdog(1h, [&](const Watchdog::Overrun &) {++reports;});
+
+  for (int i = 0; i < 3; ++i) {
+    watchdog.begin_phase(Watchdog::Phase::WRITE, 1us);
+    std::this_thread::sleep_for(1ms);
+    watchdog.begin_phase(Watchdog::Phase::READ, 1s);
+  }
+  watchdog.end_phase();
+  EXPECT_EQ(3u, watchdog.get_late_count(Watchdog::Phase::WRITE));
+  EXPECT_EQ(0u, watchdog.get_late_count(Watchdog::Phase::READ));
+  EXPECT_EQ(0, reports);
+  EXPECT_TRUE(watchdog.get_overruns().empty());
+}
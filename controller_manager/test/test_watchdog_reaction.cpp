@@ -0,0 +1,275 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller_manager/controller_manager.hpp"
+#include "controller_manager_msgs/srv/switch_controller.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/executors/multi_threaded_executor.hpp"
+#include "rclcpp/utilities.hpp"
+#include "test_controller/test_controller.hpp"
+#include "test_robot_hardware/test_robot_hardware.hpp"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr auto STRICT = controller_manager_msgs::srv::SwitchController::Request::STRICT;
+constexpr auto ACTIVE = lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE;
+constexpr auto INACTIVE = lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE;
+
+/// Blocks in read() while stalled, as on a bus timeout
+class StallingRobotHardware : public test_robot_hardware::TestRobotHardware
+{
+public:
+  hardware_interface::return_type read() override
+  {
+    while (stall) {
+      std::this_thread::sleep_for(1ms);
+    }
+    return TestRobotHardware::read();
+  }
+
+  std::atomic<bool> stall{false};
+};
+
+bool wait_until(const std::function<bool()> & condition)
+{
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+}  // namespace
+
+class TestWatchdogReaction : public ::testing::Test
+{
+public:
+  static void SetUpTestCase()
+  {
+    // the watchdog is configured on construction, from parameters of the two controller managers
+    const auto parameters_file = ::testing::TempDir() + "test_watchdog_reaction.yaml";
+    std::ofstream parameters(parameters_file);
+    parameters <<
+      "/hold_controller_manager:\n"
+      "  ros__parameters:\n"
+      "    watchdog:\n"
+      "      read_deadline: 0.02\n"
+      "      check_period: 0.001\n"
+      "      reaction: hold\n"
+      "      hold_controller: hold_controller\n"
+      "/stop_controller_manager:\n"
+      "  ros__parameters:\n"
+      "    watchdog:\n"
+      "      read_deadline: 0.02\n"
+      "      check_period: 0.001\n"
+      "      reaction: stop\n";
+    parameters.close();
+    const char * argv[] = {
+      "test_watchdog_reaction", "--ros-args", "--params-file", parameters_file.c_str()};
+    rclcpp::init(4, argv);
+  }
+
+  static void TearDownTestCase()
+  {
+    rclcpp::shutdown();
+  }
+
+  void SetUp() override
+  {
+    robot_ = std::make_shared<StallingRobotHardware>();
+    robot_->init();
+    executor_ = std::make_shared<rclcpp::executors::MultiThreadedExecutor>();
+  }
+
+  void TearDown() override
+  {
+    stop_loop();
+  }
+
+  std::shared_ptr<controller_manager::ControllerManager> make_controller_manager(
+    const std::string & name)
+  {
+    auto cm = std::make_shared<controller_manager::ControllerManager>(robot_, executor_, name);
+    position_controller_->claimed_resources = {{"position", {"joint1"}}};
+    velocity_controller_->claimed_resources = {{"velocity", {"joint2"}}};
+    hold_controller_->claimed_resources = {{"effort", {"joint1", "joint2"}}};
+    cm->add_controller(position_controller_, "position_controller", "test_controller");
+    cm->add_controller(velocity_controller_, "velocity_controller", "test_controller");
+    cm->add_controller(hold_controller_, "hold_controller", "test_controller");
+
+    auto switch_future = std::async(
+      std::launch::async,
+      &controller_manager::ControllerManager::switch_controller, cm,
+      std::vector<std::string>{"position_controller", "velocity_controller"},
+      std::vector<std::string>{}, STRICT, true, rclcpp::Duration(0, 0));
+    while (switch_future.wait_for(10ms) != std::future_status::ready) {
+      cm->update();
+    }
+    EXPECT_EQ(controller_interface::return_type::SUCCESS, switch_future.get());
+    return cm;
+  }
+
+  /// Spins the executor and runs the realtime loop, each on its own thread
+  void start_loop(std::shared_ptr<controller_manager::ControllerManager> cm)
+  {
+    cm_ = cm;
+    executor_->add_node(cm_);
+    executor_thread_ = std::thread([this]() {executor_->spin();});
+    running_ = true;
+    loop_thread_ = std::thread(
+      [this]() {
+        while (running_) {
+          cm_->read();
+          cm_->update();
+          cm_->write();
+          std::this_thread::sleep_for(1ms);
+        }
+      });
+  }
+
+  void stop_loop()
+  {
+    robot_->stall = false;
+    running_ = false;
+    if (loop_thread_.joinable()) {
+      loop_thread_.join();
+    }
+    if (executor_thread_.joinable()) {
+      executor_->cancel();
+      executor_thread_.join();
+      executor_->remove_node(cm_);
+    }
+  }
+
+  std::uint8_t state_of(const std::shared_ptr<test_controller::TestController> & controller)
+  {
+    return controller->get_current_state().id();
+  }
+
+  std::shared_ptr<StallingRobotHardware> robot_;
+  std::shared_ptr<rclcpp::Executor> executor_;
+  std::shared_ptr<controller_manager::ControllerManager> cm_;
+  std::shared_ptr<test_controller::TestController> position_controller_ =
+    std::make_shared<test_controller::TestController>();
+  std::shared_ptr<test_controller::TestController> velocity_controller_ =
+    std::make_shared<test_controller::TestController>();
+  std::shared_ptr<test_controller::TestController> hold_controller_ =
+    std::make_shared<test_controller::TestController>();
+  std::atomic<bool> running_{false};
+  std::thread loop_thread_;
+  std::thread executor_thread_;
+};
+
+TEST_F(TestWatchdogReaction, stalled_read_switches_to_the_hold_controller)
+{
+  auto cm = make_controller_manager("hold_controller_manager");
+  ASSERT_NE(nullptr, cm->get_watchdog());
+  ASSERT_EQ(1u, robot_->prepared_command_mode_switches);
+  start_loop(cm);
+
+  robot_->stall = true;
+  // prepared while the loop is stalled, without waiting for it
+  ASSERT_TRUE(wait_until([this]() {return robot_->prepared_command_mode_switches == 2u;}));
+  EXPECT_EQ(ACTIVE, state_of(position_controller_));
+  EXPECT_EQ(INACTIVE, state_of(hold_controller_));
+  EXPECT_EQ(1u, cm->get_watchdog()->get_overruns().size());
+
+  robot_->stall = false;
+  ASSERT_TRUE(wait_until([this]() {return state_of(hold_controller_) == ACTIVE;}));
+  EXPECT_EQ(INACTIVE, state_of(position_controller_));
+  EXPECT_EQ(INACTIVE, state_of(velocity_controller_));
+  stop_loop();
+  EXPECT_EQ(2u, robot_->performed_command_mode_switches);
+  ASSERT_EQ(1u, robot_->start_interfaces.size());
+  EXPECT_EQ("effort", robot_->start_interfaces[0].hardware_interface);
+  EXPECT_EQ(2u, robot_->stop_interfaces.size());
+}
+
+TEST_F(TestWatchdogReaction, stalled_read_stops_all_controllers)
+{
+  auto cm = make_controller_manager("stop_controller_manager");
+  ASSERT_NE(nullptr, cm->get_watchdog());
+  start_loop(cm);
+
+  robot_->stall = true;
+  ASSERT_TRUE(wait_until([this]() {return robot_->prepared_command_mode_switches == 2u;}));
+  EXPECT_EQ(ACTIVE, state_of(position_controller_));
+
+  robot_->stall = false;
+  ASSERT_TRUE(
+    wait_until(
+      [this]() {
+        return state_of(position_controller_) == INACTIVE &&
+        state_of(velocity_controller_) == INACTIVE;
+      }));
+  EXPECT_EQ(INACTIVE, state_of(hold_controller_));
+  stop_loop();
+  EXPECT_TRUE(robot_->start_interfaces.empty());
+}
+
+TEST_F(TestWatchdogReaction, reaction_aborts_a_pending_switch)
+{
+  auto cm = make_controller_manager("stop_controller_manager");
+  auto stop_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::switch_controller, cm,
+    std::vector<std::string>{}, std::vector<std::string>{"velocity_controller"}, STRICT, true,
+    rclcpp::Duration(0, 0));
+  while (stop_future.wait_for(10ms) != std::future_status::ready) {
+    cm->update();
+  }
+  ASSERT_EQ(controller_interface::return_type::SUCCESS, stop_future.get());
+  ASSERT_EQ(2u, robot_->prepared_command_mode_switches);
+
+  // requested before the overrun, waiting for the realtime loop
+  auto switch_future = std::async(
+    std::launch::async,
+    &controller_manager::ControllerManager::switch_controller, cm,
+    std::vector<std::string>{"velocity_controller"}, std::vector<std::string>{}, STRICT, true,
+    rclcpp::Duration(0, 0));
+  ASSERT_TRUE(wait_until([this]() {return robot_->prepared_command_mode_switches == 3u;}));
+
+  cm_ = cm;
+  executor_->add_node(cm_);
+  executor_thread_ = std::thread([this]() {executor_->spin();});
+  robot_->stall = true;
+  auto read_future = std::async(std::launch::async, [cm]() {cm->read();});
+  ASSERT_TRUE(wait_until([this]() {return robot_->prepared_command_mode_switches == 4u;}));
+  robot_->stall = false;
+  read_future.get();
+
+  cm->update();
+  EXPECT_EQ(controller_interface::return_type::ERROR, switch_future.get());
+  EXPECT_EQ(INACTIVE, state_of(position_controller_));
+  EXPECT_EQ(INACTIVE, state_of(velocity_controller_));
+  // only activated by make_controller_manager()
+  EXPECT_EQ(1u, velocity_controller_->activation_counter);
+}
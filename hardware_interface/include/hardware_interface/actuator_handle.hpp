@@ -15,6 +15,7 @@
 #ifndef HARDWARE_INTERFACE__ACTUATOR_HANDLE_HPP_
 #define HARDWARE_INTERFACE__ACTUATOR_HANDLE_HPP_
 
+#include <cstdint>
 #include <string>
 
 #include "hardware_interface/handle.hpp"
@@ -30,8 +31,8 @@ public:
   HARDWARE_INTERFACE_PUBLIC
   ActuatorHandle(
     const std::string & name, const std::string & interface_name,
-    double * value_ptr = nullptr)
-  : Handle(name, interface_name, value_ptr)
+    double * value_ptr = nullptr, std::uint8_t * written_ptr = nullptr)
+  : Handle(name, interface_name, value_ptr, written_ptr)
   {
   }
 };
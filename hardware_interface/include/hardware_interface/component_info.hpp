@@ -15,6 +15,8 @@
 #ifndef HARDWARE_INTERFACE__COMPONENT_INFO_HPP_
 #define HARDWARE_INTERFACE__COMPONENT_INFO_HPP_
 
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -22,6 +24,47 @@
 namespace hardware_interface
 {
 
+/**
+ * \brief This structure stores the value of a parameter converted at parse time.
+ * The type is given by the optional "type" attribute of the param tag, otherwise it is deduced
+ * from the text of the tag.
+ */
+struct ParameterValue
+{
+  enum class Type : std::uint8_t
+  {
+    STRING = 0,
+    BOOL = 1,
+    INTEGER = 2,
+    DOUBLE = 3,
+  };
+
+  /**
+   * \brief type of the value, determines which of the typed values is set.
+   */
+  Type type = Type::STRING;
+  /**
+   * \brief value of the parameter as written in the URDF.
+   */
+  std::string string_value;
+  /**
+   * \brief value for parameters of type BOOL.
+   */
+  bool bool_value = false;
+  /**
+   * \brief value for parameters of type INTEGER.
+   */
+  std::int64_t int_value = 0;
+  /**
+   * \brief value for parameters of type DOUBLE, also set for INTEGER.
+   */
+  double double_value = 0.0;
+  /**
+   * \brief (optional) unit of the value, e.g. "rad/s", from the "unit" attribute.
+   */
+  std::string unit;
+};
+
 /**
  * \brief This structure stores information about components defined for a specific hardware
  * in robot's URDF.
@@ -41,6 +84,14 @@ struct InterfaceInfo
    * \brief (optional) maximal allowed values of the interface.
    */
   std::string max;
+  /**
+   * \brief minimal allowed value of the interface, -infinity if min is not set.
+   */
+  double min_value = -std::numeric_limits<double>::infinity();
+  /**
+   * \brief maximal allowed value of the interface, infinity if max is not set.
+   */
+  double max_value = std::numeric_limits<double>::infinity();
 };
 
 /**
@@ -75,6 +126,10 @@ struct ComponentInfo
    * \brief (optional) key-value pairs of component parameters, e.g. min/max values or serial number.
    */
   std::unordered_map<std::string, std::string> parameters;
+  /**
+   * \brief (optional) component parameters converted to their types, same keys as parameters.
+   */
+  std::unordered_map<std::string, ParameterValue> typed_parameters;
 };
 
 }  // namespace hardware_interface
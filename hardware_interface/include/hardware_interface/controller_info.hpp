@@ -16,9 +16,9 @@
 #define HARDWARE_INTERFACE__CONTROLLER_INFO_HPP_
 
 #include <string>
-// TODO(v-lopez)
-// #include <vector>
-// #include <hardware_interface/interface_resources.h>
+#include <vector>
+
+#include "hardware_interface/interface_resources.hpp"
 
 namespace hardware_interface
 {
@@ -36,9 +36,8 @@ struct ControllerInfo
   /** Controller type. */
   std::string type;
 
-  // TODO(v-lopez)
   /** Claimed resources, grouped by the hardware interface they belong to. */
-//   std::map<std::string, std::vector<std::string>> resources;
+  std::vector<InterfaceResources> claimed_resources;
 };
 
 }  // namespace hardware_interface
@@ -15,6 +15,7 @@
 #ifndef HARDWARE_INTERFACE__HANDLE_HPP_
 #define HARDWARE_INTERFACE__HANDLE_HPP_
 
+#include <cstdint>
 #include <string>
 
 #include "hardware_interface/macros.hpp"
@@ -27,11 +28,15 @@ template<class HandleType>
 class Handle
 {
 public:
+  /**
+   * \param written_ptr (optional) flag set by every set_value(), used by the hardware to tell
+   * fresh commands from stale ones
+   */
   HARDWARE_INTERFACE_PUBLIC
   Handle(
     const std::string & name, const std::string & interface_name,
-    double * value_ptr = nullptr)
-  : name_(name), interface_name_(interface_name), value_ptr_(value_ptr)
+    double * value_ptr = nullptr, std::uint8_t * written_ptr = nullptr)
+  : name_(name), interface_name_(interface_name), value_ptr_(value_ptr), written_ptr_(written_ptr)
   {
   }
 
@@ -51,9 +56,9 @@ public:
   inline operator bool() const {return value_ptr_ != nullptr;}
 
   HARDWARE_INTERFACE_PUBLIC
-  HandleType with_value_ptr(double * value_ptr)
+  HandleType with_value_ptr(double * value_ptr, std::uint8_t * written_ptr = nullptr)
   {
-    return HandleType(name_, interface_name_, value_ptr);
+    return HandleType(name_, interface_name_, value_ptr, written_ptr);
   }
 
   HARDWARE_INTERFACE_PUBLIC
@@ -80,6 +85,7 @@ public:
   {
     THROW_ON_NULLPTR(value_ptr_);
     *value_ptr_ = value;
+    mark_written();
   }
 
   HARDWARE_INTERFACE_PUBLIC
@@ -88,6 +94,7 @@ public:
     THROW_ON_NULLPTR(value_ptr_);
     name_ = name;
     *value_ptr_ = value;
+    mark_written();
   }
 
   HARDWARE_INTERFACE_PUBLIC
@@ -96,12 +103,21 @@ public:
     THROW_ON_NULLPTR(value_ptr_);
     name_ = name;
     *value_ptr_ = value;
+    mark_written();
   }
 
 protected:
+  void mark_written()
+  {
+    if (written_ptr_) {
+      *written_ptr_ = 1;
+    }
+  }
+
   std::string name_;
   std::string interface_name_;
   double * value_ptr_;
+  std::uint8_t * written_ptr_ = nullptr;
 };
 
 }  // namespace hardware_interface
@@ -46,6 +46,11 @@ struct HardwareInfo
    * \brief (optional) key-value pairs for hardware parameters.
    */
   std::unordered_map<std::string, std::string> hardware_parameters;
+  /**
+   * \brief (optional) hardware parameters converted to their types, same keys as
+   * hardware_parameters.
+   */
+  std::unordered_map<std::string, ParameterValue> typed_hardware_parameters;
   /**
    * \brief map of joints provided by the hardware where the key is the joint name.
    * Required for Actuator and System Hardware.
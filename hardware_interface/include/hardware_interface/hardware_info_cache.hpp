@@ -0,0 +1,248 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HARDWARE_INTERFACE__HARDWARE_INFO_CACHE_HPP_
+#define HARDWARE_INTERFACE__HARDWARE_INFO_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hardware_interface/hardware_info.hpp"
+#include "hardware_interface/visibility_control.h"
+
+namespace hardware_interface
+{
+namespace cache
+{
+
+/// Version of the binary layout, bump on every incompatible change.
+constexpr std::uint32_t kFormatVersion = 2;
+
+/**
+ * \brief Compute the key under which a parsed robot description is cached.
+ *
+ * \param urdf string with robot's URDF
+ * \return 64 bit FNV-1a hash of the URDF string
+ */
+HARDWARE_INTERFACE_PUBLIC
+std::uint64_t hash_urdf(const std::string & urdf);
+
+/**
+ * \brief Serializes primitive values into a flat, host endian byte buffer.
+ */
+class Writer
+{
+public:
+  HARDWARE_INTERFACE_PUBLIC
+  void write_u32(std::uint32_t value);
+
+  HARDWARE_INTERFACE_PUBLIC
+  void write_u64(std::uint64_t value);
+
+  HARDWARE_INTERFACE_PUBLIC
+  void write_double(double value);
+
+  HARDWARE_INTERFACE_PUBLIC
+  void write_string(const std::string & value);
+
+  HARDWARE_INTERFACE_PUBLIC
+  void write_string_map(const std::unordered_map<std::string, std::string> & map);
+
+  HARDWARE_INTERFACE_PUBLIC
+  const std::string & get_buffer() const;
+
+private:
+  std::string buffer_;
+};
+
+/**
+ * \brief Reads back values written by a Writer from a (possibly memory mapped) buffer.
+ *
+ * The reader does not own the buffer, which has to outlive it.
+ * All read functions throw std::runtime_error when reading past the end of the buffer.
+ */
+class Reader
+{
+public:
+  HARDWARE_INTERFACE_PUBLIC
+  Reader(const char * data, std::size_t size);
+
+  HARDWARE_INTERFACE_PUBLIC
+  std::uint32_t read_u32();
+
+  HARDWARE_INTERFACE_PUBLIC
+  std::uint64_t read_u64();
+
+  HARDWARE_INTERFACE_PUBLIC
+  double read_double();
+
+  HARDWARE_INTERFACE_PUBLIC
+  std::string read_string();
+
+  HARDWARE_INTERFACE_PUBLIC
+  std::unordered_map<std::string, std::string> read_string_map();
+
+  /**
+   * \brief Read the number of elements of a sequence, before allocating storage for them.
+   *
+   * \param min_element_size smallest serialized size of one element
+   * \throws std::runtime_error if the remaining data cannot hold that many elements
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  std::uint32_t read_count(std::size_t min_element_size);
+
+  HARDWARE_INTERFACE_PUBLIC
+  bool at_end() const;
+
+private:
+  const char * consume(std::size_t size);
+
+  const char * data_;
+  std::size_t size_;
+  std::size_t offset_;
+};
+
+/**
+ * \brief Assembles a cache file out of tagged sections, e.g. hardware and transmission info.
+ */
+class CacheFileWriter
+{
+public:
+  HARDWARE_INTERFACE_PUBLIC
+  explicit CacheFileWriter(std::uint64_t urdf_hash);
+
+  /**
+   * \brief Add a section to the cache file.
+   *
+   * \param tag four character identifier of the section
+   * \param payload serialized content of the section
+   * \throws std::runtime_error if the tag is not four characters long or is already used
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  void add_section(const std::string & tag, const std::string & payload);
+
+  /**
+   * \brief Write the cache file to disk.
+   *
+   * \param path file to be (over)written
+   * \throws std::runtime_error if the file cannot be written
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  void write(const std::string & path) const;
+
+private:
+  std::uint64_t urdf_hash_;
+  std::vector<std::pair<std::string, std::string>> sections_;
+};
+
+/**
+ * \brief Read-only, memory mapped view of a cache file.
+ */
+class CacheFile
+{
+public:
+  /**
+   * \brief Map a cache file written by CacheFileWriter.
+   *
+   * \param path file to be mapped
+   * \throws std::runtime_error if the file cannot be opened, is truncated or was written
+   * with another format version
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  explicit CacheFile(const std::string & path);
+
+  HARDWARE_INTERFACE_PUBLIC
+  ~CacheFile();
+
+  CacheFile(const CacheFile &) = delete;
+  CacheFile & operator=(const CacheFile &) = delete;
+
+  HARDWARE_INTERFACE_PUBLIC
+  std::uint64_t get_urdf_hash() const;
+
+  /// \brief returns true if the cache was generated from the given URDF string
+  HARDWARE_INTERFACE_PUBLIC
+  bool is_valid_for(const std::string & urdf) const;
+
+  HARDWARE_INTERFACE_PUBLIC
+  bool has_section(const std::string & tag) const;
+
+  /**
+   * \brief Get a reader over the payload of a section.
+   *
+   * \param tag four character identifier of the section
+   * \return reader valid as long as this object is alive
+   * \throws std::runtime_error if there is no section with this tag
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  Reader get_section(const std::string & tag) const;
+
+private:
+  struct Section
+  {
+    std::string tag;
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  const char * data_ = nullptr;
+  std::size_t size_ = 0;
+  std::string buffer_;  // only used if memory mapping is not available
+  std::uint64_t urdf_hash_ = 0;
+  std::vector<Section> sections_;
+};
+
+}  // namespace cache
+
+/// Tag of the cache file section storing parsed HardwareInfo.
+constexpr const auto kHardwareInfoCacheSection = "HWIN";
+
+/**
+ * \brief Serialize parsed hardware information into a cache section payload.
+ *
+ * \param hardware_info hardware information as returned by parse_control_resources_from_urdf
+ * \return binary payload to be added to a cache::CacheFileWriter
+ */
+HARDWARE_INTERFACE_PUBLIC
+std::string serialize_hardware_info(const std::vector<HardwareInfo> & hardware_info);
+
+/**
+ * \brief Deserialize hardware information from a cache section payload.
+ *
+ * \param reader reader over a section written by serialize_hardware_info
+ * \return vector filled with information about robot's control resources
+ * \throws std::runtime_error if the payload is corrupted
+ */
+HARDWARE_INTERFACE_PUBLIC
+std::vector<HardwareInfo> deserialize_hardware_info(cache::Reader & reader);
+
+/**
+  * \brief Get information about control components from a cache file, falling back to parsing
+  * the URDF if the cache is missing, corrupted or was generated for another URDF.
+  *
+  * \param urdf string with robot's URDF
+  * \param cache_path cache file generated for this URDF
+  * \return vector filled with information about robot's control resources
+  * \throws std::runtime_error if the cache is unusable and a robot attribute or tag is not found
+  */
+HARDWARE_INTERFACE_PUBLIC
+std::vector<HardwareInfo> parse_control_resources_from_urdf(
+  const std::string & urdf, const std::string & cache_path);
+
+}  // namespace hardware_interface
+#endif  // HARDWARE_INTERFACE__HARDWARE_INFO_CACHE_HPP_
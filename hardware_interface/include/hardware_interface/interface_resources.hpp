@@ -0,0 +1,49 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HARDWARE_INTERFACE__INTERFACE_RESOURCES_HPP_
+#define HARDWARE_INTERFACE__INTERFACE_RESOURCES_HPP_
+
+#include <string>
+#include <vector>
+
+namespace hardware_interface
+{
+
+/** \brief Hardware interface resources
+ *
+ * Resources of a single interface type claimed by a controller, e.g. the "position"
+ * interface of joints "joint1" and "joint2".
+ *
+ */
+struct InterfaceResources
+{
+  InterfaceResources() = default;
+
+  InterfaceResources(
+    const std::string & hardware_interface,
+    const std::vector<std::string> & resources)
+  : hardware_interface(hardware_interface),
+    resources(resources)
+  {}
+
+  /** Hardware interface type, e.g. "position". */
+  std::string hardware_interface;
+
+  /** Claimed resources, e.g. joint or actuator names. */
+  std::vector<std::string> resources;
+};
+
+}  // namespace hardware_interface
+#endif  // HARDWARE_INTERFACE__INTERFACE_RESOURCES_HPP_
@@ -0,0 +1,185 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HARDWARE_INTERFACE__RECORDER_HPP_
+#define HARDWARE_INTERFACE__RECORDER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "hardware_interface/robot_hardware.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "hardware_interface/visibility_control.h"
+
+namespace hardware_interface
+{
+
+/// Options of a Recorder
+struct RecorderOptions
+{
+  /// Cycles buffered until the background thread writes them, cycles are dropped when it is full
+  std::size_t buffer_cycles = 1024;
+  /// Encode every value as the XOR to the previous one, which makes slowly changing or constant
+  /// values a few bytes each, but the file can no longer be used in place when memory-mapped
+  bool delta_compression = false;
+  /// Period of the background thread writing the buffered cycles
+  std::chrono::milliseconds write_period{10};
+};
+
+/// Records the values of all joints and actuators of a RobotHardware every cycle into a file.
+/**
+ * The values of the joints and actuators registered when the recorder is created are recorded,
+ * which includes their command interfaces. record() copies them into a preallocated ring buffer
+ * and is realtime safe, a background thread writes the buffered cycles in blocks, each storing
+ * one column per interface. The file is read with RecordingReader or replayed with
+ * ReplayRobotHardware.
+ */
+class Recorder
+{
+public:
+  /**
+   * \brief Create the file and start the background thread.
+   *
+   * \throws std::runtime_error if the file cannot be created
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  Recorder(
+    std::shared_ptr<RobotHardware> hw, const std::string & file_path,
+    const RecorderOptions & options = RecorderOptions());
+
+  /// Writes the remaining buffered cycles, see stop()
+  HARDWARE_INTERFACE_PUBLIC
+  ~Recorder();
+
+  Recorder(const Recorder &) = delete;
+  Recorder & operator=(const Recorder &) = delete;
+
+  /**
+   * \brief Record the current values, realtime safe.
+   *
+   * \param stamp time of the cycle, e.g. in nanoseconds since the epoch
+   * \return `OK`, `ERROR` if the buffer is full or the recorder was stopped and the cycle was
+   * dropped, or `INTERFACE_VALUE_SIZE_NOT_EQUAL` if joints or interfaces were registered after
+   * the recorder was created, which are not recorded
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  return_type record(std::int64_t stamp);
+
+  /// Write the remaining buffered cycles, stop the background thread and close the file.
+  HARDWARE_INTERFACE_PUBLIC
+  void stop();
+
+  /// Number of cycles written to the file
+  HARDWARE_INTERFACE_PUBLIC
+  std::uint64_t get_written_cycles() const;
+
+  /// Number of cycles dropped because the buffer was full
+  HARDWARE_INTERFACE_PUBLIC
+  std::uint64_t get_dropped_cycles() const;
+
+private:
+  void write_loop();
+  /// Write all buffered cycles as one block
+  void write_buffered_cycles();
+
+  std::shared_ptr<RobotHardware> hw_;
+  RecorderOptions options_;
+  std::ofstream file_;
+
+  /// Layout of the recording, the values are the copy of the current cycle
+  control_msgs::msg::DynamicJointState joint_state_;
+  control_msgs::msg::DynamicJointState actuator_state_;
+  std::size_t value_count_ = 0;
+
+  /// Ring buffer of options_.buffer_cycles cycles, filled by record() and drained by the
+  /// background thread
+  std::vector<std::int64_t> stamps_;
+  std::vector<double> values_;
+  std::atomic<std::uint64_t> head_{0};
+  std::atomic<std::uint64_t> tail_{0};
+  std::atomic<std::uint64_t> written_cycles_{0};
+  std::atomic<std::uint64_t> dropped_cycles_{0};
+
+  /// Block being written and a column of it, only used by the background thread
+  std::vector<char> block_;
+  std::vector<double> column_;
+
+  std::mutex stop_mutex_;
+  std::condition_variable stop_condition_;
+  bool stop_requested_ = false;
+  std::atomic<bool> stopped_{false};
+  std::thread write_thread_;
+};
+
+/// Reads a file written by Recorder cycle by cycle.
+class RecordingReader
+{
+public:
+  /**
+   * \brief Open a recording and read its layout.
+   *
+   * \throws std::runtime_error if the file cannot be opened or is not a recording
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  explicit RecordingReader(const std::string & file_path);
+
+  /// Recorded joints and their interfaces, with all values zero
+  HARDWARE_INTERFACE_PUBLIC
+  const control_msgs::msg::DynamicJointState & get_joint_state() const;
+
+  /// Recorded actuators and their interfaces, with all values zero
+  HARDWARE_INTERFACE_PUBLIC
+  const control_msgs::msg::DynamicJointState & get_actuator_state() const;
+
+  /**
+   * \brief Read the next cycle.
+   *
+   * \param[out] stamp time of the cycle as passed to Recorder::record()
+   * \param[in,out] joint_state copy of get_joint_state(), only values are written
+   * \param[in,out] actuator_state copy of get_actuator_state(), only values are written
+   * \return false at the end of the recording
+   * \throws std::runtime_error if the file is truncated or corrupted
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  bool next(
+    std::int64_t & stamp, control_msgs::msg::DynamicJointState & joint_state,
+    control_msgs::msg::DynamicJointState & actuator_state);
+
+private:
+  bool read_block();
+
+  std::ifstream file_;
+  control_msgs::msg::DynamicJointState joint_state_;
+  control_msgs::msg::DynamicJointState actuator_state_;
+  std::size_t value_count_ = 0;
+
+  /// Current block, decoded into rows of one cycle each
+  std::vector<char> block_;
+  std::vector<std::int64_t> stamps_;
+  std::vector<double> values_;
+  std::size_t next_cycle_ = 0;
+};
+
+}  // namespace hardware_interface
+
+#endif  // HARDWARE_INTERFACE__RECORDER_HPP_
@@ -0,0 +1,94 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HARDWARE_INTERFACE__REPLAY_ROBOT_HARDWARE_HPP_
+#define HARDWARE_INTERFACE__REPLAY_ROBOT_HARDWARE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "hardware_interface/actuator_handle.hpp"
+#include "hardware_interface/joint_handle.hpp"
+#include "hardware_interface/recorder.hpp"
+#include "hardware_interface/robot_hardware.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "hardware_interface/visibility_control.h"
+
+namespace hardware_interface
+{
+
+/// Robot hardware feeding the cycles of a recording back through read().
+/**
+ * init() registers the joints and actuators of the recording with their interfaces, every read()
+ * sets their values to the next recorded cycle. This reproduces what the controllers saw on the
+ * robot, independent of the timing of the replay.
+ *
+ * Command interfaces, whose names end in "_command", are written by the controllers and are only
+ * replayed if requested, the recorded commands are available with get_recorded_joint_state() to
+ * compare against.
+ */
+class ReplayRobotHardware : public RobotHardware
+{
+public:
+  /**
+   * \param file_path recording written by Recorder
+   * \param replay_commands also set the command interfaces to the recorded values
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  explicit ReplayRobotHardware(const std::string & file_path, bool replay_commands = false);
+
+  /// Open the recording and register its joints and actuators, ERROR if it cannot be read
+  HARDWARE_INTERFACE_PUBLIC
+  return_type init() override;
+
+  /// Set the values to the next cycle, ERROR at the end of the recording
+  HARDWARE_INTERFACE_PUBLIC
+  return_type read() override;
+
+  /// Commands are not sent anywhere
+  HARDWARE_INTERFACE_PUBLIC
+  return_type write() override;
+
+  /// Time of the cycle of the last read() as recorded
+  HARDWARE_INTERFACE_PUBLIC
+  std::int64_t get_stamp() const;
+
+  /// Values of all recorded joint interfaces in the cycle of the last read()
+  HARDWARE_INTERFACE_PUBLIC
+  const control_msgs::msg::DynamicJointState & get_recorded_joint_state() const;
+
+  /// Values of all recorded actuator interfaces in the cycle of the last read()
+  HARDWARE_INTERFACE_PUBLIC
+  const control_msgs::msg::DynamicJointState & get_recorded_actuator_state() const;
+
+private:
+  std::string file_path_;
+  bool replay_commands_;
+  std::unique_ptr<RecordingReader> reader_;
+  std::int64_t stamp_ = 0;
+  control_msgs::msg::DynamicJointState joint_state_;
+  control_msgs::msg::DynamicJointState actuator_state_;
+
+  /// Recorded values and the handles of the registered interfaces they are replayed into
+  std::vector<std::pair<const double *, JointHandle>> replayed_joint_values_;
+  std::vector<std::pair<const double *, ActuatorHandle>> replayed_actuator_values_;
+};
+
+}  // namespace hardware_interface
+
+#endif  // HARDWARE_INTERFACE__REPLAY_ROBOT_HARDWARE_HPP_
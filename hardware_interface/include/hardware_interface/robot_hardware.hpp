@@ -15,6 +15,7 @@
 #ifndef HARDWARE_INTERFACE__ROBOT_HARDWARE_HPP_
 #define HARDWARE_INTERFACE__ROBOT_HARDWARE_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,6 +30,17 @@
 
 namespace hardware_interface
 {
+
+/// Safe value given to the commands of a joint which were not written for too long
+enum class CommandTimeoutPolicy : std::uint8_t
+{
+  /// "position_command" is set to the measured "position", all other commands to zero
+  HOLD = 0,
+  /// All commands are set to zero, only for joints without "position_command", e.g. velocity or
+  /// effort controlled joints
+  ZERO = 1,
+};
+
 class RobotHardware : public RobotHardwareInterface
 {
 public:
@@ -100,11 +112,87 @@ public:
   HARDWARE_INTERFACE_PUBLIC
   std::vector<JointHandle> get_registered_joints();
 
+  /// Get the registered actuators with their interfaces and current values.
+  /**
+   * The returned message can be copied once to preallocate a buffer for copy_actuator_values().
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  const control_msgs::msg::DynamicJointState & get_registered_actuator_state() const;
+
+  /// Get the registered joints with their interfaces and current values.
+  /**
+   * The returned message can be copied once to preallocate a buffer for copy_joint_values().
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  const control_msgs::msg::DynamicJointState & get_registered_joint_state() const;
+
+  /// Copy the current values of all registered actuators, without allocating memory.
+  /**
+   * \param[in,out] actuator_state copy of get_registered_actuator_state(), only values are written.
+   * \return `OK`, or `INTERFACE_VALUE_SIZE_NOT_EQUAL` if actuators or interfaces were registered
+   * after \p actuator_state was copied.
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  hardware_interface_ret_t copy_actuator_values(
+    control_msgs::msg::DynamicJointState & actuator_state) const;
+
+  /// Copy the current values of all registered joints, without allocating memory.
+  /**
+   * \param[in,out] joint_state copy of get_registered_joint_state(), only values are written.
+   * \return `OK`, or `INTERFACE_VALUE_SIZE_NOT_EQUAL` if joints or interfaces were registered
+   * after \p joint_state was copied.
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  hardware_interface_ret_t copy_joint_values(
+    control_msgs::msg::DynamicJointState & joint_state) const;
+
+  /// Replace the commands of a joint with a safe value once they go stale.
+  /**
+   * Every "_command" interface of the joint is monitored. A command is stale once no handle set
+   * it during more than \p timeout_cycles calls of enforce_command_timeouts(). It is then set to
+   * the value given by \p policy once, and is fresh again as soon as a handle sets it.
+   * Pointers to the registered values are kept, so the joint must not get further interfaces.
+   * A "position_command" is never set to zero, which would move the joint to the zero position.
+   * Timeouts are not read from the URDF, the robot sets them up in init() once its joints are
+   * registered.
+   * \return `OK`, or `ERROR` if the joint has no registered command interfaces, or has a
+   * "position_command" and either the policy is not `HOLD` or it has no "position" to hold.
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  return_type set_command_timeout(
+    const std::string & joint_name, std::uint64_t timeout_cycles, CommandTimeoutPolicy policy);
+
+  /// Count a write cycle and replace the commands that went stale, realtime safe.
+  /**
+   * Called by the controller manager before every write(). Runs over flat arrays of the monitored
+   * commands, without looking up names or calling virtual functions.
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  void enforce_command_timeouts();
+
+  /// Number of monitored commands which are currently stale
+  HARDWARE_INTERFACE_PUBLIC
+  std::size_t get_stale_command_count() const;
+
 private:
   std::vector<OperationModeHandle *> registered_operation_mode_handles_;
 
   control_msgs::msg::DynamicJointState registered_actuators_;
   control_msgs::msg::DynamicJointState registered_joints_;
+  /// Set by the handles of the registered joint values on every write, same layout as the values
+  std::vector<std::vector<std::uint8_t>> joint_written_flags_;
+
+  /// Monitored commands, one element per command in each of the arrays
+  std::vector<std::size_t> timeout_joints_;
+  std::vector<double *> timeout_values_;
+  std::vector<std::uint8_t *> timeout_written_flags_;
+  /// Value given to a stale command, zero if nullptr
+  std::vector<const double *> timeout_hold_values_;
+  /// Last cycle in which the command was written
+  std::vector<std::uint64_t> timeout_stamps_;
+  std::vector<std::uint64_t> timeout_cycles_;
+  std::vector<std::uint8_t> timeout_stale_;
+  std::uint64_t command_cycle_ = 0;
 };
 
 using RobotHardwareSharedPtr = std::shared_ptr<RobotHardware>;
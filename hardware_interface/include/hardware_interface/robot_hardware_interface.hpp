@@ -15,6 +15,9 @@
 #ifndef HARDWARE_INTERFACE__ROBOT_HARDWARE_INTERFACE_HPP_
 #define HARDWARE_INTERFACE__ROBOT_HARDWARE_INTERFACE_HPP_
 
+#include <vector>
+
+#include "hardware_interface/interface_resources.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/visibility_control.h"
 
@@ -42,6 +45,52 @@ public:
   HARDWARE_INTERFACE_PUBLIC
   virtual
   return_type write() = 0;
+
+  /**
+   * \brief Prepare a change of the command interfaces used by the running controllers,
+   * e.g. switching a joint from position to effort control.
+   *
+   * Called from the non-realtime thread before the switch is requested,
+   * may allocate and block. Nothing must change on the hardware yet.
+   *
+   * \param start_interfaces interfaces claimed by the controllers being started
+   * \param stop_interfaces interfaces claimed by the controllers being stopped
+   * \return OK if the new combination of interfaces is feasible, ERROR otherwise
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  virtual
+  return_type prepare_command_mode_switch(
+    const std::vector<InterfaceResources> & start_interfaces,
+    const std::vector<InterfaceResources> & stop_interfaces)
+  {
+    (void) start_interfaces;
+    (void) stop_interfaces;
+    return return_type::OK;
+  }
+
+  /**
+   * \brief Perform the switch prepared by prepare_command_mode_switch().
+   *
+   * Called from the realtime thread in the cycle in which the controllers are stopped and
+   * started, after the stopped controllers have been deactivated and before the started ones
+   * are activated. Must not allocate or block.
+   *
+   * \param start_interfaces interfaces claimed by the controllers being started
+   * \param stop_interfaces interfaces claimed by the controllers being stopped
+   * \return OK if the hardware switched, ERROR if it did not and kept the previous command
+   * modes, in which case the controller manager starts the stopped controllers again instead of
+   * the requested ones
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  virtual
+  return_type perform_command_mode_switch(
+    const std::vector<InterfaceResources> & start_interfaces,
+    const std::vector<InterfaceResources> & stop_interfaces)
+  {
+    (void) start_interfaces;
+    (void) stop_interfaces;
+    return return_type::OK;
+  }
 };
 
 }  // namespace hardware_interface
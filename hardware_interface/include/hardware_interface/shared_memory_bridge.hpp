@@ -0,0 +1,190 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HARDWARE_INTERFACE__SHARED_MEMORY_BRIDGE_HPP_
+#define HARDWARE_INTERFACE__SHARED_MEMORY_BRIDGE_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "hardware_interface/actuator_handle.hpp"
+#include "hardware_interface/joint_handle.hpp"
+#include "hardware_interface/robot_hardware.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "hardware_interface/visibility_control.h"
+
+/**
+ * Exchange of the joint and actuator values with a driver running in another process through a
+ * POSIX shared memory segment, Linux only.
+ *
+ * The driver creates the segment with SharedMemoryDriver, describing its joints and actuators
+ * like RobotHardware stores them. Interfaces whose names end in "_command" are commands, written
+ * by SharedMemoryRobotHardware::write() and read by the driver, all others are states written by
+ * the driver and read by SharedMemoryRobotHardware::read(). Each direction is a seqlock, so the
+ * reader always gets all values of one write without blocking the writer, and waiting for new
+ * values uses a futex on the sequence, woken by the writer only if someone waits.
+ */
+
+namespace hardware_interface
+{
+
+struct SharedMemorySegmentHeader;
+
+/// Mapping of a shared memory segment, unmapped when destroyed
+class SharedMemoryMapping
+{
+public:
+  SharedMemoryMapping() = default;
+  SharedMemoryMapping(const SharedMemoryMapping &) = delete;
+  SharedMemoryMapping & operator=(const SharedMemoryMapping &) = delete;
+
+  HARDWARE_INTERFACE_PUBLIC
+  ~SharedMemoryMapping();
+
+  /// Map a new segment, replacing an existing one of the same name, throws std::runtime_error
+  HARDWARE_INTERFACE_PUBLIC
+  void create(const std::string & name, std::size_t size);
+  /// Map an existing segment, throws std::runtime_error
+  HARDWARE_INTERFACE_PUBLIC
+  void open(const std::string & name);
+
+  SharedMemorySegmentHeader * header() const
+  {
+    return header_;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  SharedMemorySegmentHeader * header_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+/// Driver side of the bridge, used by the process talking to the hardware.
+class SharedMemoryDriver
+{
+public:
+  /**
+   * \brief Create the segment, replacing an existing one of the same name.
+   *
+   * \param segment_name name of the segment, e.g. "/my_robot"
+   * \param joint_state joints with their interfaces and initial values
+   * \param actuator_state actuators with their interfaces and initial values
+   * \throws std::runtime_error if the segment cannot be created
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  SharedMemoryDriver(
+    const std::string & segment_name,
+    const control_msgs::msg::DynamicJointState & joint_state,
+    const control_msgs::msg::DynamicJointState & actuator_state);
+
+  /// Removes the segment, mappings of other processes stay valid
+  HARDWARE_INTERFACE_PUBLIC
+  ~SharedMemoryDriver();
+
+  SharedMemoryDriver(const SharedMemoryDriver &) = delete;
+  SharedMemoryDriver & operator=(const SharedMemoryDriver &) = delete;
+
+  /// States as "<component>/<interface>", in the order of the values of write_states()
+  HARDWARE_INTERFACE_PUBLIC
+  const std::vector<std::string> & get_state_names() const;
+
+  /// Commands as "<component>/<interface>", in the order of the values of read_commands()
+  HARDWARE_INTERFACE_PUBLIC
+  const std::vector<std::string> & get_command_names() const;
+
+  /**
+   * \brief Publish new states, realtime safe.
+   *
+   * \param states one value per state name
+   * \return `OK`, or `INTERFACE_VALUE_SIZE_NOT_EQUAL` if the number of values is wrong
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  return_type write_states(const std::vector<double> & states);
+
+  /**
+   * \brief Copy the latest commands, realtime safe.
+   *
+   * \param[out] commands one value per command name, must already have that size
+   * \param timeout time to wait for commands newer than those of the previous call, zero to
+   * return the latest commands right away
+   * \return `OK`, `ERROR` if no newer commands were written within \p timeout, or
+   * `INTERFACE_VALUE_SIZE_NOT_EQUAL` if \p commands has the wrong size
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  return_type read_commands(
+    std::vector<double> & commands,
+    std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0));
+
+private:
+  std::string segment_name_;
+  SharedMemoryMapping mapping_;
+  std::vector<std::string> state_names_;
+  std::vector<std::string> command_names_;
+  std::uint32_t last_command_sequence_ = 0;
+};
+
+/// Robot hardware exchanging its values with a SharedMemoryDriver in another process.
+/**
+ * init() opens the segment and registers the joints and actuators of the driver.
+ */
+class SharedMemoryRobotHardware : public RobotHardware
+{
+public:
+  /**
+   * \param segment_name name of the segment created by the driver
+   * \param read_timeout time read() waits for states newer than those of the previous read(),
+   * zero to use the latest states right away
+   */
+  HARDWARE_INTERFACE_PUBLIC
+  explicit SharedMemoryRobotHardware(
+    const std::string & segment_name,
+    std::chrono::nanoseconds read_timeout = std::chrono::nanoseconds(0));
+
+  /// Open the segment and register its joints and actuators, ERROR if it cannot be opened
+  HARDWARE_INTERFACE_PUBLIC
+  return_type init() override;
+
+  /// Copy the latest states of the driver, ERROR if none arrived within the read timeout
+  HARDWARE_INTERFACE_PUBLIC
+  return_type read() override;
+
+  /// Hand the commands to the driver and wake it up
+  HARDWARE_INTERFACE_PUBLIC
+  return_type write() override;
+
+private:
+  std::string segment_name_;
+  std::chrono::nanoseconds read_timeout_;
+  SharedMemoryMapping mapping_;
+  std::uint32_t last_state_sequence_ = 0;
+
+  /// Handles of the registered values in the order of the segment, taken once all are registered
+  std::vector<JointHandle> joint_state_handles_;
+  std::vector<ActuatorHandle> actuator_state_handles_;
+  std::vector<JointHandle> joint_command_handles_;
+  std::vector<ActuatorHandle> actuator_command_handles_;
+  std::vector<double> states_;
+  std::vector<double> commands_;
+};
+
+}  // namespace hardware_interface
+
+#endif  // HARDWARE_INTERFACE__SHARED_MEMORY_BRIDGE_HPP_
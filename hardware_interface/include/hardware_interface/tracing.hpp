@@ -0,0 +1,130 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HARDWARE_INTERFACE__TRACING_HPP_
+#define HARDWARE_INTERFACE__TRACING_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "hardware_interface/visibility_control.h"
+
+namespace hardware_interface
+{
+/**
+ * In-memory tracing of the control loop, e.g. read, the update of every controller and write.
+ *
+ * Every thread records into its own lock-free ring buffer, which is allocated on the first
+ * event of the thread or by register_thread(). Recording is wait-free and does not allocate;
+ * events are dropped when the buffer is full. A non-realtime thread drains all buffers with
+ * write_chrome_trace(), whose output can be opened in chrome://tracing or ui.perfetto.dev.
+ */
+namespace tracing
+{
+
+/// Number of events buffered per thread until they are drained
+constexpr std::uint32_t kBufferCapacity = 1u << 14u;
+/// Longer event names are truncated
+constexpr std::uint32_t kMaxNameLength = 47u;
+
+/// Enables or disables recording for all threads, disabled by default
+HARDWARE_INTERFACE_PUBLIC
+void set_enabled(bool enabled);
+
+HARDWARE_INTERFACE_PUBLIC
+bool is_enabled();
+
+/**
+ * \brief Allocate the buffer of the calling thread ahead of its first event.
+ *
+ * \param thread_name name shown for the thread in the trace, copied
+ */
+HARDWARE_INTERFACE_PUBLIC
+void register_thread(const char * thread_name);
+
+/// Monotonic time used for the events, in nanoseconds
+inline std::int64_t now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * \brief Record an event of the calling thread.
+ *
+ * \param name name of the event, copied
+ * \param category static string grouping the events, e.g. "controller", not copied
+ * \param start start of the event as returned by now()
+ * \param end end of the event as returned by now()
+ */
+HARDWARE_INTERFACE_PUBLIC
+void record(const char * name, const char * category, std::int64_t start, std::int64_t end);
+
+/// Statistics of a drain
+struct DrainResult
+{
+  std::uint64_t events = 0;
+  /// Events dropped since the previous drain because a buffer was full
+  std::uint64_t dropped_events = 0;
+};
+
+/**
+ * \brief Drain the events of all threads and write them as Chrome trace JSON.
+ *
+ * Not realtime safe. The events are removed from the buffers, concurrent drains are serialized.
+ * \param out stream receiving the JSON document
+ */
+HARDWARE_INTERFACE_PUBLIC
+DrainResult write_chrome_trace(std::ostream & out);
+
+/**
+ * \brief Records the lifetime of the scope as an event, if tracing is enabled when entering it.
+ *
+ * \code
+ * {
+ *   hardware_interface::tracing::Scope trace_scope("read", "hardware");
+ *   ...
+ * }
+ * \endcode
+ */
+class Scope
+{
+public:
+  /// The name is copied when leaving the scope and must be valid until then
+  Scope(const char * name, const char * category)
+  : name_(name), category_(category), start_(is_enabled() ? now() : -1)
+  {
+  }
+
+  ~Scope()
+  {
+    if (start_ >= 0) {
+      record(name_, category_, start_, now());
+    }
+  }
+
+  Scope(const Scope &) = delete;
+  Scope & operator=(const Scope &) = delete;
+
+private:
+  const char * name_;
+  const char * category_;
+  std::int64_t start_;
+};
+
+}  // namespace tracing
+}  // namespace hardware_interface
+
+#endif  // HARDWARE_INTERFACE__TRACING_HPP_
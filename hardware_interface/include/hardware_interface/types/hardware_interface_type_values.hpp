@@ -15,11 +15,25 @@
 #ifndef HARDWARE_INTERFACE__TYPES__HARDWARE_INTERFACE_TYPE_VALUES_HPP_
 #define HARDWARE_INTERFACE__TYPES__HARDWARE_INTERFACE_TYPE_VALUES_HPP_
 
+#include <cstring>
+#include <string>
+
 namespace hardware_interface
 {
 constexpr const auto HW_IF_POSITION = "position";
 constexpr const auto HW_IF_VELOCITY = "velocity";
 constexpr const auto HW_IF_EFFORT = "effort";
+/// Suffix of the registered interfaces which hold commands, e.g. "position_command"
+constexpr const auto HW_IF_COMMAND_SUFFIX = "_command";
+
+/// Whether the registered interface holds a command rather than a state
+inline bool is_command_interface(const std::string & interface_name)
+{
+  const auto suffix_size = std::strlen(HW_IF_COMMAND_SUFFIX);
+  return interface_name.size() >= suffix_size &&
+         interface_name.compare(
+    interface_name.size() - suffix_size, suffix_size, HW_IF_COMMAND_SUFFIX) == 0;
+}
 }  // namespace hardware_interface
 
 #endif  // HARDWARE_INTERFACE__TYPES__HARDWARE_INTERFACE_TYPE_VALUES_HPP_
@@ -13,6 +13,11 @@
 // limitations under the License.
 
 #include <tinyxml2.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -36,6 +41,12 @@ constexpr const auto kCommandInterfaceTypeTag = "commandInterfaceType";
 constexpr const auto kStateInterfaceTypeTag = "stateInterfaceType";
 constexpr const auto kMinTag = "min";
 constexpr const auto kMaxTag = "max";
+constexpr const auto kTypeAttribute = "type";
+constexpr const auto kUnitAttribute = "unit";
+constexpr const auto kStringType = "string";
+constexpr const auto kBoolType = "bool";
+constexpr const auto kIntType = "int";
+constexpr const auto kDoubleType = "double";
 }  // namespace
 
 namespace hardware_interface
@@ -103,15 +114,157 @@ std::string get_attribute_value(
   return get_attribute_value(element_it, attribute_name, std::string(tag_name));
 }
 
+/**
+ * \brief Converts a string to a bool, accepting "true" and "false" in any capitalization.
+ *
+ * \param text string to convert
+ * \param[out] value converted value
+ * \return true if the whole string could be converted
+ */
+bool parse_bool(const std::string & text, bool & value)
+{
+  std::string lower_text = text;
+  std::transform(lower_text.begin(), lower_text.end(), lower_text.begin(), ::tolower);
+  if (lower_text == "true") {
+    value = true;
+    return true;
+  }
+  if (lower_text == "false") {
+    value = false;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * \brief Checks if a string starts with whitespace, which strtoll and strtod would skip.
+ */
+bool starts_with_space(const std::string & text)
+{
+  return !text.empty() && std::isspace(static_cast<unsigned char>(text.front()));
+}
+
+/**
+ * \brief Converts a string to an integer, leading and trailing garbage is not accepted.
+ *
+ * \param text string to convert
+ * \param[out] value converted value
+ * \return true if the whole string could be converted without overflow
+ */
+bool parse_int(const std::string & text, std::int64_t & value)
+{
+  if (text.empty() || starts_with_space(text)) {
+    return false;
+  }
+  char * end = nullptr;
+  errno = 0;
+  const auto result = std::strtoll(text.c_str(), &end, 10);
+  if (errno == ERANGE || *end != '\0') {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+/**
+ * \brief Converts a string to a finite double, leading and trailing garbage is not accepted.
+ * NaN and infinities are rejected, written or resulting from an overflow, so that limits and
+ * parameters are always usable numbers, an unbounded limit is left out instead. Values too small
+ * for a normal double are accepted.
+ *
+ * \param text string to convert
+ * \param[out] value converted value
+ * \return true if the whole string could be converted to a finite number
+ */
+bool parse_double(const std::string & text, double & value)
+{
+  if (text.empty() || starts_with_space(text)) {
+    return false;
+  }
+  char * end = nullptr;
+  // an underflow also sets ERANGE but returns a denormal or zero, only the overflow to
+  // +-HUGE_VAL is an error
+  const auto result = std::strtod(text.c_str(), &end);
+  if (*end != '\0' || !std::isfinite(result)) {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+/**
+ * \brief Converts the text of a param tag to a typed value.
+ * If the tag has a type attribute the text has to be convertible to this type, otherwise the
+ * type is deduced trying bool, integer and double before falling back to string.
+ *
+ * \param param_it pointer to the param tag
+ * \param parameter_name name of the parameter (used for error output)
+ * \param text text of the param tag
+ * \return typed value of the parameter
+ * \throws std::runtime_error if the text cannot be converted to the requested type
+ */
+ParameterValue parse_parameter_value(
+  const tinyxml2::XMLElement * param_it, const std::string & parameter_name,
+  const std::string & text)
+{
+  ParameterValue value;
+  value.string_value = text;
+  const auto * unit = param_it->Attribute(kUnitAttribute);
+  if (unit) {
+    value.unit = unit;
+  }
+
+  const auto * type = param_it->Attribute(kTypeAttribute);
+  if (!type) {
+    if (parse_bool(text, value.bool_value)) {
+      value.type = ParameterValue::Type::BOOL;
+    } else if (parse_int(text, value.int_value)) {
+      value.type = ParameterValue::Type::INTEGER;
+      value.double_value = static_cast<double>(value.int_value);
+    } else if (parse_double(text, value.double_value)) {
+      value.type = ParameterValue::Type::DOUBLE;
+    }
+    return value;
+  }
+
+  const std::string type_name = type;
+  bool valid = true;
+  if (type_name == kStringType) {
+    value.type = ParameterValue::Type::STRING;
+  } else if (type_name == kBoolType) {
+    value.type = ParameterValue::Type::BOOL;
+    valid = parse_bool(text, value.bool_value);
+  } else if (type_name == kIntType) {
+    value.type = ParameterValue::Type::INTEGER;
+    valid = parse_int(text, value.int_value);
+    value.double_value = static_cast<double>(value.int_value);
+  } else if (type_name == kDoubleType) {
+    value.type = ParameterValue::Type::DOUBLE;
+    valid = parse_double(text, value.double_value);
+  } else {
+    throw std::runtime_error(
+            "unknown type '" + type_name + "' for parameter " + parameter_name +
+            ", expected one of string, bool, int or double");
+  }
+  if (!valid) {
+    throw std::runtime_error(
+            "value '" + text + "' of parameter " + parameter_name + " is not a valid " + type_name);
+  }
+  return value;
+}
+
 /**
  * \brief Search XML snippet from URDF for parameters.
  *
  * \param params_it pointer to the iterator where parameters info should be found
+ * \param[out] typed_parameters key-value map with parameters converted to their types
  * \return std::map< std::__cxx11::string, std::__cxx11::string > key-value map with parameters
- * \throws std::runtime_error if a component attribute or tag is not found
+ * \throws std::runtime_error if a component attribute or tag is not found or a parameter
+ * cannot be converted to its type
  */
 std::unordered_map<std::string, std::string> parse_parameters_from_xml(
-  const tinyxml2::XMLElement * params_it)
+  const tinyxml2::XMLElement * params_it,
+  std::unordered_map<std::string, ParameterValue> & typed_parameters)
 {
   std::unordered_map<std::string, std::string> parameters;
   const tinyxml2::XMLAttribute * attr;
@@ -125,12 +278,44 @@ std::unordered_map<std::string, std::string> parse_parameters_from_xml(
     const std::string parameter_name = params_it->Attribute("name");
     const std::string parameter_value = get_text_for_element(params_it, parameter_name);
     parameters[parameter_name] = parameter_value;
+    typed_parameters[parameter_name] =
+      parse_parameter_value(params_it, parameter_name, parameter_value);
 
     params_it = params_it->NextSiblingElement(kParamTag);
   }
   return parameters;
 }
 
+/**
+ * \brief Gets the numeric value of an optional min/max interface parameter.
+ *
+ * \param interface_params typed parameters of the interface
+ * \param limit_tag name of the parameter, min or max
+ * \param interface_name name of the interface (used for error output)
+ * \param[out] text value as written in the URDF, unchanged if the parameter is not set
+ * \param[out] value numeric value, unchanged if the parameter is not set
+ * \throws std::runtime_error if the parameter is not a number
+ */
+void parse_interface_limit(
+  const std::unordered_map<std::string, ParameterValue> & interface_params,
+  const char * limit_tag, const std::string & interface_name, std::string & text, double & value)
+{
+  const auto interface_param = interface_params.find(limit_tag);
+  if (interface_param == interface_params.end()) {
+    return;
+  }
+  const auto & parameter = interface_param->second;
+  if (parameter.type != ParameterValue::Type::DOUBLE &&
+    parameter.type != ParameterValue::Type::INTEGER)
+  {
+    throw std::runtime_error(
+            std::string(limit_tag) + " value '" + parameter.string_value + "' of interface " +
+            interface_name + " is not a number");
+  }
+  text = parameter.string_value;
+  value = parameter.double_value;
+}
+
 /**
  * \brief Search XML snippet for definition of interfaceTypes.
  *
@@ -155,16 +340,16 @@ std::vector<InterfaceInfo> parse_interfaces_from_xml(
       interface.name = interface_name;
 
       // Optional min/max attributes
-      std::unordered_map<std::string, std::string> interface_params =
-        parse_parameters_from_xml(interfaces_it->FirstChildElement(kParamTag));
-      std::unordered_map<std::string, std::string>::const_iterator interface_param =
-        interface_params.find(kMinTag);
-      if (interface_param != interface_params.end()) {
-        interface.min = interface_param->second;
-      }
-      interface_param = interface_params.find(kMaxTag);
-      if (interface_param != interface_params.end()) {
-        interface.max = interface_param->second;
+      std::unordered_map<std::string, ParameterValue> interface_params;
+      parse_parameters_from_xml(interfaces_it->FirstChildElement(kParamTag), interface_params);
+      parse_interface_limit(
+        interface_params, kMinTag, interface_name, interface.min, interface.min_value);
+      parse_interface_limit(
+        interface_params, kMaxTag, interface_name, interface.max, interface.max_value);
+      if (interface.min_value > interface.max_value) {
+        throw std::runtime_error(
+                "min value " + interface.min + " is greater than max value " + interface.max +
+                " for interface " + interface_name);
       }
     }
     // State interfaces have an element to define the type, not a name attribute
@@ -220,7 +405,7 @@ ComponentInfo parse_component_from_xml(const tinyxml2::XMLElement * component_it
   // Parse paramter tags
   const auto * params_it = component_it->FirstChildElement(kParamTag);
   if (params_it) {
-    component.parameters = parse_parameters_from_xml(params_it);
+    component.parameters = parse_parameters_from_xml(params_it, component.typed_parameters);
   }
 
   return component;
@@ -249,7 +434,8 @@ HardwareInfo parse_resource_from_xml(const tinyxml2::XMLElement * ros2_control_i
         type_it, std::string("hardware ") + kClassTypeTag);
       const auto * params_it = ros2_control_child_it->FirstChildElement(kParamTag);
       if (params_it) {
-        hardware.hardware_parameters = parse_parameters_from_xml(params_it);
+        hardware.hardware_parameters = parse_parameters_from_xml(
+          params_it, hardware.typed_hardware_parameters);
       }
     } else if (!std::string(kJointTag).compare(ros2_control_child_it->Name())) {
       hardware.joints.push_back(parse_component_from_xml(ros2_control_child_it) );
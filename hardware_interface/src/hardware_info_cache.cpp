@@ -0,0 +1,520 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hardware_interface/component_parser.hpp"
+#include "hardware_interface/hardware_info_cache.hpp"
+
+namespace
+{
+constexpr const char kMagic[4] = {'R', 'C', 'D', 'C'};
+// Written as a number, read back on a machine with other endianness it will not match
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+constexpr std::size_t kTagSize = 4;
+constexpr std::size_t kAlignment = 8;
+
+/// File header, followed by section_count SectionEntry and then by the 8 byte aligned payloads
+struct FileHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t byte_order_mark;
+  std::uint32_t section_count;
+  std::uint64_t urdf_hash;
+};
+
+struct SectionEntry
+{
+  char tag[4];
+  std::uint32_t reserved;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+std::size_t align(std::size_t size)
+{
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// Smallest serialized sizes, used to reject element counts a corrupted cache cannot hold
+constexpr std::size_t kMinStringSize = sizeof(std::uint32_t);
+constexpr std::size_t kMinCountSize = sizeof(std::uint32_t);
+constexpr std::size_t kMinTypedParameterSize =
+  3 * kMinStringSize + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t) + sizeof(double);
+constexpr std::size_t kMinInterfaceSize = 3 * kMinStringSize + 2 * sizeof(double);
+constexpr std::size_t kMinComponentSize = 3 * kMinStringSize + 4 * kMinCountSize;
+constexpr std::size_t kMinHardwareSize = 3 * kMinStringSize + 5 * kMinCountSize;
+}  // namespace
+
+namespace hardware_interface
+{
+namespace cache
+{
+
+std::uint64_t hash_urdf(const std::string & urdf)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (const auto c : urdf) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void Writer::write_u32(std::uint32_t value)
+{
+  buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void Writer::write_u64(std::uint64_t value)
+{
+  buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void Writer::write_double(double value)
+{
+  buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void Writer::write_string(const std::string & value)
+{
+  write_u32(static_cast<std::uint32_t>(value.size()));
+  buffer_.append(value);
+}
+
+void Writer::write_string_map(const std::unordered_map<std::string, std::string> & map)
+{
+  write_u32(static_cast<std::uint32_t>(map.size()));
+  for (const auto & key_value : map) {
+    write_string(key_value.first);
+    write_string(key_value.second);
+  }
+}
+
+const std::string & Writer::get_buffer() const
+{
+  return buffer_;
+}
+
+Reader::Reader(const char * data, std::size_t size)
+: data_(data), size_(size), offset_(0)
+{
+}
+
+const char * Reader::consume(std::size_t size)
+{
+  if (size > size_ - offset_) {
+    throw std::runtime_error("hardware description cache is corrupted, unexpected end of data");
+  }
+  const char * current = data_ + offset_;
+  offset_ += size;
+  return current;
+}
+
+std::uint32_t Reader::read_u32()
+{
+  std::uint32_t value;
+  std::memcpy(&value, consume(sizeof(value)), sizeof(value));
+  return value;
+}
+
+std::uint64_t Reader::read_u64()
+{
+  std::uint64_t value;
+  std::memcpy(&value, consume(sizeof(value)), sizeof(value));
+  return value;
+}
+
+double Reader::read_double()
+{
+  double value;
+  std::memcpy(&value, consume(sizeof(value)), sizeof(value));
+  return value;
+}
+
+std::string Reader::read_string()
+{
+  const auto size = read_u32();
+  return std::string(consume(size), size);
+}
+
+std::unordered_map<std::string, std::string> Reader::read_string_map()
+{
+  std::unordered_map<std::string, std::string> map;
+  const auto size = read_count(2 * kMinStringSize);
+  map.reserve(size);
+  for (auto i = 0u; i < size; ++i) {
+    auto key = read_string();
+    map[key] = read_string();
+  }
+  return map;
+}
+
+std::uint32_t Reader::read_count(std::size_t min_element_size)
+{
+  const auto count = read_u32();
+  if (min_element_size > 0 && count > (size_ - offset_) / min_element_size) {
+    throw std::runtime_error("hardware description cache is corrupted, invalid element count");
+  }
+  return count;
+}
+
+bool Reader::at_end() const
+{
+  return offset_ == size_;
+}
+
+CacheFileWriter::CacheFileWriter(std::uint64_t urdf_hash)
+: urdf_hash_(urdf_hash)
+{
+}
+
+void CacheFileWriter::add_section(const std::string & tag, const std::string & payload)
+{
+  if (tag.size() != kTagSize) {
+    throw std::runtime_error("cache section tag '" + tag + "' must have 4 characters");
+  }
+  const auto found_it = std::find_if(
+    sections_.cbegin(), sections_.cend(), [&tag](const auto & section) {
+      return section.first == tag;
+    });
+  if (found_it != sections_.cend()) {
+    throw std::runtime_error("cache section '" + tag + "' added twice");
+  }
+  sections_.emplace_back(tag, payload);
+}
+
+void CacheFileWriter::write(const std::string & path) const
+{
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFormatVersion;
+  header.byte_order_mark = kByteOrderMark;
+  header.section_count = static_cast<std::uint32_t>(sections_.size());
+  header.urdf_hash = urdf_hash_;
+
+  std::vector<SectionEntry> entries(sections_.size());
+  std::size_t offset = align(sizeof(FileHeader) + entries.size() * sizeof(SectionEntry));
+  for (auto i = 0u; i < sections_.size(); ++i) {
+    std::memcpy(entries[i].tag, sections_[i].first.data(), kTagSize);
+    entries[i].reserved = 0;
+    entries[i].offset = offset;
+    entries[i].size = sections_[i].second.size();
+    offset = align(offset + sections_[i].second.size());
+  }
+
+  std::string content;
+  content.reserve(offset);
+  content.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const auto & entry : entries) {
+    content.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+  }
+  for (auto i = 0u; i < sections_.size(); ++i) {
+    content.resize(entries[i].offset, '\0');
+    content.append(sections_[i].second);
+  }
+
+  // write to a temporary file first so readers never map a half written cache
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      throw std::runtime_error("cannot open '" + tmp_path + "' for writing");
+    }
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!file) {
+      throw std::runtime_error("cannot write hardware description cache to '" + tmp_path + "'");
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    throw std::runtime_error("cannot move hardware description cache to '" + path + "'");
+  }
+}
+
+CacheFile::CacheFile(const std::string & path)
+{
+#ifndef _WIN32
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open hardware description cache '" + path + "'");
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    throw std::runtime_error("cannot stat hardware description cache '" + path + "'");
+  }
+  size_ = static_cast<std::size_t>(file_stat.st_size);
+  if (size_ > 0) {
+    void * mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("cannot map hardware description cache '" + path + "'");
+    }
+    data_ = static_cast<const char *>(mapped);
+  }
+  ::close(fd);
+#else
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("cannot open hardware description cache '" + path + "'");
+  }
+  buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+#endif
+
+  try {
+    FileHeader header;
+    if (size_ < sizeof(header)) {
+      throw std::runtime_error("hardware description cache '" + path + "' is truncated");
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+      throw std::runtime_error("'" + path + "' is not a hardware description cache");
+    }
+    if (header.byte_order_mark != kByteOrderMark || header.version != kFormatVersion) {
+      throw std::runtime_error(
+              "hardware description cache '" + path + "' was written with an incompatible format");
+    }
+    urdf_hash_ = header.urdf_hash;
+
+    const std::size_t table_end = sizeof(header) + header.section_count * sizeof(SectionEntry);
+    if (size_ < table_end) {
+      throw std::runtime_error("hardware description cache '" + path + "' is truncated");
+    }
+    sections_.reserve(header.section_count);
+    for (auto i = 0u; i < header.section_count; ++i) {
+      SectionEntry entry;
+      std::memcpy(&entry, data_ + sizeof(header) + i * sizeof(entry), sizeof(entry));
+      if (entry.offset > size_ || entry.size > size_ - entry.offset) {
+        throw std::runtime_error("hardware description cache '" + path + "' is truncated");
+      }
+      sections_.push_back(
+        {std::string(entry.tag, kTagSize), static_cast<std::size_t>(entry.offset),
+          static_cast<std::size_t>(entry.size)});
+    }
+  } catch (...) {
+#ifndef _WIN32
+    if (data_) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+    throw;
+  }
+}
+
+CacheFile::~CacheFile()
+{
+#ifndef _WIN32
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+}
+
+std::uint64_t CacheFile::get_urdf_hash() const
+{
+  return urdf_hash_;
+}
+
+bool CacheFile::is_valid_for(const std::string & urdf) const
+{
+  return urdf_hash_ == hash_urdf(urdf);
+}
+
+bool CacheFile::has_section(const std::string & tag) const
+{
+  return std::any_of(
+    sections_.cbegin(), sections_.cend(), [&tag](const Section & section) {
+      return section.tag == tag;
+    });
+}
+
+Reader CacheFile::get_section(const std::string & tag) const
+{
+  const auto found_it = std::find_if(
+    sections_.cbegin(), sections_.cend(), [&tag](const Section & section) {
+      return section.tag == tag;
+    });
+  if (found_it == sections_.cend()) {
+    throw std::runtime_error("no section '" + tag + "' in hardware description cache");
+  }
+  return Reader(data_ + found_it->offset, found_it->size);
+}
+
+}  // namespace cache
+
+namespace detail
+{
+void serialize_typed_parameters(
+  cache::Writer & writer, const std::unordered_map<std::string, ParameterValue> & parameters)
+{
+  writer.write_u32(static_cast<std::uint32_t>(parameters.size()));
+  for (const auto & parameter : parameters) {
+    writer.write_string(parameter.first);
+    writer.write_u32(static_cast<std::uint32_t>(parameter.second.type));
+    writer.write_string(parameter.second.string_value);
+    writer.write_u32(parameter.second.bool_value ? 1u : 0u);
+    writer.write_u64(static_cast<std::uint64_t>(parameter.second.int_value));
+    writer.write_double(parameter.second.double_value);
+    writer.write_string(parameter.second.unit);
+  }
+}
+
+std::unordered_map<std::string, ParameterValue> deserialize_typed_parameters(
+  cache::Reader & reader)
+{
+  std::unordered_map<std::string, ParameterValue> parameters;
+  const auto size = reader.read_count(kMinTypedParameterSize);
+  parameters.reserve(size);
+  for (auto i = 0u; i < size; ++i) {
+    auto & parameter = parameters[reader.read_string()];
+    const auto type = reader.read_u32();
+    if (type > static_cast<std::uint32_t>(ParameterValue::Type::DOUBLE)) {
+      throw std::runtime_error("hardware description cache is corrupted, invalid parameter type");
+    }
+    parameter.type = static_cast<ParameterValue::Type>(type);
+    parameter.string_value = reader.read_string();
+    parameter.bool_value = reader.read_u32() != 0u;
+    parameter.int_value = static_cast<std::int64_t>(reader.read_u64());
+    parameter.double_value = reader.read_double();
+    parameter.unit = reader.read_string();
+  }
+  return parameters;
+}
+
+void serialize_interfaces(cache::Writer & writer, const std::vector<InterfaceInfo> & interfaces)
+{
+  writer.write_u32(static_cast<std::uint32_t>(interfaces.size()));
+  for (const auto & interface : interfaces) {
+    writer.write_string(interface.name);
+    writer.write_string(interface.min);
+    writer.write_string(interface.max);
+    writer.write_double(interface.min_value);
+    writer.write_double(interface.max_value);
+  }
+}
+
+std::vector<InterfaceInfo> deserialize_interfaces(cache::Reader & reader)
+{
+  std::vector<InterfaceInfo> interfaces(reader.read_count(kMinInterfaceSize));
+  for (auto & interface : interfaces) {
+    interface.name = reader.read_string();
+    interface.min = reader.read_string();
+    interface.max = reader.read_string();
+    interface.min_value = reader.read_double();
+    interface.max_value = reader.read_double();
+  }
+  return interfaces;
+}
+
+void serialize_components(cache::Writer & writer, const std::vector<ComponentInfo> & components)
+{
+  writer.write_u32(static_cast<std::uint32_t>(components.size()));
+  for (const auto & component : components) {
+    writer.write_string(component.name);
+    writer.write_string(component.type);
+    writer.write_string(component.class_type);
+    serialize_interfaces(writer, component.command_interfaces);
+    serialize_interfaces(writer, component.state_interfaces);
+    writer.write_string_map(component.parameters);
+    serialize_typed_parameters(writer, component.typed_parameters);
+  }
+}
+
+std::vector<ComponentInfo> deserialize_components(cache::Reader & reader)
+{
+  std::vector<ComponentInfo> components(reader.read_count(kMinComponentSize));
+  for (auto & component : components) {
+    component.name = reader.read_string();
+    component.type = reader.read_string();
+    component.class_type = reader.read_string();
+    component.command_interfaces = deserialize_interfaces(reader);
+    component.state_interfaces = deserialize_interfaces(reader);
+    component.parameters = reader.read_string_map();
+    component.typed_parameters = deserialize_typed_parameters(reader);
+  }
+  return components;
+}
+}  // namespace detail
+
+std::string serialize_hardware_info(const std::vector<HardwareInfo> & hardware_info)
+{
+  cache::Writer writer;
+  writer.write_u32(static_cast<std::uint32_t>(hardware_info.size()));
+  for (const auto & hardware : hardware_info) {
+    writer.write_string(hardware.name);
+    writer.write_string(hardware.type);
+    writer.write_string(hardware.hardware_class_type);
+    writer.write_string_map(hardware.hardware_parameters);
+    detail::serialize_typed_parameters(writer, hardware.typed_hardware_parameters);
+    detail::serialize_components(writer, hardware.joints);
+    detail::serialize_components(writer, hardware.sensors);
+    detail::serialize_components(writer, hardware.transmissions);
+  }
+  return writer.get_buffer();
+}
+
+std::vector<HardwareInfo> deserialize_hardware_info(cache::Reader & reader)
+{
+  std::vector<HardwareInfo> hardware_info(reader.read_count(kMinHardwareSize));
+  for (auto & hardware : hardware_info) {
+    hardware.name = reader.read_string();
+    hardware.type = reader.read_string();
+    hardware.hardware_class_type = reader.read_string();
+    hardware.hardware_parameters = reader.read_string_map();
+    hardware.typed_hardware_parameters = detail::deserialize_typed_parameters(reader);
+    hardware.joints = detail::deserialize_components(reader);
+    hardware.sensors = detail::deserialize_components(reader);
+    hardware.transmissions = detail::deserialize_components(reader);
+  }
+  if (!reader.at_end()) {
+    throw std::runtime_error("hardware description cache is corrupted, trailing data");
+  }
+  return hardware_info;
+}
+
+std::vector<HardwareInfo> parse_control_resources_from_urdf(
+  const std::string & urdf, const std::string & cache_path)
+{
+  try {
+    cache::CacheFile cache_file(cache_path);
+    if (cache_file.is_valid_for(urdf) && cache_file.has_section(kHardwareInfoCacheSection)) {
+      auto reader = cache_file.get_section(kHardwareInfoCacheSection);
+      return deserialize_hardware_info(reader);
+    }
+  } catch (const std::runtime_error &) {
+    // unusable cache, parse the URDF instead
+  }
+  return parse_control_resources_from_urdf(urdf);
+}
+
+}  // namespace hardware_interface
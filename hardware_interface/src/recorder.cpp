@@ -0,0 +1,432 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hardware_interface/recorder.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Layout of a recording, all integers and values in host byte order:
+//
+// header:
+//   char[8] magic, uint32 version, uint32 reserved,
+//   joints, then actuators: uint32 count, per component:
+//     string name, uint32 interface count, string interface names...
+//   zero padding to a multiple of 8 bytes
+//   (string: uint32 length, characters without terminator)
+// blocks until the end of the file:
+//   BlockHeader, payload of payload_size bytes, a multiple of 8
+//   payload: int64 stamps[cycle_count], then one column per value in the order of the header,
+//     joints first. Raw columns are double[cycle_count], so a file without delta compression
+//     can be memory-mapped and every column used in place. Delta compressed columns store each
+//     value XORed with the previous one of the column, starting from 0.0 in every block. Only
+//     the bytes between the trailing and leading zero bytes of the XOR are stored, after one
+//     byte with the number of trailing zero bytes in the high and stored bytes in the low nibble.
+
+namespace hardware_interface
+{
+
+namespace
+{
+
+constexpr char kMagic[8] = {'H', 'W', 'R', 'E', 'C', 'O', 'R', 'D'};
+constexpr std::uint32_t kVersion = 1u;
+
+enum class Encoding : std::uint32_t
+{
+  RAW = 0,
+  DELTA = 1,
+};
+
+struct BlockHeader
+{
+  std::uint32_t cycle_count;
+  Encoding encoding;
+  std::uint64_t payload_size;
+};
+static_assert(sizeof(BlockHeader) == 16, "blocks must stay 8 byte aligned");
+
+std::size_t padding(std::size_t size)
+{
+  return (8u - size % 8u) % 8u;
+}
+
+template<typename T>
+void append(std::vector<char> & out, const T & value)
+{
+  const auto * bytes = reinterpret_cast<const char *>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void append_string(std::vector<char> & out, const std::string & text)
+{
+  append(out, static_cast<std::uint32_t>(text.size()));
+  out.insert(out.end(), text.begin(), text.end());
+}
+
+void append_layout(std::vector<char> & out, const control_msgs::msg::DynamicJointState & state)
+{
+  append(out, static_cast<std::uint32_t>(state.joint_names.size()));
+  for (size_t i = 0; i < state.joint_names.size(); ++i) {
+    append_string(out, state.joint_names[i]);
+    const auto & interface_names = state.interface_values[i].interface_names;
+    append(out, static_cast<std::uint32_t>(interface_names.size()));
+    for (const auto & interface_name : interface_names) {
+      append_string(out, interface_name);
+    }
+  }
+}
+
+void append_delta_column(const std::vector<double> & column, std::vector<char> & out)
+{
+  std::uint64_t previous = 0;
+  for (const auto value : column) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto delta = bits ^ previous;
+    previous = bits;
+    std::uint8_t zero_bytes = 0;
+    while (delta != 0 && (delta & 0xffu) == 0) {
+      delta >>= 8u;
+      ++zero_bytes;
+    }
+    const auto size_index = out.size();
+    out.push_back(0);
+    std::uint8_t size = 0;
+    while (delta != 0) {
+      out.push_back(static_cast<char>(delta & 0xffu));
+      delta >>= 8u;
+      ++size;
+    }
+    out[size_index] = static_cast<char>((zero_bytes << 4u) | size);
+  }
+}
+
+template<typename T>
+T read(std::ifstream & file)
+{
+  T value;
+  if (!file.read(reinterpret_cast<char *>(&value), sizeof(T))) {
+    throw std::runtime_error("recording is truncated");
+  }
+  return value;
+}
+
+std::string read_string(std::ifstream & file)
+{
+  const auto size = read<std::uint32_t>(file);
+  std::string text(size, '\0');
+  if (!file.read(&text[0], size)) {
+    throw std::runtime_error("recording is truncated");
+  }
+  return text;
+}
+
+std::size_t read_layout(std::ifstream & file, control_msgs::msg::DynamicJointState & state)
+{
+  std::size_t value_count = 0;
+  const auto component_count = read<std::uint32_t>(file);
+  for (std::uint32_t i = 0; i < component_count; ++i) {
+    state.joint_names.push_back(read_string(file));
+    state.interface_values.emplace_back();
+    const auto interface_count = read<std::uint32_t>(file);
+    for (std::uint32_t j = 0; j < interface_count; ++j) {
+      state.interface_values.back().interface_names.push_back(read_string(file));
+    }
+    state.interface_values.back().values.resize(interface_count, 0.0);
+    value_count += interface_count;
+  }
+  return value_count;
+}
+
+std::size_t count_values(const control_msgs::msg::DynamicJointState & state)
+{
+  std::size_t value_count = 0;
+  for (const auto & interface_values : state.interface_values) {
+    value_count += interface_values.values.size();
+  }
+  return value_count;
+}
+
+}  // namespace
+
+Recorder::Recorder(
+  std::shared_ptr<RobotHardware> hw, const std::string & file_path,
+  const RecorderOptions & options)
+: hw_(hw),
+  options_(options),
+  file_(file_path, std::ios::binary | std::ios::trunc),
+  joint_state_(hw->get_registered_joint_state()),
+  actuator_state_(hw->get_registered_actuator_state())
+{
+  if (!file_) {
+    throw std::runtime_error("cannot create recording '" + file_path + "'");
+  }
+  if (options_.buffer_cycles == 0) {
+    throw std::invalid_argument("the recorder needs to buffer at least one cycle");
+  }
+  value_count_ = count_values(joint_state_) + count_values(actuator_state_);
+  stamps_.resize(options_.buffer_cycles);
+  values_.resize(options_.buffer_cycles * value_count_);
+  column_.reserve(options_.buffer_cycles);
+
+  std::vector<char> header(kMagic, kMagic + sizeof(kMagic));
+  append(header, kVersion);
+  append(header, std::uint32_t(0));
+  append_layout(header, joint_state_);
+  append_layout(header, actuator_state_);
+  header.resize(header.size() + padding(header.size()), 0);
+  file_.write(header.data(), header.size());
+  file_.flush();
+
+  write_thread_ = std::thread(&Recorder::write_loop, this);
+}
+
+Recorder::~Recorder()
+{
+  stop();
+}
+
+return_type Recorder::record(std::int64_t stamp)
+{
+  if (stopped_.load(std::memory_order_relaxed)) {
+    return return_type::ERROR;
+  }
+  if (hw_->copy_joint_values(joint_state_) != return_type::OK ||
+    hw_->copy_actuator_values(actuator_state_) != return_type::OK)
+  {
+    return return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL;
+  }
+
+  const auto head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) >= options_.buffer_cycles) {
+    dropped_cycles_.fetch_add(1u, std::memory_order_relaxed);
+    return return_type::ERROR;
+  }
+  const auto slot = head % options_.buffer_cycles;
+  stamps_[slot] = stamp;
+  auto row = values_.begin() + slot * value_count_;
+  for (const auto * state : {&joint_state_, &actuator_state_}) {
+    for (const auto & interface_values : state->interface_values) {
+      row = std::copy(interface_values.values.begin(), interface_values.values.end(), row);
+    }
+  }
+  head_.store(head + 1u, std::memory_order_release);
+  return return_type::OK;
+}
+
+void Recorder::stop()
+{
+  {
+    std::lock_guard<std::mutex> guard(stop_mutex_);
+    if (stop_requested_) {
+      return;
+    }
+    stop_requested_ = true;
+  }
+  stop_condition_.notify_all();
+  write_thread_.join();
+  stopped_ = true;
+  // cycles recorded while the thread stopped
+  write_buffered_cycles();
+  file_.close();
+}
+
+std::uint64_t Recorder::get_written_cycles() const
+{
+  return written_cycles_;
+}
+
+std::uint64_t Recorder::get_dropped_cycles() const
+{
+  return dropped_cycles_;
+}
+
+void Recorder::write_loop()
+{
+  std::unique_lock<std::mutex> lock(stop_mutex_);
+  while (!stop_requested_) {
+    stop_condition_.wait_for(lock, options_.write_period);
+    lock.unlock();
+    write_buffered_cycles();
+    lock.lock();
+  }
+}
+
+void Recorder::write_buffered_cycles()
+{
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  const auto head = head_.load(std::memory_order_acquire);
+  const auto cycle_count = head - tail;
+  if (cycle_count == 0) {
+    return;
+  }
+
+  const auto encoding = options_.delta_compression ? Encoding::DELTA : Encoding::RAW;
+  block_.clear();
+  append(block_, BlockHeader{static_cast<std::uint32_t>(cycle_count), encoding, 0u});
+  for (auto cycle = tail; cycle < head; ++cycle) {
+    append(block_, stamps_[cycle % options_.buffer_cycles]);
+  }
+  for (std::size_t value = 0; value < value_count_; ++value) {
+    column_.clear();
+    for (auto cycle = tail; cycle < head; ++cycle) {
+      column_.push_back(values_[(cycle % options_.buffer_cycles) * value_count_ + value]);
+    }
+    if (encoding == Encoding::RAW) {
+      const auto * bytes = reinterpret_cast<const char *>(column_.data());
+      block_.insert(block_.end(), bytes, bytes + column_.size() * sizeof(double));
+    } else {
+      append_delta_column(column_, block_);
+    }
+  }
+  // the cycles are copied, record() can reuse their slots
+  tail_.store(head, std::memory_order_release);
+
+  block_.resize(block_.size() + padding(block_.size()), 0);
+  const std::uint64_t payload_size = block_.size() - sizeof(BlockHeader);
+  std::memcpy(
+    block_.data() + offsetof(BlockHeader, payload_size), &payload_size, sizeof(payload_size));
+  file_.write(block_.data(), block_.size());
+  file_.flush();
+  written_cycles_ += cycle_count;
+}
+
+RecordingReader::RecordingReader(const std::string & file_path)
+: file_(file_path, std::ios::binary)
+{
+  if (!file_) {
+    throw std::runtime_error("cannot open recording '" + file_path + "'");
+  }
+  char magic[sizeof(kMagic)];
+  if (!file_.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("'" + file_path + "' is not a recording");
+  }
+  const auto version = read<std::uint32_t>(file_);
+  if (version != kVersion) {
+    throw std::runtime_error(
+            "'" + file_path + "' has unsupported version " + std::to_string(version));
+  }
+  read<std::uint32_t>(file_);
+  value_count_ = read_layout(file_, joint_state_);
+  value_count_ += read_layout(file_, actuator_state_);
+  file_.seekg(padding(static_cast<std::size_t>(file_.tellg())), std::ios::cur);
+}
+
+const control_msgs::msg::DynamicJointState & RecordingReader::get_joint_state() const
+{
+  return joint_state_;
+}
+
+const control_msgs::msg::DynamicJointState & RecordingReader::get_actuator_state() const
+{
+  return actuator_state_;
+}
+
+bool RecordingReader::next(
+  std::int64_t & stamp, control_msgs::msg::DynamicJointState & joint_state,
+  control_msgs::msg::DynamicJointState & actuator_state)
+{
+  if (count_values(joint_state) + count_values(actuator_state) != value_count_) {
+    throw std::invalid_argument("the states do not have the layout of the recording");
+  }
+  while (next_cycle_ >= stamps_.size()) {
+    if (!read_block()) {
+      return false;
+    }
+  }
+
+  stamp = stamps_[next_cycle_];
+  auto row = values_.cbegin() + next_cycle_ * value_count_;
+  for (auto * state : {&joint_state, &actuator_state}) {
+    for (auto & interface_values : state->interface_values) {
+      std::copy(row, row + interface_values.values.size(), interface_values.values.begin());
+      row += interface_values.values.size();
+    }
+  }
+  ++next_cycle_;
+  return true;
+}
+
+bool RecordingReader::read_block()
+{
+  BlockHeader header;
+  if (!file_.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    if (file_.gcount() == 0) {
+      return false;
+    }
+    throw std::runtime_error("recording is truncated");
+  }
+  if (header.payload_size % 8u != 0 ||
+    (header.encoding != Encoding::RAW && header.encoding != Encoding::DELTA))
+  {
+    throw std::runtime_error("recording is corrupted");
+  }
+  block_.resize(header.payload_size);
+  if (!file_.read(block_.data(), block_.size())) {
+    throw std::runtime_error("recording is truncated");
+  }
+
+  const std::size_t cycle_count = header.cycle_count;
+  const char * in = block_.data();
+  const char * end = in + block_.size();
+  if (cycle_count * sizeof(std::int64_t) > block_.size()) {
+    throw std::runtime_error("recording is corrupted");
+  }
+  stamps_.resize(cycle_count);
+  std::memcpy(stamps_.data(), in, cycle_count * sizeof(std::int64_t));
+  in += cycle_count * sizeof(std::int64_t);
+
+  values_.resize(cycle_count * value_count_);
+  for (std::size_t value = 0; value < value_count_; ++value) {
+    std::uint64_t previous = 0;
+    for (std::size_t cycle = 0; cycle < cycle_count; ++cycle) {
+      std::uint64_t bits = 0;
+      if (header.encoding == Encoding::RAW) {
+        if (end - in < 8) {
+          throw std::runtime_error("recording is corrupted");
+        }
+        std::memcpy(&bits, in, sizeof(bits));
+        in += sizeof(bits);
+      } else {
+        if (in >= end) {
+          throw std::runtime_error("recording is corrupted");
+        }
+        const auto sizes = static_cast<std::uint8_t>(*in++);
+        const unsigned zero_bytes = sizes >> 4u;
+        const unsigned size = sizes & 0x0fu;
+        if (zero_bytes + size > 8u || end - in < size) {
+          throw std::runtime_error("recording is corrupted");
+        }
+        for (unsigned byte = 0; byte < size; ++byte) {
+          bits |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(*in++)) <<
+            (8u * (zero_bytes + byte));
+        }
+        bits ^= previous;
+        previous = bits;
+      }
+      std::memcpy(&values_[cycle * value_count_ + value], &bits, sizeof(bits));
+    }
+  }
+  next_cycle_ = 0;
+  return true;
+}
+
+}  // namespace hardware_interface
@@ -0,0 +1,150 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hardware_interface/replay_robot_hardware.hpp"
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rcutils/logging_macros.h"
+
+namespace
+{
+using hardware_interface::is_command_interface;
+
+constexpr const char * kLoggerName = "replay_robot_hardware";
+
+/// Collect the recorded values of \p state to replay and the registered handles to set
+template<class HandleType, class GetHandle>
+hardware_interface::return_type collect_replayed_values(
+  const control_msgs::msg::DynamicJointState & state, bool replay_commands,
+  GetHandle get_handle, std::vector<std::pair<const double *, HandleType>> & replayed_values)
+{
+  for (size_t i = 0; i < state.joint_names.size(); ++i) {
+    const auto & interface_values = state.interface_values[i];
+    for (size_t j = 0; j < interface_values.interface_names.size(); ++j) {
+      if (!replay_commands && is_command_interface(interface_values.interface_names[j])) {
+        continue;
+      }
+      HandleType handle(state.joint_names[i], interface_values.interface_names[j]);
+      if (get_handle(handle) != hardware_interface::return_type::OK) {
+        return hardware_interface::return_type::ERROR;
+      }
+      replayed_values.emplace_back(&interface_values.values[j], handle);
+    }
+  }
+  return hardware_interface::return_type::OK;
+}
+}  // namespace
+
+namespace hardware_interface
+{
+
+ReplayRobotHardware::ReplayRobotHardware(const std::string & file_path, bool replay_commands)
+: file_path_(file_path), replay_commands_(replay_commands)
+{
+}
+
+return_type ReplayRobotHardware::init()
+{
+  try {
+    reader_ = std::make_unique<RecordingReader>(file_path_);
+  } catch (const std::exception & e) {
+    RCUTILS_LOG_ERROR_NAMED(kLoggerName, "cannot replay: %s", e.what());
+    return return_type::ERROR;
+  }
+  joint_state_ = reader_->get_joint_state();
+  actuator_state_ = reader_->get_actuator_state();
+
+  for (size_t i = 0; i < joint_state_.joint_names.size(); ++i) {
+    for (const auto & interface_name : joint_state_.interface_values[i].interface_names) {
+      if (register_joint(joint_state_.joint_names[i], interface_name) != return_type::OK) {
+        return return_type::ERROR;
+      }
+    }
+  }
+  for (size_t i = 0; i < actuator_state_.joint_names.size(); ++i) {
+    for (const auto & interface_name : actuator_state_.interface_values[i].interface_names) {
+      if (register_actuator(actuator_state_.joint_names[i], interface_name) != return_type::OK) {
+        return return_type::ERROR;
+      }
+    }
+  }
+
+  // the registered values do not move anymore once all are registered
+  replayed_joint_values_.clear();
+  replayed_actuator_values_.clear();
+  if (collect_replayed_values(
+      joint_state_, replay_commands_,
+      [this](JointHandle & handle) {return get_joint_handle(handle);},
+      replayed_joint_values_) != return_type::OK ||
+    collect_replayed_values(
+      actuator_state_, replay_commands_,
+      [this](ActuatorHandle & handle) {return get_actuator_handle(handle);},
+      replayed_actuator_values_) != return_type::OK)
+  {
+    return return_type::ERROR;
+  }
+  return return_type::OK;
+}
+
+return_type ReplayRobotHardware::read()
+{
+  if (!reader_) {
+    return return_type::ERROR;
+  }
+  try {
+    if (!reader_->next(stamp_, joint_state_, actuator_state_)) {
+      return return_type::ERROR;
+    }
+  } catch (const std::exception & e) {
+    RCUTILS_LOG_ERROR_NAMED(kLoggerName, "cannot replay: %s", e.what());
+    return return_type::ERROR;
+  }
+
+  for (auto & replayed_value : replayed_joint_values_) {
+    replayed_value.second.set_value(*replayed_value.first);
+  }
+  for (auto & replayed_value : replayed_actuator_values_) {
+    replayed_value.second.set_value(*replayed_value.first);
+  }
+  return return_type::OK;
+}
+
+return_type ReplayRobotHardware::write()
+{
+  return return_type::OK;
+}
+
+std::int64_t ReplayRobotHardware::get_stamp() const
+{
+  return stamp_;
+}
+
+const control_msgs::msg::DynamicJointState & ReplayRobotHardware::get_recorded_joint_state() const
+{
+  return joint_state_;
+}
+
+const control_msgs::msg::DynamicJointState &
+ReplayRobotHardware::get_recorded_actuator_state() const
+{
+  return actuator_state_;
+}
+
+}  // namespace hardware_interface
@@ -15,11 +15,13 @@
 #include "hardware_interface/robot_hardware.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "hardware_interface/macros.hpp"
 #include "hardware_interface/operation_mode_handle.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "rcutils/logging_macros.h"
 
 namespace
@@ -27,6 +29,7 @@ namespace
 constexpr auto kOperationModeLoggerName = "joint operation mode handle";
 constexpr auto kActuatorLoggerName = "actuator handle";
 constexpr auto kJointLoggerName = "joint handle";
+constexpr auto kCommandTimeoutLoggerName = "command timeout";
 }
 
 namespace hardware_interface
@@ -155,7 +158,8 @@ hardware_interface_ret_t register_handle(
   const std::string & interface_name,
   const double default_value,
   control_msgs::msg::DynamicJointState & registered,
-  const std::string & logger_name)
+  const std::string & logger_name,
+  std::vector<std::vector<std::uint8_t>> * written_flags = nullptr)
 {
   if (handle_name.empty() || interface_name.empty()) {
     RCUTILS_LOG_ERROR_NAMED(logger_name.c_str(), "handle name or interface is empty!");
@@ -170,6 +174,9 @@ hardware_interface_ret_t register_handle(
     iv.interface_names = {interface_name};
     iv.values = {default_value};
     registered.interface_values.push_back(iv);
+    if (written_flags) {
+      written_flags->emplace_back(1, 0);
+    }
     return return_type::OK;
   } else {
     const auto index = std::distance(names_list.cbegin(), it);
@@ -179,6 +186,9 @@ hardware_interface_ret_t register_handle(
     if (it == interface_names.cend()) {
       ivs.interface_names.push_back(interface_name);
       ivs.values.push_back(default_value);
+      if (written_flags) {
+        (*written_flags)[static_cast<size_t>(index)].push_back(0);
+      }
       return return_type::OK;
     } else {
       RCUTILS_LOG_ERROR_NAMED(
@@ -206,14 +216,15 @@ hardware_interface_ret_t RobotHardware::register_joint(
 {
   return register_handle(
     joint_name, interface_name, default_value, registered_joints_,
-    kJointLoggerName);
+    kJointLoggerName, &joint_written_flags_);
 }
 
 template<class HandleType>
 hardware_interface_ret_t get_handle(
   HandleType & handle,
   control_msgs::msg::DynamicJointState & registered,
-  const std::string & logger_name)
+  const std::string & logger_name,
+  std::vector<std::vector<std::uint8_t>> * written_flags = nullptr)
 {
   const auto & handle_name = handle.get_name();
   const auto & interface_name = handle.get_interface_name();
@@ -238,7 +249,10 @@ hardware_interface_ret_t get_handle(
   const auto if_it = std::find(interface_names.cbegin(), interface_names.cend(), interface_name);
   if (if_it != interface_names.cend()) {
     const auto value_index = std::distance(interface_names.cbegin(), if_it);
-    handle = handle.with_value_ptr(&(ivs.values[static_cast<size_t>(value_index)]));
+    handle = handle.with_value_ptr(
+      &(ivs.values[static_cast<size_t>(value_index)]),
+      written_flags ?
+      &(*written_flags)[static_cast<size_t>(index)][static_cast<size_t>(value_index)] : nullptr);
     return return_type::OK;
   } else {
     RCUTILS_LOG_ERROR_NAMED(
@@ -257,7 +271,8 @@ hardware_interface_ret_t RobotHardware::get_actuator_handle(ActuatorHandle & act
 
 hardware_interface_ret_t RobotHardware::get_joint_handle(JointHandle & joint_handle)
 {
-  return get_handle<JointHandle>(joint_handle, registered_joints_, kJointLoggerName);
+  return get_handle<JointHandle>(
+    joint_handle, registered_joints_, kJointLoggerName, &joint_written_flags_);
 }
 
 template<class HandleType>
@@ -328,7 +343,9 @@ const std::vector<std::string> & RobotHardware::get_registered_joint_interface_n
 }
 
 template<class HandleType>
-std::vector<HandleType> get_registered_handles(control_msgs::msg::DynamicJointState & registered)
+std::vector<HandleType> get_registered_handles(
+  control_msgs::msg::DynamicJointState & registered,
+  std::vector<std::vector<std::uint8_t>> * written_flags = nullptr)
 {
   std::vector<HandleType> result;
   result.reserve(registered.joint_names.size());    // rough estimate
@@ -344,7 +361,7 @@ std::vector<HandleType> get_registered_handles(control_msgs::msg::DynamicJointSt
     for (auto j = 0u; j < jointernal_interfaces.interface_names.size(); ++j) {
       result.emplace_back(
         handle_names[i], jointernal_interfaces.interface_names[j],
-        &jointernal_interfaces.values[j]);
+        &jointernal_interfaces.values[j], written_flags ? &(*written_flags)[i][j] : nullptr);
     }
   }
 
@@ -358,7 +375,163 @@ std::vector<ActuatorHandle> RobotHardware::get_registered_actuators()
 
 std::vector<JointHandle> RobotHardware::get_registered_joints()
 {
-  return get_registered_handles<JointHandle>(registered_joints_);
+  return get_registered_handles<JointHandle>(registered_joints_, &joint_written_flags_);
+}
+
+const control_msgs::msg::DynamicJointState & RobotHardware::get_registered_actuator_state() const
+{
+  return registered_actuators_;
+}
+
+const control_msgs::msg::DynamicJointState & RobotHardware::get_registered_joint_state() const
+{
+  return registered_joints_;
+}
+
+/// Copy the values of the registered handles into a message with the same layout.
+/**
+ * Handles can only be added, so the layout matches if the number of handles and interfaces
+ * match. Names are not compared to keep this cheap enough for the realtime loop.
+ * \param[in] registered The registered handles.
+ * \param[in,out] target Copy of \p registered taken earlier.
+ * \return The return code, one of `OK` or `INTERFACE_VALUE_SIZE_NOT_EQUAL`.
+ */
+hardware_interface_ret_t copy_values(
+  const control_msgs::msg::DynamicJointState & registered,
+  control_msgs::msg::DynamicJointState & target)
+{
+  if (registered.interface_values.size() != target.interface_values.size()) {
+    return return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL;
+  }
+  for (auto i = 0u; i < registered.interface_values.size(); ++i) {
+    if (registered.interface_values[i].values.size() !=
+      target.interface_values[i].values.size())
+    {
+      return return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL;
+    }
+  }
+  for (auto i = 0u; i < registered.interface_values.size(); ++i) {
+    std::copy(
+      registered.interface_values[i].values.begin(), registered.interface_values[i].values.end(),
+      target.interface_values[i].values.begin());
+  }
+  return return_type::OK;
+}
+
+hardware_interface_ret_t RobotHardware::copy_actuator_values(
+  control_msgs::msg::DynamicJointState & actuator_state) const
+{
+  return copy_values(registered_actuators_, actuator_state);
+}
+
+hardware_interface_ret_t RobotHardware::copy_joint_values(
+  control_msgs::msg::DynamicJointState & joint_state) const
+{
+  return copy_values(registered_joints_, joint_state);
+}
+
+return_type RobotHardware::set_command_timeout(
+  const std::string & joint_name, std::uint64_t timeout_cycles, CommandTimeoutPolicy policy)
+{
+  const auto & names = registered_joints_.joint_names;
+  const auto it = std::find(names.cbegin(), names.cend(), joint_name);
+  if (it == names.cend()) {
+    RCUTILS_LOG_ERROR_NAMED(
+      kCommandTimeoutLoggerName, "joint %s is not registered", joint_name.c_str());
+    return return_type::ERROR;
+  }
+  const auto joint = static_cast<size_t>(std::distance(names.cbegin(), it));
+
+  // zero is a safe velocity or effort, but a position command of zero moves the joint to 0
+  auto & interface_values = registered_joints_.interface_values[joint];
+  const auto & interface_names = interface_values.interface_names;
+  const auto position_command_it =
+    std::find(interface_names.cbegin(), interface_names.cend(), "position_command");
+  const auto position_it = std::find(interface_names.cbegin(), interface_names.cend(), "position");
+  const double * position = nullptr;
+  if (position_command_it != interface_names.cend()) {
+    if (policy != CommandTimeoutPolicy::HOLD) {
+      RCUTILS_LOG_ERROR_NAMED(
+        kCommandTimeoutLoggerName,
+        "joint %s has a position command, which can only be held and not zeroed",
+        joint_name.c_str());
+      return return_type::ERROR;
+    }
+    if (position_it == interface_names.cend()) {
+      RCUTILS_LOG_ERROR_NAMED(
+        kCommandTimeoutLoggerName,
+        "joint %s has no position state to hold its position command at", joint_name.c_str());
+      return return_type::ERROR;
+    }
+    position =
+      &interface_values.values[static_cast<size_t>(position_it - interface_names.cbegin())];
+  }
+
+  // replaces the previous timeout of the joint
+  size_t kept = 0;
+  for (size_t i = 0; i < timeout_joints_.size(); ++i) {
+    if (timeout_joints_[i] == joint) {
+      continue;
+    }
+    timeout_joints_[kept] = timeout_joints_[i];
+    timeout_values_[kept] = timeout_values_[i];
+    timeout_written_flags_[kept] = timeout_written_flags_[i];
+    timeout_hold_values_[kept] = timeout_hold_values_[i];
+    timeout_stamps_[kept] = timeout_stamps_[i];
+    timeout_cycles_[kept] = timeout_cycles_[i];
+    timeout_stale_[kept] = timeout_stale_[i];
+    ++kept;
+  }
+  timeout_joints_.resize(kept);
+  timeout_values_.resize(kept);
+  timeout_written_flags_.resize(kept);
+  timeout_hold_values_.resize(kept);
+  timeout_stamps_.resize(kept);
+  timeout_cycles_.resize(kept);
+  timeout_stale_.resize(kept);
+
+  for (size_t i = 0; i < interface_names.size(); ++i) {
+    if (!is_command_interface(interface_names[i])) {
+      continue;
+    }
+    timeout_joints_.push_back(joint);
+    timeout_values_.push_back(&interface_values.values[i]);
+    timeout_written_flags_.push_back(&joint_written_flags_[joint][i]);
+    timeout_hold_values_.push_back(interface_names[i] == "position_command" ? position : nullptr);
+    // fresh until the timeout expires for the first time
+    timeout_stamps_.push_back(command_cycle_);
+    timeout_cycles_.push_back(timeout_cycles);
+    timeout_stale_.push_back(0);
+  }
+  if (timeout_joints_.size() == kept) {
+    RCUTILS_LOG_ERROR_NAMED(
+      kCommandTimeoutLoggerName, "joint %s has no command interfaces", joint_name.c_str());
+    return return_type::ERROR;
+  }
+  return return_type::OK;
+}
+
+void RobotHardware::enforce_command_timeouts()
+{
+  const auto cycle = ++command_cycle_;
+  const auto count = timeout_values_.size();
+  for (size_t i = 0; i < count; ++i) {
+    timeout_stamps_[i] = *timeout_written_flags_[i] ? cycle : timeout_stamps_[i];
+    *timeout_written_flags_[i] = 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    const std::uint8_t stale = cycle - timeout_stamps_[i] > timeout_cycles_[i];
+    // the safe value is only set once, so that a hold position does not follow the joint
+    if (stale && !timeout_stale_[i]) {
+      *timeout_values_[i] = timeout_hold_values_[i] ? *timeout_hold_values_[i] : 0.0;
+    }
+    timeout_stale_[i] = stale;
+  }
+}
+
+std::size_t RobotHardware::get_stale_command_count() const
+{
+  return static_cast<std::size_t>(std::count(timeout_stale_.begin(), timeout_stale_.end(), 1));
 }
 
 }  // namespace hardware_interface
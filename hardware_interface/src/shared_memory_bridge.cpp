@@ -0,0 +1,562 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hardware_interface/shared_memory_bridge.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rcutils/logging_macros.h"
+
+/*
+ * Segment layout, all offsets from the start of the segment:
+ *
+ *   SharedMemorySegmentHeader
+ *   layout: per value a byte kind (joint or actuator), a byte which is 1 for commands, the
+ *           component name and the interface name, both null terminated. Joints come first and
+ *           the interfaces of a component are consecutive, as RobotHardware stores them
+ *   state values: doubles in the order of the states in the layout, 64 byte aligned
+ *   command values: doubles in the order of the commands in the layout, 64 byte aligned
+ *
+ * The header is written last, its magic tells that the segment is complete.
+ */
+
+namespace hardware_interface
+{
+
+/// One direction of the bridge, written by a single process
+struct SharedMemoryChannel
+{
+  /// Odd while the values are written, incremented twice per write
+  std::atomic<std::uint32_t> sequence;
+  /// Number of processes waiting on the sequence with a futex
+  std::atomic<std::uint32_t> waiters;
+  std::uint64_t values_offset;
+  std::uint64_t value_count;
+};
+
+struct SharedMemorySegmentHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+  std::uint64_t segment_size;
+  std::uint64_t layout_offset;
+  std::uint64_t layout_size;
+  alignas(64) SharedMemoryChannel state;
+  alignas(64) SharedMemoryChannel command;
+};
+
+}  // namespace hardware_interface
+
+namespace
+{
+using hardware_interface::is_command_interface;
+using hardware_interface::SharedMemoryChannel;
+using hardware_interface::SharedMemorySegmentHeader;
+
+constexpr const char * kLoggerName = "shared_memory_bridge";
+constexpr char kMagic[8] = {'H', 'W', 'S', 'H', 'M', 'E', 'M', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint8_t kJoint = 0;
+constexpr std::uint8_t kActuator = 1;
+/// Longest time a reader retries while the writer is in the middle of a write, which only
+/// happens for longer if the writing process died during it
+constexpr std::chrono::milliseconds kTornWriteTimeout(1);
+
+// futexes work on the sequence itself, in memory shared between processes
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "lock-free atomics are required in shared memory");
+static_assert(
+  sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+  "futexes need atomics of the size of their values");
+
+std::uint64_t align(std::uint64_t offset)
+{
+  return (offset + 63) & ~std::uint64_t(63);
+}
+
+double * values_of(SharedMemorySegmentHeader * header, SharedMemoryChannel & channel)
+{
+  return reinterpret_cast<double *>(reinterpret_cast<char *>(header) + channel.values_offset);
+}
+
+std::uint32_t * futex_word(SharedMemoryChannel & channel)
+{
+  return reinterpret_cast<std::uint32_t *>(&channel.sequence);
+}
+
+void futex_wake(SharedMemoryChannel & channel)
+{
+  syscall(SYS_futex, futex_word(channel), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void futex_wait(
+  SharedMemoryChannel & channel, std::uint32_t expected, std::chrono::nanoseconds timeout)
+{
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  struct timespec relative_timeout;
+  relative_timeout.tv_sec = seconds.count();
+  relative_timeout.tv_nsec = (timeout - seconds).count();
+  syscall(SYS_futex, futex_word(channel), FUTEX_WAIT, expected, &relative_timeout, nullptr, 0);
+}
+
+/// Write \p count values to \p channel and wake up waiting readers
+void write_values(
+  SharedMemorySegmentHeader * header, SharedMemoryChannel & channel, const double * values,
+  std::size_t count)
+{
+  // starting at an odd sequence also recovers from a writer that died during a write
+  const std::uint32_t sequence = (channel.sequence.load(std::memory_order_relaxed) + 1) | 1u;
+  channel.sequence.store(sequence, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(values_of(header, channel), values, count * sizeof(double));
+  // sequentially consistent, so that a reader either sees the new sequence or is counted
+  channel.sequence.store(sequence + 1, std::memory_order_seq_cst);
+  if (channel.waiters.load(std::memory_order_seq_cst) > 0) {
+    futex_wake(channel);
+  }
+}
+
+/// Copy the \p count values of one write to \p channel, false if no complete write could be read
+bool read_values(
+  SharedMemorySegmentHeader * header, SharedMemoryChannel & channel, double * values,
+  std::size_t count, std::uint32_t & sequence)
+{
+  const auto deadline = std::chrono::steady_clock::now() + kTornWriteTimeout;
+  do {
+    const auto begin = channel.sequence.load(std::memory_order_acquire);
+    if ((begin & 1u) == 0) {
+      std::memcpy(values, values_of(header, channel), count * sizeof(double));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (channel.sequence.load(std::memory_order_relaxed) == begin) {
+        sequence = begin;
+        return true;
+      }
+    }
+  } while (std::chrono::steady_clock::now() < deadline);
+  return false;
+}
+
+/// Wait until the sequence of \p channel differs from \p sequence, false on timeout
+bool wait_for_write(
+  SharedMemoryChannel & channel, std::uint32_t sequence, std::chrono::nanoseconds timeout)
+{
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (channel.sequence.load(std::memory_order_acquire) == sequence) {
+    const auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::nanoseconds(0)) {
+      return false;
+    }
+    channel.waiters.fetch_add(1, std::memory_order_seq_cst);
+    // the futex only sleeps if the sequence still equals the expected one
+    futex_wait(channel, sequence, remaining);
+    channel.waiters.fetch_sub(1, std::memory_order_seq_cst);
+  }
+  return true;
+}
+
+/// Value of the layout of a segment
+struct LayoutEntry
+{
+  std::uint8_t kind;
+  bool is_command;
+  std::string component_name;
+  std::string interface_name;
+};
+
+void append_layout(
+  const control_msgs::msg::DynamicJointState & state, std::uint8_t kind,
+  std::vector<LayoutEntry> & layout)
+{
+  if (state.interface_values.size() != state.joint_names.size()) {
+    throw std::runtime_error("interface values do not match the joint names");
+  }
+  for (size_t i = 0; i < state.joint_names.size(); ++i) {
+    const auto & interface_values = state.interface_values[i];
+    if (interface_values.values.size() != interface_values.interface_names.size()) {
+      throw std::runtime_error("values do not match the interface names of " +
+              state.joint_names[i]);
+    }
+    for (const auto & interface_name : interface_values.interface_names) {
+      layout.push_back(
+        {kind, is_command_interface(interface_name), state.joint_names[i], interface_name});
+    }
+  }
+}
+
+std::vector<LayoutEntry> parse_layout(const SharedMemorySegmentHeader * header)
+{
+  const char * position = reinterpret_cast<const char *>(header) + header->layout_offset;
+  const char * end = position + header->layout_size;
+  auto read_string = [&position, end]() {
+      const auto terminator =
+        static_cast<const char *>(std::memchr(position, '\0', end - position));
+      if (terminator == nullptr) {
+        throw std::runtime_error("truncated layout");
+      }
+      std::string result(position, terminator);
+      position = terminator + 1;
+      return result;
+    };
+
+  std::vector<LayoutEntry> layout;
+  while (position < end) {
+    if (end - position < 2) {
+      throw std::runtime_error("truncated layout");
+    }
+    LayoutEntry entry;
+    entry.kind = static_cast<std::uint8_t>(position[0]);
+    entry.is_command = position[1] != 0;
+    position += 2;
+    entry.component_name = read_string();
+    entry.interface_name = read_string();
+    if (entry.kind != kJoint && entry.kind != kActuator) {
+      throw std::runtime_error("invalid layout");
+    }
+    if (!layout.empty() && layout.back().kind == kActuator && entry.kind == kJoint) {
+      throw std::runtime_error("joints after actuators in the layout");
+    }
+    layout.push_back(std::move(entry));
+  }
+  return layout;
+}
+
+std::string error_message(const std::string & what, const std::string & name)
+{
+  return "cannot " + what + " shared memory segment '" + name + "': " + std::strerror(errno);
+}
+}  // namespace
+
+namespace hardware_interface
+{
+
+SharedMemoryMapping::~SharedMemoryMapping()
+{
+  if (header_ != nullptr) {
+    munmap(header_, size_);
+  }
+}
+
+void SharedMemoryMapping::create(const std::string & name, std::size_t size)
+{
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    throw std::runtime_error(error_message("create", name));
+  }
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    const auto message = error_message("resize", name);
+    close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error(message);
+  }
+  // populated, so that the control loop does not fault the pages in
+  void * address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    const auto message = error_message("map", name);
+    shm_unlink(name.c_str());
+    throw std::runtime_error(message);
+  }
+  header_ = static_cast<SharedMemorySegmentHeader *>(address);
+  size_ = size;
+}
+
+void SharedMemoryMapping::open(const std::string & name)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    throw std::runtime_error(error_message("open", name));
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    const auto message = error_message("inspect", name);
+    close(fd);
+    throw std::runtime_error(message);
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+  if (size < sizeof(SharedMemorySegmentHeader)) {
+    close(fd);
+    throw std::runtime_error("shared memory segment '" + name + "' is too small");
+  }
+  void * address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error(error_message("map", name));
+  }
+  header_ = static_cast<SharedMemorySegmentHeader *>(address);
+  size_ = size;
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const auto & header = *header_;
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("shared memory segment '" + name + "' is not initialized");
+  }
+  if (header.version != kVersion) {
+    throw std::runtime_error(
+            "shared memory segment '" + name + "' has unsupported version " +
+            std::to_string(header.version));
+  }
+  const auto values_end = [&header](const SharedMemoryChannel & channel) {
+      return channel.values_offset + channel.value_count * sizeof(double);
+    };
+  if (header.segment_size != size || header.layout_offset + header.layout_size > size ||
+    values_end(header.state) > size || values_end(header.command) > size)
+  {
+    throw std::runtime_error("shared memory segment '" + name + "' is inconsistent");
+  }
+}
+
+SharedMemoryDriver::SharedMemoryDriver(
+  const std::string & segment_name,
+  const control_msgs::msg::DynamicJointState & joint_state,
+  const control_msgs::msg::DynamicJointState & actuator_state)
+: segment_name_(segment_name)
+{
+  std::vector<LayoutEntry> layout;
+  append_layout(joint_state, kJoint, layout);
+  append_layout(actuator_state, kActuator, layout);
+
+  std::string serialized_layout;
+  std::vector<double> initial_states;
+  std::vector<double> initial_commands;
+  for (const auto * state : {&joint_state, &actuator_state}) {
+    for (const auto & interface_values : state->interface_values) {
+      for (size_t j = 0; j < interface_values.values.size(); ++j) {
+        auto & initial_values = is_command_interface(interface_values.interface_names[j]) ?
+          initial_commands : initial_states;
+        initial_values.push_back(interface_values.values[j]);
+      }
+    }
+  }
+  for (const auto & entry : layout) {
+    serialized_layout += static_cast<char>(entry.kind);
+    serialized_layout += static_cast<char>(entry.is_command ? 1 : 0);
+    serialized_layout += entry.component_name + '\0' + entry.interface_name + '\0';
+    auto & names = entry.is_command ? command_names_ : state_names_;
+    names.push_back(entry.component_name + "/" + entry.interface_name);
+  }
+
+  const std::uint64_t layout_offset = sizeof(SharedMemorySegmentHeader);
+  const std::uint64_t states_offset = align(layout_offset + serialized_layout.size());
+  const std::uint64_t commands_offset = align(states_offset + state_names_.size() * sizeof(double));
+  const std::uint64_t segment_size =
+    align(commands_offset + command_names_.size() * sizeof(double));
+  mapping_.create(segment_name_, segment_size);
+
+  auto header = mapping_.header();
+  header->version = kVersion;
+  header->segment_size = segment_size;
+  header->layout_offset = layout_offset;
+  header->layout_size = serialized_layout.size();
+  header->state.values_offset = states_offset;
+  header->state.value_count = state_names_.size();
+  header->command.values_offset = commands_offset;
+  header->command.value_count = command_names_.size();
+  std::memcpy(
+    reinterpret_cast<char *>(header) + layout_offset, serialized_layout.data(),
+    serialized_layout.size());
+  std::memcpy(
+    values_of(header, header->state), initial_states.data(),
+    initial_states.size() * sizeof(double));
+  std::memcpy(
+    values_of(header, header->command), initial_commands.data(),
+    initial_commands.size() * sizeof(double));
+  // the magic marks the segment as complete
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, kMagic, sizeof(kMagic));
+}
+
+SharedMemoryDriver::~SharedMemoryDriver()
+{
+  shm_unlink(segment_name_.c_str());
+}
+
+const std::vector<std::string> & SharedMemoryDriver::get_state_names() const
+{
+  return state_names_;
+}
+
+const std::vector<std::string> & SharedMemoryDriver::get_command_names() const
+{
+  return command_names_;
+}
+
+return_type SharedMemoryDriver::write_states(const std::vector<double> & states)
+{
+  if (states.size() != state_names_.size()) {
+    return return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL;
+  }
+  auto header = mapping_.header();
+  write_values(header, header->state, states.data(), states.size());
+  return return_type::OK;
+}
+
+return_type SharedMemoryDriver::read_commands(
+  std::vector<double> & commands, std::chrono::nanoseconds timeout)
+{
+  if (commands.size() != command_names_.size()) {
+    return return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL;
+  }
+  auto header = mapping_.header();
+  if (timeout > std::chrono::nanoseconds(0) &&
+    !wait_for_write(header->command, last_command_sequence_, timeout))
+  {
+    return return_type::ERROR;
+  }
+  if (!read_values(
+      header, header->command, commands.data(), commands.size(), last_command_sequence_))
+  {
+    return return_type::ERROR;
+  }
+  return return_type::OK;
+}
+
+SharedMemoryRobotHardware::SharedMemoryRobotHardware(
+  const std::string & segment_name, std::chrono::nanoseconds read_timeout)
+: segment_name_(segment_name), read_timeout_(read_timeout)
+{
+}
+
+return_type SharedMemoryRobotHardware::init()
+{
+  std::vector<LayoutEntry> layout;
+  try {
+    mapping_.open(segment_name_);
+    layout = parse_layout(mapping_.header());
+  } catch (const std::exception & e) {
+    RCUTILS_LOG_ERROR_NAMED(kLoggerName, "%s", e.what());
+    return return_type::ERROR;
+  }
+
+  std::size_t state_count = 0;
+  for (const auto & entry : layout) {
+    const auto result = entry.kind == kJoint ?
+      register_joint(entry.component_name, entry.interface_name) :
+      register_actuator(entry.component_name, entry.interface_name);
+    if (result != return_type::OK) {
+      return return_type::ERROR;
+    }
+    state_count += entry.is_command ? 0 : 1;
+  }
+  auto header = mapping_.header();
+  if (header->state.value_count != state_count ||
+    header->command.value_count != layout.size() - state_count)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      kLoggerName, "layout of shared memory segment '%s' does not match its values",
+      segment_name_.c_str());
+    return return_type::ERROR;
+  }
+
+  // the registered values do not move anymore once all are registered
+  joint_state_handles_.clear();
+  actuator_state_handles_.clear();
+  joint_command_handles_.clear();
+  actuator_command_handles_.clear();
+  for (const auto & entry : layout) {
+    return_type result;
+    if (entry.kind == kJoint) {
+      auto & handles = entry.is_command ? joint_command_handles_ : joint_state_handles_;
+      handles.emplace_back(entry.component_name, entry.interface_name);
+      result = get_joint_handle(handles.back());
+    } else {
+      auto & handles = entry.is_command ? actuator_command_handles_ : actuator_state_handles_;
+      handles.emplace_back(entry.component_name, entry.interface_name);
+      result = get_actuator_handle(handles.back());
+    }
+    if (result != return_type::OK) {
+      return return_type::ERROR;
+    }
+  }
+  states_.assign(header->state.value_count, 0.0);
+  commands_.assign(header->command.value_count, 0.0);
+
+  // start from the current values of the driver
+  std::uint32_t command_sequence = 0;
+  if (!read_values(header, header->command, commands_.data(), commands_.size(), command_sequence)) {
+    return return_type::ERROR;
+  }
+  std::size_t index = 0;
+  for (auto & handle : joint_command_handles_) {
+    handle.set_value(commands_[index++]);
+  }
+  for (auto & handle : actuator_command_handles_) {
+    handle.set_value(commands_[index++]);
+  }
+  // any sequence but the current one, so that this read() does not wait
+  last_state_sequence_ = header->state.sequence.load(std::memory_order_acquire) - 1;
+  return read();
+}
+
+return_type SharedMemoryRobotHardware::read()
+{
+  auto header = mapping_.header();
+  if (header == nullptr) {
+    return return_type::ERROR;
+  }
+  if (read_timeout_ > std::chrono::nanoseconds(0) &&
+    !wait_for_write(header->state, last_state_sequence_, read_timeout_))
+  {
+    return return_type::ERROR;
+  }
+  if (!read_values(header, header->state, states_.data(), states_.size(), last_state_sequence_)) {
+    return return_type::ERROR;
+  }
+
+  std::size_t index = 0;
+  for (auto & handle : joint_state_handles_) {
+    handle.set_value(states_[index++]);
+  }
+  for (auto & handle : actuator_state_handles_) {
+    handle.set_value(states_[index++]);
+  }
+  return return_type::OK;
+}
+
+return_type SharedMemoryRobotHardware::write()
+{
+  auto header = mapping_.header();
+  if (header == nullptr) {
+    return return_type::ERROR;
+  }
+  std::size_t index = 0;
+  for (const auto & handle : joint_command_handles_) {
+    commands_[index++] = handle.get_value();
+  }
+  for (const auto & handle : actuator_command_handles_) {
+    commands_[index++] = handle.get_value();
+  }
+  write_values(header, header->command, commands_.data(), commands_.size());
+  return return_type::OK;
+}
+
+}  // namespace hardware_interface
@@ -0,0 +1,216 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hardware_interface/tracing.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace hardware_interface
+{
+namespace tracing
+{
+
+namespace
+{
+
+struct Event
+{
+  char name[kMaxNameLength + 1];
+  const char * category;
+  std::int64_t start;
+  std::int64_t end;
+};
+
+/// Single producer (the owning thread), single consumer (the drainer) ring of events
+struct ThreadBuffer
+{
+  explicit ThreadBuffer(std::uint32_t thread_id, const char * thread_name)
+  : events(kBufferCapacity), thread_id(thread_id), thread_name(thread_name)
+  {
+  }
+
+  std::vector<Event> events;
+  std::atomic<std::uint64_t> head{0};
+  std::atomic<std::uint64_t> tail{0};
+  std::atomic<std::uint64_t> dropped{0};
+  std::atomic<bool> thread_exited{false};
+  const std::uint32_t thread_id;
+  const std::string thread_name;
+};
+
+std::atomic<bool> enabled{false};
+
+/// Buffers of all threads which recorded events, protected by registry_mutex
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+std::uint32_t next_thread_id = 1;
+
+/// Marks the buffer of the thread when it exits, so that it is removed once drained
+struct ThreadBufferHolder
+{
+  ~ThreadBufferHolder()
+  {
+    if (buffer) {
+      buffer->thread_exited = true;
+    }
+  }
+
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+
+thread_local ThreadBufferHolder thread_buffer_holder;
+
+ThreadBuffer & get_thread_buffer(const char * thread_name)
+{
+  auto & holder = thread_buffer_holder;
+  if (!holder.buffer) {
+    std::lock_guard<std::mutex> guard(registry_mutex);
+    const auto thread_id = next_thread_id++;
+    const std::string name = thread_name != nullptr ?
+      std::string(thread_name) : "thread " + std::to_string(thread_id);
+    holder.buffer = std::make_shared<ThreadBuffer>(thread_id, name.c_str());
+    registry.push_back(holder.buffer);
+  }
+  return *holder.buffer;
+}
+
+void write_json_string(std::ostream & out, const char * text)
+{
+  out << '"';
+  for (const char * c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      out << '\\' << *c;
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      out << ' ';
+    } else {
+      out << *c;
+    }
+  }
+  out << '"';
+}
+
+/// Chrome trace timestamps are in microseconds
+void write_microseconds(std::ostream & out, std::int64_t nanoseconds)
+{
+  out << nanoseconds / 1000 << '.';
+  const auto fraction = nanoseconds % 1000;
+  out << (fraction < 100 ? "0" : "") << (fraction < 10 ? "0" : "") << fraction;
+}
+
+}  // namespace
+
+void set_enabled(bool enable)
+{
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool is_enabled()
+{
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void register_thread(const char * thread_name)
+{
+  get_thread_buffer(thread_name);
+}
+
+void record(const char * name, const char * category, std::int64_t start, std::int64_t end)
+{
+  auto & buffer = get_thread_buffer(nullptr);
+  const auto head = buffer.head.load(std::memory_order_relaxed);
+  if (head - buffer.tail.load(std::memory_order_acquire) >= kBufferCapacity) {
+    buffer.dropped.fetch_add(1u, std::memory_order_relaxed);
+    return;
+  }
+  auto & event = buffer.events[head % kBufferCapacity];
+  std::strncpy(event.name, name, kMaxNameLength);
+  event.name[kMaxNameLength] = '\0';
+  event.category = category;
+  event.start = start;
+  event.end = end;
+  buffer.head.store(head + 1u, std::memory_order_release);
+}
+
+DrainResult write_chrome_trace(std::ostream & out)
+{
+#ifndef _WIN32
+  const auto pid = ::getpid();
+#else
+  const auto pid = ::_getpid();
+#endif
+  DrainResult result;
+  std::lock_guard<std::mutex> guard(registry_mutex);
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first_event = true;
+  const auto separator = [&out, &first_event]()
+    {
+      if (!first_event) {
+        out << ",";
+      }
+      first_event = false;
+      out << "\n";
+    };
+  for (const auto & buffer : registry) {
+    separator();
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" <<
+      buffer->thread_id << ",\"args\":{\"name\":";
+    write_json_string(out, buffer->thread_name.c_str());
+    out << "}}";
+
+    const auto tail = buffer->tail.load(std::memory_order_relaxed);
+    const auto head = buffer->head.load(std::memory_order_acquire);
+    for (auto index = tail; index < head; ++index) {
+      const auto & event = buffer->events[index % kBufferCapacity];
+      separator();
+      out << "{\"name\":";
+      write_json_string(out, event.name);
+      out << ",\"cat\":";
+      write_json_string(out, event.category);
+      out << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->thread_id << ",\"ts\":";
+      write_microseconds(out, event.start);
+      out << ",\"dur\":";
+      write_microseconds(out, event.end - event.start);
+      out << "}";
+    }
+    buffer->tail.store(head, std::memory_order_release);
+    result.events += head - tail;
+    result.dropped_events += buffer->dropped.exchange(0u, std::memory_order_relaxed);
+  }
+  out << "\n]}\n";
+
+  // the buffers of exited threads are not written anymore
+  registry.erase(
+    std::remove_if(
+      registry.begin(), registry.end(),
+      [](const std::shared_ptr<ThreadBuffer> & buffer) {return buffer->thread_exited.load();}),
+    registry.end());
+  return result;
+}
+
+}  // namespace tracing
+}  // namespace hardware_interface
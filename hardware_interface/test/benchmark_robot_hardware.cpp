@@ -0,0 +1,245 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of the RobotHardware registry and handles, scaling the number of joints and
+// of interfaces per joint. Besides the time per iteration, every benchmark reports
+//  - time/op: time per operation, e.g. per registered interface or per handle lookup
+//  - allocs/op: heap allocations per operation
+// Compare against the checked in baseline with the compare.py tool of google benchmark:
+//   benchmark_robot_hardware --benchmark_repetitions=5 --benchmark_report_aggregates_only=true \
+//     --benchmark_out=current.json --benchmark_out_format=json
+//   compare.py benchmarks benchmark_robot_hardware_baseline.json current.json
+// Only the aggregates over the repetitions are kept in the baseline, so that re-recording it
+// changes one entry per statistic and benchmark.
+// The baseline was recorded with 5 repetitions on a VM with 1 vCPU of an Intel Xeon at 2 GHz,
+// without frequency scaling, from a Release build (-O3 -DNDEBUG) of this package. It is linked
+// to the google benchmark 1.7.1 of the distribution, which is optimized but built without NDEBUG
+// and therefore reports "library_build_type": "debug". Times only compare on a similar machine,
+// elsewhere record a baseline from the parent commit first; allocs/op compare anywhere.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/joint_handle.hpp"
+#include "hardware_interface/robot_hardware.hpp"
+
+namespace hw = hardware_interface;
+
+namespace
+{
+std::atomic<std::uint64_t> allocation_count{0};
+}  // namespace
+
+void * operator new(std::size_t size)
+{
+  ++allocation_count;
+  void * ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace
+{
+
+class BenchmarkRobotHardware : public hw::RobotHardware
+{
+public:
+  hw::return_type init() override
+  {
+    return hw::return_type::OK;
+  }
+
+  hw::return_type read() override
+  {
+    return hw::return_type::OK;
+  }
+
+  hw::return_type write() override
+  {
+    return hw::return_type::OK;
+  }
+};
+
+std::vector<std::string> make_names(const std::string & prefix, int64_t count)
+{
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < count; ++i) {
+    names.push_back(prefix + std::to_string(i));
+  }
+  return names;
+}
+
+void register_all(
+  BenchmarkRobotHardware & robot_hw,
+  const std::vector<std::string> & joint_names,
+  const std::vector<std::string> & interface_names)
+{
+  for (const auto & joint_name : joint_names) {
+    for (const auto & interface_name : interface_names) {
+      robot_hw.register_joint(joint_name, interface_name);
+    }
+  }
+}
+
+/// Counts allocations and operations while a benchmark runs and reports them per operation
+class OperationCounter
+{
+public:
+  OperationCounter(benchmark::State & state, int64_t operations_per_iteration)
+  : state_(state),
+    operations_per_iteration_(operations_per_iteration),
+    allocations_at_start_(allocation_count)
+  {
+  }
+
+  ~OperationCounter()
+  {
+    const double operations =
+      static_cast<double>(state_.iterations()) * static_cast<double>(operations_per_iteration_);
+    state_.counters["allocs/op"] = operations > 0.0 ?
+      static_cast<double>(allocation_count - allocations_at_start_) / operations : 0.0;
+    state_.counters["time/op"] = benchmark::Counter(
+      static_cast<double>(operations_per_iteration_),
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  }
+
+private:
+  benchmark::State & state_;
+  int64_t operations_per_iteration_;
+  std::uint64_t allocations_at_start_;
+};
+
+// Arguments: number of joints, number of interfaces per joint
+void joint_and_interface_counts(benchmark::internal::Benchmark * benchmark)
+{
+  for (int64_t joints : {10, 100, 1000}) {
+    for (int64_t interfaces : {1, 3, 6}) {
+      benchmark->Args({joints, interfaces});
+    }
+  }
+  benchmark->ArgNames({"joints", "interfaces"});
+}
+
+}  // namespace
+
+// Registers all interfaces of all joints into an empty hardware, op = one register_joint()
+static void BM_register_joint(benchmark::State & state)
+{
+  const auto joint_names = make_names("joint", state.range(0));
+  const auto interface_names = make_names("interface", state.range(1));
+  OperationCounter counter(state, state.range(0) * state.range(1));
+  for (auto _ : state) {
+    BenchmarkRobotHardware robot_hw;
+    register_all(robot_hw, joint_names, interface_names);
+    benchmark::DoNotOptimize(robot_hw.get_registered_joint_state());
+  }
+}
+BENCHMARK(BM_register_joint)->Apply(joint_and_interface_counts);
+
+// Looks up the handle of every registered interface, op = one get_joint_handle()
+static void BM_get_joint_handle(benchmark::State & state)
+{
+  const auto joint_names = make_names("joint", state.range(0));
+  const auto interface_names = make_names("interface", state.range(1));
+  BenchmarkRobotHardware robot_hw;
+  register_all(robot_hw, joint_names, interface_names);
+  std::vector<hw::JointHandle> handles;
+  for (const auto & joint_name : joint_names) {
+    for (const auto & interface_name : interface_names) {
+      handles.emplace_back(joint_name, interface_name);
+    }
+  }
+
+  OperationCounter counter(state, state.range(0) * state.range(1));
+  for (auto _ : state) {
+    for (auto & handle : handles) {
+      robot_hw.get_joint_handle(handle);
+    }
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_get_joint_handle)->Apply(joint_and_interface_counts);
+
+// Collects the handles of all joints for each interface, op = one get_joint_handles()
+static void BM_get_joint_handles(benchmark::State & state)
+{
+  const auto joint_names = make_names("joint", state.range(0));
+  const auto interface_names = make_names("interface", state.range(1));
+  BenchmarkRobotHardware robot_hw;
+  register_all(robot_hw, joint_names, interface_names);
+
+  OperationCounter counter(state, state.range(1));
+  for (auto _ : state) {
+    for (const auto & interface_name : interface_names) {
+      std::vector<hw::JointHandle> handles;
+      robot_hw.get_joint_handles(handles, interface_name);
+      benchmark::DoNotOptimize(handles.data());
+    }
+  }
+}
+BENCHMARK(BM_get_joint_handles)->Apply(joint_and_interface_counts);
+
+// Creates handles for all registered interfaces, op = one get_registered_joints()
+static void BM_get_registered_joints(benchmark::State & state)
+{
+  const auto joint_names = make_names("joint", state.range(0));
+  const auto interface_names = make_names("interface", state.range(1));
+  BenchmarkRobotHardware robot_hw;
+  register_all(robot_hw, joint_names, interface_names);
+
+  OperationCounter counter(state, 1);
+  for (auto _ : state) {
+    auto handles = robot_hw.get_registered_joints();
+    benchmark::DoNotOptimize(handles.data());
+  }
+}
+BENCHMARK(BM_get_registered_joints)->Apply(joint_and_interface_counts);
+
+// Reads and writes every registered interface through its handle,
+// op = one get_value() and one set_value()
+static void BM_handle_get_set_value(benchmark::State & state)
+{
+  const auto joint_names = make_names("joint", state.range(0));
+  const auto interface_names = make_names("interface", state.range(1));
+  BenchmarkRobotHardware robot_hw;
+  register_all(robot_hw, joint_names, interface_names);
+  auto handles = robot_hw.get_registered_joints();
+
+  OperationCounter counter(state, state.range(0) * state.range(1));
+  for (auto _ : state) {
+    for (auto & handle : handles) {
+      handle.set_value(handle.get_value() + 1.0);
+    }
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_handle_get_set_value)->Apply(joint_and_interface_counts);
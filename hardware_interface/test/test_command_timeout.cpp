@@ -0,0 +1,193 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+
+#include "hardware_interface/robot_hardware.hpp"
+
+namespace hw = hardware_interface;
+
+namespace
+{
+constexpr auto POSITION_JOINT = "position_joint";
+constexpr auto VELOCITY_JOINT = "velocity_joint";
+}  // namespace
+
+class TestCommandTimeout : public testing::Test
+{
+  class DummyRobotHardware : public hw::RobotHardware
+  {
+    hw::return_type init() override
+    {
+      return hw::return_type::OK;
+    }
+
+    hw::return_type read() override
+    {
+      return hw::return_type::OK;
+    }
+
+    hw::return_type write() override
+    {
+      return hw::return_type::OK;
+    }
+  };
+
+protected:
+  void SetUp() override
+  {
+    robot_hw_.register_joint(POSITION_JOINT, "position");
+    robot_hw_.register_joint(POSITION_JOINT, "position_command");
+    robot_hw_.register_joint(POSITION_JOINT, "velocity_command");
+    robot_hw_.register_joint(VELOCITY_JOINT, "velocity");
+    robot_hw_.register_joint(VELOCITY_JOINT, "velocity_command");
+    ASSERT_EQ(hw::return_type::OK, robot_hw_.get_joint_handle(position_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw_.get_joint_handle(position_command_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw_.get_joint_handle(feedforward_command_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw_.get_joint_handle(velocity_command_));
+  }
+
+  DummyRobotHardware robot_hw_;
+  hw::JointHandle position_{POSITION_JOINT, "position"};
+  hw::JointHandle position_command_{POSITION_JOINT, "position_command"};
+  hw::JointHandle feedforward_command_{POSITION_JOINT, "velocity_command"};
+  hw::JointHandle velocity_command_{VELOCITY_JOINT, "velocity_command"};
+};
+
+TEST_F(TestCommandTimeout, fresh_commands_are_kept)
+{
+  ASSERT_EQ(
+    hw::return_type::OK,
+    robot_hw_.set_command_timeout(POSITION_JOINT, 2, hw::CommandTimeoutPolicy::HOLD));
+  for (int i = 0; i < 10; ++i) {
+    position_command_.set_value(i);
+    feedforward_command_.set_value(2.0 * i);
+    robot_hw_.enforce_command_timeouts();
+    EXPECT_EQ(i, position_command_.get_value());
+    EXPECT_EQ(2.0 * i, feedforward_command_.get_value());
+  }
+  EXPECT_EQ(0u, robot_hw_.get_stale_command_count());
+}
+
+TEST_F(TestCommandTimeout, stale_commands_hold_the_position)
+{
+  ASSERT_EQ(
+    hw::return_type::OK,
+    robot_hw_.set_command_timeout(POSITION_JOINT, 2, hw::CommandTimeoutPolicy::HOLD));
+  position_.set_value(0.5);
+  position_command_.set_value(1.0);
+  feedforward_command_.set_value(3.0);
+  robot_hw_.enforce_command_timeouts();
+
+  // tolerated for two cycles without writes
+  robot_hw_.enforce_command_timeouts();
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(1.0, position_command_.get_value());
+  EXPECT_EQ(0u, robot_hw_.get_stale_command_count());
+
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(0.5, position_command_.get_value());
+  EXPECT_EQ(0.0, feedforward_command_.get_value());
+  EXPECT_EQ(2u, robot_hw_.get_stale_command_count());
+
+  // the hold position is not updated while the joint moves
+  position_.set_value(0.7);
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(0.5, position_command_.get_value());
+
+  position_command_.set_value(2.0);
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(2.0, position_command_.get_value());
+  EXPECT_EQ(1u, robot_hw_.get_stale_command_count());
+}
+
+TEST_F(TestCommandTimeout, stale_commands_are_zeroed)
+{
+  ASSERT_EQ(
+    hw::return_type::OK,
+    robot_hw_.set_command_timeout(VELOCITY_JOINT, 0, hw::CommandTimeoutPolicy::ZERO));
+  velocity_command_.set_value(1.0);
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(1.0, velocity_command_.get_value());
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(0.0, velocity_command_.get_value());
+  // commands of unmonitored joints are left alone
+  EXPECT_EQ(0.0, position_command_.get_value());
+}
+
+TEST_F(TestCommandTimeout, handles_taken_later_mark_commands_fresh)
+{
+  ASSERT_EQ(
+    hw::return_type::OK,
+    robot_hw_.set_command_timeout(VELOCITY_JOINT, 0, hw::CommandTimeoutPolicy::ZERO));
+  for (auto & handle : robot_hw_.get_registered_joints()) {
+    if (handle.get_name() == VELOCITY_JOINT && handle.get_interface_name() == "velocity_command") {
+      handle.set_value(4.0);
+    }
+  }
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(4.0, velocity_command_.get_value());
+  EXPECT_EQ(0u, robot_hw_.get_stale_command_count());
+}
+
+TEST_F(TestCommandTimeout, invalid_configurations_are_rejected)
+{
+  EXPECT_EQ(
+    hw::return_type::ERROR,
+    robot_hw_.set_command_timeout("unknown_joint", 1, hw::CommandTimeoutPolicy::HOLD));
+  robot_hw_.register_joint("sensor_joint", "position");
+  EXPECT_EQ(
+    hw::return_type::ERROR,
+    robot_hw_.set_command_timeout("sensor_joint", 1, hw::CommandTimeoutPolicy::HOLD));
+}
+
+TEST_F(TestCommandTimeout, position_commands_are_never_zeroed)
+{
+  EXPECT_EQ(
+    hw::return_type::ERROR,
+    robot_hw_.set_command_timeout(POSITION_JOINT, 0, hw::CommandTimeoutPolicy::ZERO));
+  robot_hw_.register_joint("blind_joint", "position_command");
+  EXPECT_EQ(
+    hw::return_type::ERROR,
+    robot_hw_.set_command_timeout("blind_joint", 0, hw::CommandTimeoutPolicy::HOLD));
+  hw::JointHandle blind_command("blind_joint", "position_command");
+  ASSERT_EQ(hw::return_type::OK, robot_hw_.get_joint_handle(blind_command));
+
+  position_.set_value(0.5);
+  position_command_.set_value(1.0);
+  blind_command.set_value(1.0);
+  for (int i = 0; i < 3; ++i) {
+    robot_hw_.enforce_command_timeouts();
+  }
+  EXPECT_EQ(1.0, position_command_.get_value());
+  EXPECT_EQ(1.0, blind_command.get_value());
+  EXPECT_EQ(0u, robot_hw_.get_stale_command_count());
+}
+
+TEST_F(TestCommandTimeout, rejected_timeouts_keep_the_previous_one)
+{
+  ASSERT_EQ(
+    hw::return_type::OK,
+    robot_hw_.set_command_timeout(POSITION_JOINT, 0, hw::CommandTimeoutPolicy::HOLD));
+  EXPECT_EQ(
+    hw::return_type::ERROR,
+    robot_hw_.set_command_timeout(POSITION_JOINT, 0, hw::CommandTimeoutPolicy::ZERO));
+  position_.set_value(0.5);
+  position_command_.set_value(1.0);
+  robot_hw_.enforce_command_timeouts();
+  robot_hw_.enforce_command_timeouts();
+  EXPECT_EQ(0.5, position_command_.get_value());
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <gmock/gmock.h>
+#include <limits>
 #include <string>
 
 #include "hardware_interface/component_parser.hpp"
@@ -455,6 +456,30 @@ protected:
   </ros2_control>
 )";
 
+// 10. Typed parameters and interface limits
+    valid_urdf_ros2_control_typed_parameters_ =
+      R"(
+  <ros2_control name="2DOF_System_Robot_Typed" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_Position_Only</classType>
+      <param name="example_param_write_for_sec" unit="s">2.2</param>
+      <param name="example_param_read_for_sec" type="double">2</param>
+      <param name="simulate">True</param>
+    </hardware>
+    <joint name="joint1">
+      <classType>ros2_control_components/PositionJoint</classType>
+      <commandInterfaceType name="position">
+        <param name="min">-3.14</param>
+        <param name="max">3.14</param>
+      </commandInterfaceType>
+      <commandInterfaceType name="velocity"/>
+      <param name="encoder_ticks" unit="ticks">4096</param>
+      <param name="serial_number" type="string">1234</param>
+      <param name="serial_port">/dev/ttyUSB0</param>
+    </joint>
+  </ros2_control>
+)";
+
 // Errors
     invalid_urdf_ros2_control_invalid_child_ =
       R"(
@@ -558,6 +583,74 @@ protected:
     </joint>
   </ros2_control>
 )";
+
+    invalid_urdf_ros2_control_interface_limit_not_a_number_ =
+      R"(
+  <ros2_control name="2DOF_System_Robot_Position_Only" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_Position_Only</classType>
+      <param name="example_param_read_for_sec">2</param>
+    </hardware>
+    <joint name="joint1">
+      <classType>ros2_control_components/PositionJoint</classType>
+      <commandInterfaceType name="position">
+        <param name="min">abc</param>
+        <param name="max">1</param>
+      </commandInterfaceType>
+    </joint>
+  </ros2_control>
+)";
+
+    invalid_urdf_ros2_control_interface_limits_inverted_ =
+      R"(
+  <ros2_control name="2DOF_System_Robot_Position_Only" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_Position_Only</classType>
+      <param name="example_param_read_for_sec">2</param>
+    </hardware>
+    <joint name="joint1">
+      <classType>ros2_control_components/PositionJoint</classType>
+      <commandInterfaceType name="position">
+        <param name="min">1</param>
+        <param name="max">-1</param>
+      </commandInterfaceType>
+    </joint>
+  </ros2_control>
+)";
+
+    invalid_urdf_ros2_control_parameter_type_mismatch_ =
+      R"(
+  <ros2_control name="2DOF_System_Robot_Position_Only" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_Position_Only</classType>
+      <param name="example_param_read_for_sec" type="int">2.5</param>
+    </hardware>
+    <joint name="joint1">
+      <classType>ros2_control_components/PositionJoint</classType>
+      <commandInterfaceType name="position">
+        <param name="min">-1</param>
+        <param name="max">1</param>
+      </commandInterfaceType>
+    </joint>
+  </ros2_control>
+)";
+
+    invalid_urdf_ros2_control_parameter_unknown_type_ =
+      R"(
+  <ros2_control name="2DOF_System_Robot_Position_Only" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_Position_Only</classType>
+      <param name="example_param_read_for_sec" type="float">2</param>
+    </hardware>
+    <joint name="joint1">
+      <classType>ros2_control_components/PositionJoint</classType>
+      <commandInterfaceType name="position">
+        <param name="min">-1</param>
+        <param name="max">1</param>
+      </commandInterfaceType>
+    </joint>
+  </ros2_control>
+)";
   }
 
   std::string urdf_xml_head_, urdf_xml_tail_;
@@ -570,6 +663,7 @@ protected:
   std::string valid_urdf_ros2_control_system_muti_joints_transmission_;
   std::string valid_urdf_ros2_control_sensor_only_;
   std::string valid_urdf_ros2_control_actuator_only_;
+  std::string valid_urdf_ros2_control_typed_parameters_;
 
   std::string invalid_urdf_ros2_control_invalid_child_;
   std::string invalid_urdf_ros2_control_missing_attribute_;
@@ -578,6 +672,10 @@ protected:
   std::string invalid_urdf_ros2_control_component_interface_type_empty_;
   std::string invalid_urdf_ros2_control_parameter_missing_name_;
   std::string invalid_urdf_ros2_control_parameter_empty_;
+  std::string invalid_urdf_ros2_control_interface_limit_not_a_number_;
+  std::string invalid_urdf_ros2_control_interface_limits_inverted_;
+  std::string invalid_urdf_ros2_control_parameter_type_mismatch_;
+  std::string invalid_urdf_ros2_control_parameter_unknown_type_;
 };
 
 using hardware_interface::parse_control_resources_from_urdf;
@@ -661,6 +759,80 @@ TEST_F(TestComponentParser, parameter_empty_throws_error)
   ASSERT_THROW(parse_control_resources_from_urdf(broken_urdf_string), std::runtime_error);
 }
 
+TEST_F(TestComponentParser, interface_limit_not_a_number_throws_error)
+{
+  const std::string broken_urdf_string = urdf_xml_head_ +
+    invalid_urdf_ros2_control_interface_limit_not_a_number_ + urdf_xml_tail_;
+
+  ASSERT_THROW(parse_control_resources_from_urdf(broken_urdf_string), std::runtime_error);
+}
+
+TEST_F(TestComponentParser, interface_limits_inverted_throws_error)
+{
+  const std::string broken_urdf_string = urdf_xml_head_ +
+    invalid_urdf_ros2_control_interface_limits_inverted_ + urdf_xml_tail_;
+
+  ASSERT_THROW(parse_control_resources_from_urdf(broken_urdf_string), std::runtime_error);
+}
+
+TEST_F(TestComponentParser, parameter_type_mismatch_throws_error)
+{
+  const std::string broken_urdf_string = urdf_xml_head_ +
+    invalid_urdf_ros2_control_parameter_type_mismatch_ + urdf_xml_tail_;
+
+  ASSERT_THROW(parse_control_resources_from_urdf(broken_urdf_string), std::runtime_error);
+}
+
+TEST_F(TestComponentParser, parameter_unknown_type_throws_error)
+{
+  const std::string broken_urdf_string = urdf_xml_head_ +
+    invalid_urdf_ros2_control_parameter_unknown_type_ + urdf_xml_tail_;
+
+  ASSERT_THROW(parse_control_resources_from_urdf(broken_urdf_string), std::runtime_error);
+}
+
+TEST_F(TestComponentParser, parameter_numbers_are_parsed_strictly)
+{
+  using hardware_interface::ParameterValue;
+
+  const auto parse_parameter = [this](const std::string & type, const std::string & text)
+    {
+      const std::string type_attribute = type.empty() ? "" : " type=\"" + type + "\"";
+      const std::string urdf_to_test = urdf_xml_head_ +
+        R"(
+  <ros2_control name="Strict_System" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_Position_Only</classType>
+      <param name="value")" + type_attribute + ">" + text + R"(</param>
+    </hardware>
+  </ros2_control>
+)" + urdf_xml_tail_;
+      return parse_control_resources_from_urdf(urdf_to_test).at(0).typed_hardware_parameters.at(
+        "value");
+    };
+
+  // leading whitespace is not skipped
+  EXPECT_THROW(parse_parameter("int", " 1"), std::runtime_error);
+  EXPECT_THROW(parse_parameter("double", " 1.5"), std::runtime_error);
+  EXPECT_EQ(ParameterValue::Type::STRING, parse_parameter("", " 1").type);
+
+  // only finite numbers are accepted
+  EXPECT_THROW(parse_parameter("double", "nan"), std::runtime_error);
+  EXPECT_THROW(parse_parameter("double", "inf"), std::runtime_error);
+  EXPECT_THROW(parse_parameter("double", "-infinity"), std::runtime_error);
+  EXPECT_THROW(parse_parameter("double", "1e999"), std::runtime_error);
+  EXPECT_THROW(parse_parameter("int", "99999999999999999999"), std::runtime_error);
+  EXPECT_EQ(ParameterValue::Type::STRING, parse_parameter("", "nan").type);
+  EXPECT_EQ(ParameterValue::Type::STRING, parse_parameter("", "-1e999").type);
+
+  // an underflow is not an error
+  const auto denormal = parse_parameter("double", "1e-310");
+  EXPECT_EQ(ParameterValue::Type::DOUBLE, denormal.type);
+  EXPECT_DOUBLE_EQ(1e-310, denormal.double_value);
+  EXPECT_EQ(ParameterValue::Type::DOUBLE, parse_parameter("", "1e-400").type);
+  EXPECT_EQ(ParameterValue::Type::INTEGER, parse_parameter("int", "-9223372036854775808").type);
+}
+
 TEST_F(TestComponentParser, successfully_parse_valid_urdf_system_one_interface)
 {
   std::string urdf_to_test = urdf_xml_head_ + valid_urdf_ros2_control_system_one_interface_ +
@@ -1063,3 +1235,50 @@ TEST_F(TestComponentParser, successfully_parse_valid_urdf_actuator_only)
   ASSERT_THAT(hardware_info.transmissions[0].parameters, SizeIs(1));
   EXPECT_EQ(hardware_info.transmissions[0].parameters.at("joint_to_actuator"), "${1024/PI}");
 }
+
+TEST_F(TestComponentParser, successfully_parse_valid_urdf_typed_parameters)
+{
+  using hardware_interface::ParameterValue;
+
+  std::string urdf_to_test = urdf_xml_head_ +
+    valid_urdf_ros2_control_typed_parameters_ + urdf_xml_tail_;
+  const auto control_hardware = parse_control_resources_from_urdf(urdf_to_test);
+  ASSERT_THAT(control_hardware, SizeIs(1));
+  auto hardware_info = control_hardware.at(0);
+
+  // raw strings are kept for backward compatibility
+  EXPECT_EQ(hardware_info.hardware_parameters.at("example_param_write_for_sec"), "2.2");
+  ASSERT_THAT(hardware_info.typed_hardware_parameters, SizeIs(3));
+  const auto & write_for_sec = hardware_info.typed_hardware_parameters.at(
+    "example_param_write_for_sec");
+  EXPECT_EQ(write_for_sec.type, ParameterValue::Type::DOUBLE);
+  EXPECT_DOUBLE_EQ(write_for_sec.double_value, 2.2);
+  EXPECT_EQ(write_for_sec.unit, "s");
+  const auto & read_for_sec = hardware_info.typed_hardware_parameters.at(
+    "example_param_read_for_sec");
+  EXPECT_EQ(read_for_sec.type, ParameterValue::Type::DOUBLE);
+  EXPECT_DOUBLE_EQ(read_for_sec.double_value, 2.0);
+  const auto & simulate = hardware_info.typed_hardware_parameters.at("simulate");
+  EXPECT_EQ(simulate.type, ParameterValue::Type::BOOL);
+  EXPECT_TRUE(simulate.bool_value);
+
+  ASSERT_THAT(hardware_info.joints, SizeIs(1));
+  const auto & joint = hardware_info.joints[0];
+  ASSERT_THAT(joint.command_interfaces, SizeIs(2));
+  EXPECT_EQ(joint.command_interfaces[0].min, "-3.14");
+  EXPECT_DOUBLE_EQ(joint.command_interfaces[0].min_value, -3.14);
+  EXPECT_DOUBLE_EQ(joint.command_interfaces[0].max_value, 3.14);
+  EXPECT_EQ(joint.command_interfaces[1].min_value, -std::numeric_limits<double>::infinity());
+  EXPECT_EQ(joint.command_interfaces[1].max_value, std::numeric_limits<double>::infinity());
+
+  ASSERT_THAT(joint.typed_parameters, SizeIs(3));
+  const auto & encoder_ticks = joint.typed_parameters.at("encoder_ticks");
+  EXPECT_EQ(encoder_ticks.type, ParameterValue::Type::INTEGER);
+  EXPECT_EQ(encoder_ticks.int_value, 4096);
+  EXPECT_DOUBLE_EQ(encoder_ticks.double_value, 4096.0);
+  EXPECT_EQ(encoder_ticks.unit, "ticks");
+  const auto & serial_number = joint.typed_parameters.at("serial_number");
+  EXPECT_EQ(serial_number.type, ParameterValue::Type::STRING);
+  EXPECT_EQ(serial_number.string_value, "1234");
+  EXPECT_EQ(joint.typed_parameters.at("serial_port").type, ParameterValue::Type::STRING);
+}
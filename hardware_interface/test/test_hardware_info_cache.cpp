@@ -0,0 +1,213 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/component_parser.hpp"
+#include "hardware_interface/hardware_info_cache.hpp"
+
+using namespace ::testing;  // NOLINT
+
+class TestHardwareInfoCache : public Test
+{
+protected:
+  void SetUp() override
+  {
+    urdf_ =
+      R"(
+<?xml version="1.0" encoding="utf-8"?>
+<robot name="MinimalRobot">
+  <link name="world"/>
+  <ros2_control name="2DOF_System_Robot_MultiInterface" type="system">
+    <hardware>
+      <classType>ros2_control_demo_hardware/2DOF_System_Hardware_MultiInterface</classType>
+      <param name="example_param_write_for_sec">2.2</param>
+      <param name="example_param_read_for_sec">2.3</param>
+    </hardware>
+    <joint name="joint1">
+      <classType>ros2_control_components/MultiInterfaceJoint</classType>
+      <commandInterfaceType name="position">
+        <param name="min">-1</param>
+        <param name="max">1</param>
+      </commandInterfaceType>
+      <stateInterfaceType>position</stateInterfaceType>
+      <stateInterfaceType>velocity</stateInterfaceType>
+      <param name="serial_number">A42B1</param>
+    </joint>
+    <sensor name="tcp_fts_sensor">
+      <classType>ros2_control_components/ForceTorqueSensor</classType>
+      <param name="frame_id">kuka_tcp</param>
+    </sensor>
+    <transmission name="transmission1">
+      <classType>transmission_interface/SimpleTansmission</classType>
+      <param name="joint_to_actuator">${1024/PI}</param>
+    </transmission>
+  </ros2_control>
+</robot>
+)";
+    cache_path_ = "test_hardware_info_cache.bin";
+    std::remove(cache_path_.c_str());
+  }
+
+  void TearDown() override
+  {
+    std::remove(cache_path_.c_str());
+  }
+
+  void write_cache(const std::string & urdf)
+  {
+    hardware_interface::cache::CacheFileWriter writer(hardware_interface::cache::hash_urdf(urdf));
+    writer.add_section(
+      hardware_interface::kHardwareInfoCacheSection,
+      hardware_interface::serialize_hardware_info(
+        hardware_interface::parse_control_resources_from_urdf(urdf)));
+    writer.write(cache_path_);
+  }
+
+  std::string urdf_;
+  std::string cache_path_;
+};
+
+TEST_F(TestHardwareInfoCache, serialization_round_trip)
+{
+  const auto parsed = hardware_interface::parse_control_resources_from_urdf(urdf_);
+  const auto payload = hardware_interface::serialize_hardware_info(parsed);
+
+  hardware_interface::cache::Reader reader(payload.data(), payload.size());
+  const auto restored = hardware_interface::deserialize_hardware_info(reader);
+
+  ASSERT_THAT(restored, SizeIs(1));
+  EXPECT_EQ(restored[0].name, "2DOF_System_Robot_MultiInterface");
+  EXPECT_EQ(restored[0].type, "system");
+  EXPECT_EQ(
+    restored[0].hardware_class_type,
+    "ros2_control_demo_hardware/2DOF_System_Hardware_MultiInterface");
+  EXPECT_EQ(restored[0].hardware_parameters, parsed[0].hardware_parameters);
+  EXPECT_EQ(
+    restored[0].typed_hardware_parameters.at("example_param_write_for_sec").type,
+    hardware_interface::ParameterValue::Type::DOUBLE);
+  EXPECT_EQ(
+    restored[0].typed_hardware_parameters.at("example_param_write_for_sec").double_value, 2.2);
+  ASSERT_THAT(restored[0].joints, SizeIs(1));
+  EXPECT_EQ(restored[0].joints[0].name, "joint1");
+  ASSERT_THAT(restored[0].joints[0].command_interfaces, SizeIs(1));
+  EXPECT_EQ(restored[0].joints[0].command_interfaces[0].name, "position");
+  EXPECT_EQ(restored[0].joints[0].command_interfaces[0].min, "-1");
+  EXPECT_EQ(restored[0].joints[0].command_interfaces[0].max, "1");
+  EXPECT_EQ(restored[0].joints[0].command_interfaces[0].min_value, -1.0);
+  EXPECT_EQ(restored[0].joints[0].command_interfaces[0].max_value, 1.0);
+  ASSERT_THAT(restored[0].joints[0].state_interfaces, SizeIs(2));
+  EXPECT_EQ(restored[0].joints[0].state_interfaces[1].name, "velocity");
+  EXPECT_EQ(restored[0].joints[0].parameters.at("serial_number"), "A42B1");
+  ASSERT_THAT(restored[0].sensors, SizeIs(1));
+  EXPECT_EQ(restored[0].sensors[0].parameters.at("frame_id"), "kuka_tcp");
+  ASSERT_THAT(restored[0].transmissions, SizeIs(1));
+  EXPECT_EQ(restored[0].transmissions[0].class_type, "transmission_interface/SimpleTansmission");
+}
+
+TEST_F(TestHardwareInfoCache, truncated_payload_throws_error)
+{
+  const auto payload = hardware_interface::serialize_hardware_info(
+    hardware_interface::parse_control_resources_from_urdf(urdf_));
+
+  hardware_interface::cache::Reader reader(payload.data(), payload.size() / 2);
+  ASSERT_THROW(hardware_interface::deserialize_hardware_info(reader), std::runtime_error);
+}
+
+TEST_F(TestHardwareInfoCache, cache_file_round_trip)
+{
+  write_cache(urdf_);
+
+  hardware_interface::cache::CacheFile cache_file(cache_path_);
+  EXPECT_TRUE(cache_file.is_valid_for(urdf_));
+  EXPECT_FALSE(cache_file.is_valid_for(urdf_ + " "));
+  EXPECT_TRUE(cache_file.has_section(hardware_interface::kHardwareInfoCacheSection));
+  EXPECT_FALSE(cache_file.has_section("TRNS"));
+  ASSERT_THROW(cache_file.get_section("TRNS"), std::runtime_error);
+
+  const auto hardware_info =
+    hardware_interface::parse_control_resources_from_urdf(urdf_, cache_path_);
+  ASSERT_THAT(hardware_info, SizeIs(1));
+  EXPECT_EQ(hardware_info[0].name, "2DOF_System_Robot_MultiInterface");
+}
+
+TEST_F(TestHardwareInfoCache, stale_or_missing_cache_falls_back_to_urdf)
+{
+  // missing cache file
+  auto hardware_info = hardware_interface::parse_control_resources_from_urdf(urdf_, cache_path_);
+  ASSERT_THAT(hardware_info, SizeIs(1));
+
+  // cache generated for another URDF must not be used
+  std::string other_urdf = urdf_;
+  other_urdf.replace(other_urdf.find("joint1"), 6, "jointX");
+  write_cache(other_urdf);
+  hardware_info = hardware_interface::parse_control_resources_from_urdf(urdf_, cache_path_);
+  ASSERT_THAT(hardware_info, SizeIs(1));
+  ASSERT_THAT(hardware_info[0].joints, SizeIs(1));
+  EXPECT_EQ(hardware_info[0].joints[0].name, "joint1");
+}
+
+TEST_F(TestHardwareInfoCache, corrupted_cache_file_throws_error)
+{
+  {
+    std::ofstream file(cache_path_, std::ios::binary);
+    file << "RCDC";
+  }
+  ASSERT_THROW(hardware_interface::cache::CacheFile cache_file(cache_path_), std::runtime_error);
+  // the parser falls back to the URDF
+  ASSERT_THAT(
+    hardware_interface::parse_control_resources_from_urdf(urdf_, cache_path_), SizeIs(1));
+}
+
+TEST_F(TestHardwareInfoCache, corrupted_element_count_throws_error)
+{
+  auto payload = hardware_interface::serialize_hardware_info(
+    hardware_interface::parse_control_resources_from_urdf(urdf_));
+  // number of hardware components
+  std::memset(&payload[0], 0xff, sizeof(std::uint32_t));
+
+  hardware_interface::cache::Reader reader(payload.data(), payload.size());
+  ASSERT_THROW(hardware_interface::deserialize_hardware_info(reader), std::runtime_error);
+
+  hardware_interface::cache::CacheFileWriter writer(hardware_interface::cache::hash_urdf(urdf_));
+  writer.add_section(hardware_interface::kHardwareInfoCacheSection, payload);
+  writer.write(cache_path_);
+  // the parser falls back to the URDF
+  ASSERT_THAT(
+    hardware_interface::parse_control_resources_from_urdf(urdf_, cache_path_), SizeIs(1));
+}
+
+TEST_F(TestHardwareInfoCache, corrupted_payload_only_throws_runtime_error)
+{
+  const auto payload = hardware_interface::serialize_hardware_info(
+    hardware_interface::parse_control_resources_from_urdf(urdf_));
+
+  // whichever value a count or string size gets, the reader must not try to allocate for it
+  for (std::size_t offset = 0; offset + sizeof(std::uint32_t) <= payload.size(); ++offset) {
+    auto corrupted = payload;
+    std::memset(&corrupted[offset], 0xff, sizeof(std::uint32_t));
+    hardware_interface::cache::Reader reader(corrupted.data(), corrupted.size());
+    try {
+      hardware_interface::deserialize_hardware_info(reader);
+    } catch (const std::runtime_error &) {
+    }
+  }
+}
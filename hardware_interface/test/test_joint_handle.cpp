@@ -13,6 +13,9 @@
 // limitations under the License.
 
 #include <gmock/gmock.h>
+
+#include <cstdint>
+
 #include "hardware_interface/joint_handle.hpp"
 
 using hardware_interface::JointHandle;
@@ -54,3 +57,15 @@ TEST(TestJointHandle, with_value_ptr_initializes_new_handle_correctly)
   EXPECT_ANY_THROW(handle.get_value());
   EXPECT_DOUBLE_EQ(new_handle.get_value(), value);
 }
+
+TEST(TestJointHandle, set_value_marks_the_value_written)
+{
+  double value = 1.337;
+  std::uint8_t written = 0;
+  JointHandle handle{JOINT_NAME, FOO_INTERFACE};
+  auto new_handle = handle.with_value_ptr(&value, &written);
+  EXPECT_DOUBLE_EQ(new_handle.get_value(), value);
+  EXPECT_EQ(0u, written);
+  new_handle.set_value(0.0);
+  EXPECT_EQ(1u, written);
+}
@@ -0,0 +1,229 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/recorder.hpp"
+#include "hardware_interface/replay_robot_hardware.hpp"
+#include "hardware_interface/robot_hardware.hpp"
+
+namespace hw = hardware_interface;
+using testing::ElementsAre;
+
+namespace
+{
+constexpr auto JOINT_NAME = "joint_1";
+constexpr auto ACTUATOR_NAME = "actuator_1";
+constexpr auto RECORDING = "test_recorder_recording.bin";
+}  // namespace
+
+class TestRecorder : public testing::Test
+{
+  class DummyRobotHardware : public hw::RobotHardware
+  {
+    hw::return_type init() override
+    {
+      return hw::return_type::OK;
+    }
+
+    hw::return_type read() override
+    {
+      return hw::return_type::OK;
+    }
+
+    hw::return_type write() override
+    {
+      return hw::return_type::OK;
+    }
+  };
+
+protected:
+  void SetUp() override
+  {
+    robot_hw_ = std::make_shared<DummyRobotHardware>();
+    robot_hw_->register_joint(JOINT_NAME, "position");
+    robot_hw_->register_joint(JOINT_NAME, "position_command");
+    robot_hw_->register_actuator(ACTUATOR_NAME, "effort");
+    joint_position_ = hw::JointHandle(JOINT_NAME, "position");
+    joint_command_ = hw::JointHandle(JOINT_NAME, "position_command");
+    actuator_effort_ = hw::ActuatorHandle(ACTUATOR_NAME, "effort");
+    ASSERT_EQ(hw::return_type::OK, robot_hw_->get_joint_handle(joint_position_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw_->get_joint_handle(joint_command_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw_->get_actuator_handle(actuator_effort_));
+  }
+
+  void TearDown() override
+  {
+    std::remove(RECORDING);
+  }
+
+  /// Record cycle i with the values i, 10 * i and constant 42
+  void record_cycles(hw::Recorder & recorder, int cycles)
+  {
+    for (int i = 0; i < cycles; ++i) {
+      joint_position_.set_value(i);
+      joint_command_.set_value(10.0 * i);
+      actuator_effort_.set_value(42.0);
+      ASSERT_EQ(hw::return_type::OK, recorder.record(1000 + i));
+    }
+  }
+
+  void expect_recorded_cycles(int cycles)
+  {
+    hw::RecordingReader reader(RECORDING);
+    ASSERT_THAT(reader.get_joint_state().joint_names, ElementsAre(JOINT_NAME));
+    EXPECT_THAT(
+      reader.get_joint_state().interface_values[0].interface_names,
+      ElementsAre("position", "position_command"));
+    ASSERT_THAT(reader.get_actuator_state().joint_names, ElementsAre(ACTUATOR_NAME));
+
+    auto joint_state = reader.get_joint_state();
+    auto actuator_state = reader.get_actuator_state();
+    std::int64_t stamp = 0;
+    for (int i = 0; i < cycles; ++i) {
+      ASSERT_TRUE(reader.next(stamp, joint_state, actuator_state));
+      EXPECT_EQ(1000 + i, stamp);
+      EXPECT_THAT(joint_state.interface_values[0].values, ElementsAre(i, 10.0 * i));
+      EXPECT_THAT(actuator_state.interface_values[0].values, ElementsAre(42.0));
+    }
+    EXPECT_FALSE(reader.next(stamp, joint_state, actuator_state));
+  }
+
+  std::shared_ptr<DummyRobotHardware> robot_hw_;
+  hw::JointHandle joint_position_{"", ""};
+  hw::JointHandle joint_command_{"", ""};
+  hw::ActuatorHandle actuator_effort_{"", ""};
+};
+
+TEST_F(TestRecorder, recorded_cycles_are_read_back)
+{
+  {
+    hw::Recorder recorder(robot_hw_, RECORDING);
+    record_cycles(recorder, 100);
+    recorder.stop();
+    EXPECT_EQ(100u, recorder.get_written_cycles());
+    EXPECT_EQ(0u, recorder.get_dropped_cycles());
+  }
+  expect_recorded_cycles(100);
+}
+
+TEST_F(TestRecorder, delta_compression_is_lossless_and_smaller)
+{
+  long raw_size = 0;
+  {
+    hw::Recorder recorder(robot_hw_, RECORDING);
+    record_cycles(recorder, 1000);
+    recorder.stop();
+    raw_size = std::ifstream(RECORDING, std::ios::binary | std::ios::ate).tellg();
+  }
+
+  hw::RecorderOptions options;
+  options.delta_compression = true;
+  {
+    hw::Recorder recorder(robot_hw_, RECORDING, options);
+    record_cycles(recorder, 1000);
+  }
+  const long delta_size = std::ifstream(RECORDING, std::ios::binary | std::ios::ate).tellg();
+  EXPECT_LT(delta_size, raw_size / 2);
+  expect_recorded_cycles(1000);
+}
+
+TEST_F(TestRecorder, full_buffer_drops_cycles)
+{
+  hw::RecorderOptions options;
+  options.buffer_cycles = 4;
+  // the background thread does not write before the recorder is stopped
+  options.write_period = std::chrono::hours(1);
+  hw::Recorder recorder(robot_hw_, RECORDING, options);
+  record_cycles(recorder, 4);
+  EXPECT_EQ(hw::return_type::ERROR, recorder.record(2000));
+  recorder.stop();
+  EXPECT_EQ(4u, recorder.get_written_cycles());
+  EXPECT_EQ(1u, recorder.get_dropped_cycles());
+  EXPECT_EQ(hw::return_type::ERROR, recorder.record(2001));
+  expect_recorded_cycles(4);
+}
+
+TEST_F(TestRecorder, interfaces_registered_later_are_reported)
+{
+  hw::Recorder recorder(robot_hw_, RECORDING);
+  robot_hw_->register_joint(JOINT_NAME, "velocity");
+  EXPECT_EQ(hw::return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL, recorder.record(0));
+}
+
+TEST_F(TestRecorder, invalid_recordings_are_rejected)
+{
+  EXPECT_THROW(hw::RecordingReader("nonexistent_recording.bin"), std::runtime_error);
+  std::ofstream(RECORDING) << "not a recording";
+  EXPECT_THROW(hw::RecordingReader reader(RECORDING), std::runtime_error);
+
+  hw::ReplayRobotHardware replay_hw(RECORDING);
+  EXPECT_EQ(hw::return_type::ERROR, replay_hw.init());
+}
+
+TEST_F(TestRecorder, replay_feeds_recorded_states_through_read)
+{
+  {
+    hw::Recorder recorder(robot_hw_, RECORDING);
+    record_cycles(recorder, 3);
+  }
+
+  hw::ReplayRobotHardware replay_hw(RECORDING);
+  ASSERT_EQ(hw::return_type::OK, replay_hw.init());
+  EXPECT_THAT(replay_hw.get_registered_joint_names(), ElementsAre(JOINT_NAME));
+  EXPECT_THAT(replay_hw.get_registered_actuator_names(), ElementsAre(ACTUATOR_NAME));
+
+  hw::JointHandle position(JOINT_NAME, "position");
+  hw::JointHandle command(JOINT_NAME, "position_command");
+  hw::ActuatorHandle effort(ACTUATOR_NAME, "effort");
+  ASSERT_EQ(hw::return_type::OK, replay_hw.get_joint_handle(position));
+  ASSERT_EQ(hw::return_type::OK, replay_hw.get_joint_handle(command));
+  ASSERT_EQ(hw::return_type::OK, replay_hw.get_actuator_handle(effort));
+  command.set_value(-1.0);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(hw::return_type::OK, replay_hw.read());
+    EXPECT_EQ(1000 + i, replay_hw.get_stamp());
+    EXPECT_EQ(i, position.get_value());
+    EXPECT_EQ(42.0, effort.get_value());
+    // commands belong to the controllers and are only available for comparison
+    EXPECT_EQ(-1.0, command.get_value());
+    EXPECT_EQ(10.0 * i, replay_hw.get_recorded_joint_state().interface_values[0].values[1]);
+  }
+  EXPECT_EQ(hw::return_type::ERROR, replay_hw.read());
+}
+
+TEST_F(TestRecorder, replay_commands_on_request)
+{
+  {
+    hw::Recorder recorder(robot_hw_, RECORDING);
+    record_cycles(recorder, 2);
+  }
+
+  hw::ReplayRobotHardware replay_hw(RECORDING, true);
+  ASSERT_EQ(hw::return_type::OK, replay_hw.init());
+  hw::JointHandle command(JOINT_NAME, "position_command");
+  ASSERT_EQ(hw::return_type::OK, replay_hw.get_joint_handle(command));
+  ASSERT_EQ(hw::return_type::OK, replay_hw.read());
+  ASSERT_EQ(hw::return_type::OK, replay_hw.read());
+  EXPECT_EQ(10.0, command.get_value());
+}
@@ -189,3 +189,27 @@ TEST_F(TestJoints, can_get_registered_joints_of_interface)
   ASSERT_EQ(hw::return_type::OK, robot_hw_.get_joint_handles(handles3, "NoInterface"));
   ASSERT_TRUE(handles3.empty());
 }
+
+TEST_F(TestJoints, can_copy_joint_values_into_preallocated_message)
+{
+  EXPECT_EQ(hw::return_type::OK, robot_hw_.register_joint(JOINT_NAME, FOO_INTERFACE, 1.0));
+  EXPECT_EQ(hw::return_type::OK, robot_hw_.register_joint(JOINT2_NAME, BAR_INTERFACE, 2.0));
+
+  auto joint_state = robot_hw_.get_registered_joint_state();
+  ASSERT_THAT(joint_state.joint_names, ElementsAre(JOINT_NAME, JOINT2_NAME));
+  ASSERT_THAT(joint_state.interface_values, SizeIs(2));
+
+  hw::JointHandle handle{JOINT2_NAME, BAR_INTERFACE};
+  EXPECT_EQ(hw::return_type::OK, robot_hw_.get_joint_handle(handle));
+  handle.set_value(3.0);
+  const auto * values_data = joint_state.interface_values[1].values.data();
+  EXPECT_EQ(hw::return_type::OK, robot_hw_.copy_joint_values(joint_state));
+  EXPECT_THAT(joint_state.interface_values[0].values, ElementsAre(1.0));
+  EXPECT_THAT(joint_state.interface_values[1].values, ElementsAre(3.0));
+  EXPECT_EQ(values_data, joint_state.interface_values[1].values.data()) << "no reallocation";
+
+  // the layout changes when registering new interfaces
+  EXPECT_EQ(hw::return_type::OK, robot_hw_.register_joint(JOINT_NAME, BAR_INTERFACE));
+  EXPECT_EQ(
+    hw::return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL, robot_hw_.copy_joint_values(joint_state));
+}
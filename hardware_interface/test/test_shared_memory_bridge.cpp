@@ -0,0 +1,175 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/shared_memory_bridge.hpp"
+
+namespace hw = hardware_interface;
+using testing::ElementsAre;
+
+namespace
+{
+constexpr auto JOINT_NAME = "joint_1";
+constexpr auto ACTUATOR_NAME = "actuator_1";
+const std::string SEGMENT_NAME = "/test_shared_memory_bridge_" + std::to_string(getpid());
+constexpr std::chrono::milliseconds TIMEOUT(1000);
+}  // namespace
+
+class TestSharedMemoryBridge : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    joint_state_.joint_names = {JOINT_NAME};
+    joint_state_.interface_values.resize(1);
+    joint_state_.interface_values[0].interface_names = {"position", "position_command"};
+    joint_state_.interface_values[0].values = {1.0, 2.0};
+    actuator_state_.joint_names = {ACTUATOR_NAME};
+    actuator_state_.interface_values.resize(1);
+    actuator_state_.interface_values[0].interface_names = {"effort", "effort_command"};
+    actuator_state_.interface_values[0].values = {3.0, 4.0};
+    driver_ = std::make_unique<hw::SharedMemoryDriver>(
+      SEGMENT_NAME, joint_state_, actuator_state_);
+  }
+
+  void take_handles(hw::SharedMemoryRobotHardware & robot_hw)
+  {
+    ASSERT_EQ(hw::return_type::OK, robot_hw.get_joint_handle(joint_position_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw.get_joint_handle(joint_command_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw.get_actuator_handle(actuator_effort_));
+    ASSERT_EQ(hw::return_type::OK, robot_hw.get_actuator_handle(actuator_command_));
+  }
+
+  control_msgs::msg::DynamicJointState joint_state_;
+  control_msgs::msg::DynamicJointState actuator_state_;
+  std::unique_ptr<hw::SharedMemoryDriver> driver_;
+  hw::JointHandle joint_position_{JOINT_NAME, "position"};
+  hw::JointHandle joint_command_{JOINT_NAME, "position_command"};
+  hw::ActuatorHandle actuator_effort_{ACTUATOR_NAME, "effort"};
+  hw::ActuatorHandle actuator_command_{ACTUATOR_NAME, "effort_command"};
+};
+
+TEST_F(TestSharedMemoryBridge, layout_of_the_driver_is_registered)
+{
+  EXPECT_THAT(
+    driver_->get_state_names(),
+    ElementsAre("joint_1/position", "actuator_1/effort"));
+  EXPECT_THAT(
+    driver_->get_command_names(),
+    ElementsAre("joint_1/position_command", "actuator_1/effort_command"));
+
+  hw::SharedMemoryRobotHardware robot_hw(SEGMENT_NAME);
+  ASSERT_EQ(hw::return_type::OK, robot_hw.init());
+  EXPECT_THAT(robot_hw.get_registered_joint_names(), ElementsAre(JOINT_NAME));
+  EXPECT_THAT(robot_hw.get_registered_actuator_names(), ElementsAre(ACTUATOR_NAME));
+  take_handles(robot_hw);
+  EXPECT_EQ(1.0, joint_position_.get_value());
+  EXPECT_EQ(2.0, joint_command_.get_value());
+  EXPECT_EQ(3.0, actuator_effort_.get_value());
+  EXPECT_EQ(4.0, actuator_command_.get_value());
+}
+
+TEST_F(TestSharedMemoryBridge, states_and_commands_are_exchanged)
+{
+  hw::SharedMemoryRobotHardware robot_hw(SEGMENT_NAME);
+  ASSERT_EQ(hw::return_type::OK, robot_hw.init());
+  take_handles(robot_hw);
+
+  ASSERT_EQ(hw::return_type::OK, driver_->write_states({10.0, 30.0}));
+  ASSERT_EQ(hw::return_type::OK, robot_hw.read());
+  EXPECT_EQ(10.0, joint_position_.get_value());
+  EXPECT_EQ(30.0, actuator_effort_.get_value());
+  // the states do not overwrite the commands of the controllers
+  EXPECT_EQ(2.0, joint_command_.get_value());
+
+  joint_command_.set_value(20.0);
+  actuator_command_.set_value(40.0);
+  ASSERT_EQ(hw::return_type::OK, robot_hw.write());
+  std::vector<double> commands(2);
+  ASSERT_EQ(hw::return_type::OK, driver_->read_commands(commands, TIMEOUT));
+  EXPECT_THAT(commands, ElementsAre(20.0, 40.0));
+}
+
+TEST_F(TestSharedMemoryBridge, waiting_for_new_values_times_out)
+{
+  hw::SharedMemoryRobotHardware robot_hw(SEGMENT_NAME, std::chrono::milliseconds(1));
+  ASSERT_EQ(hw::return_type::OK, robot_hw.init());
+  EXPECT_EQ(hw::return_type::ERROR, robot_hw.read());
+  ASSERT_EQ(hw::return_type::OK, driver_->write_states({10.0, 30.0}));
+  EXPECT_EQ(hw::return_type::OK, robot_hw.read());
+
+  std::vector<double> commands(2);
+  EXPECT_EQ(
+    hw::return_type::ERROR, driver_->read_commands(commands, std::chrono::milliseconds(1)));
+  EXPECT_EQ(hw::return_type::OK, driver_->read_commands(commands));
+}
+
+TEST_F(TestSharedMemoryBridge, invalid_values_are_rejected)
+{
+  EXPECT_EQ(hw::return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL, driver_->write_states({1.0}));
+  std::vector<double> commands(3);
+  EXPECT_EQ(hw::return_type::INTERFACE_VALUE_SIZE_NOT_EQUAL, driver_->read_commands(commands));
+
+  hw::SharedMemoryRobotHardware robot_hw("/test_shared_memory_bridge_nonexistent");
+  EXPECT_EQ(hw::return_type::ERROR, robot_hw.init());
+}
+
+TEST_F(TestSharedMemoryBridge, values_are_exchanged_between_processes)
+{
+  constexpr int cycles = 1000;
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    // the controller manager side, echoing every state doubled as command
+    hw::SharedMemoryRobotHardware robot_hw(SEGMENT_NAME, TIMEOUT);
+    if (robot_hw.init() != hw::return_type::OK) {
+      _exit(1);
+    }
+    hw::JointHandle position(JOINT_NAME, "position");
+    hw::JointHandle command(JOINT_NAME, "position_command");
+    robot_hw.get_joint_handle(position);
+    robot_hw.get_joint_handle(command);
+    // tells the driver that the initial states are read
+    robot_hw.write();
+    for (int i = 0; i < cycles; ++i) {
+      if (robot_hw.read() != hw::return_type::OK) {
+        _exit(2);
+      }
+      command.set_value(2.0 * position.get_value());
+      robot_hw.write();
+    }
+    _exit(0);
+  }
+
+  std::vector<double> commands(2);
+  // the child has read the initial states once it wrote its commands
+  ASSERT_EQ(hw::return_type::OK, driver_->read_commands(commands, TIMEOUT));
+  for (int i = 0; i < cycles; ++i) {
+    ASSERT_EQ(hw::return_type::OK, driver_->write_states({1.0 * i, 0.0}));
+    ASSERT_EQ(hw::return_type::OK, driver_->read_commands(commands, TIMEOUT));
+    ASSERT_EQ(2.0 * i, commands[0]);
+  }
+  int status = 0;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
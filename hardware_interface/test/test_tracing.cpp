@@ -0,0 +1,129 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "hardware_interface/tracing.hpp"
+
+namespace tracing = hardware_interface::tracing;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+namespace
+{
+std::string drain(tracing::DrainResult * result = nullptr)
+{
+  std::ostringstream out;
+  const auto drain_result = tracing::write_chrome_trace(out);
+  if (result != nullptr) {
+    *result = drain_result;
+  }
+  return out.str();
+}
+}  // namespace
+
+class TestTracing : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    drain();
+    tracing::set_enabled(true);
+  }
+
+  void TearDown() override
+  {
+    tracing::set_enabled(false);
+  }
+};
+
+TEST_F(TestTracing, scopes_are_recorded_only_when_enabled)
+{
+  tracing::register_thread("test thread");
+  {
+    tracing::Scope scope("enabled_scope", "test");
+  }
+  tracing::set_enabled(false);
+  {
+    tracing::Scope scope("disabled_scope", "test");
+  }
+
+  tracing::DrainResult result;
+  const auto trace = drain(&result);
+  EXPECT_EQ(1u, result.events);
+  EXPECT_EQ(0u, result.dropped_events);
+  EXPECT_THAT(trace, HasSubstr("\"traceEvents\":["));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"enabled_scope\",\"cat\":\"test\",\"ph\":\"X\""));
+  EXPECT_THAT(trace, HasSubstr("\"args\":{\"name\":\"test thread\"}"));
+  EXPECT_THAT(trace, Not(HasSubstr("disabled_scope")));
+
+  // drained events are not written again
+  drain(&result);
+  EXPECT_EQ(0u, result.events);
+}
+
+TEST_F(TestTracing, names_are_truncated_and_escaped)
+{
+  tracing::record(std::string(100, 'a').c_str(), "test", 1000, 3500);
+  tracing::record("a \"quoted\" \\name", "test", 0, 0);
+
+  const auto trace = drain();
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"" + std::string(tracing::kMaxNameLength, 'a') + "\""));
+  EXPECT_THAT(trace, HasSubstr("\"ts\":1.000,\"dur\":2.500"));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"a \\\"quoted\\\" \\\\name\""));
+}
+
+TEST_F(TestTracing, full_buffer_drops_events)
+{
+  for (std::uint32_t i = 0; i < tracing::kBufferCapacity + 10; ++i) {
+    tracing::record("event", "test", i, i + 1);
+  }
+
+  tracing::DrainResult result;
+  drain(&result);
+  EXPECT_EQ(tracing::kBufferCapacity, result.events);
+  EXPECT_EQ(10u, result.dropped_events);
+
+  tracing::record("event", "test", 0, 1);
+  drain(&result);
+  EXPECT_EQ(1u, result.events);
+  EXPECT_EQ(0u, result.dropped_events);
+}
+
+TEST_F(TestTracing, threads_are_traced_separately)
+{
+  std::thread thread([]() {
+      tracing::register_thread("other thread");
+      tracing::Scope scope("other_thread_scope", "test");
+    });
+  thread.join();
+  {
+    tracing::Scope scope("main_thread_scope", "test");
+  }
+
+  tracing::DrainResult result;
+  auto trace = drain(&result);
+  EXPECT_EQ(2u, result.events);
+  EXPECT_THAT(trace, HasSubstr("other_thread_scope"));
+  EXPECT_THAT(trace, HasSubstr("main_thread_scope"));
+  EXPECT_THAT(trace, HasSubstr("other thread"));
+
+  // the buffer of the exited thread is released once drained
+  trace = drain();
+  EXPECT_THAT(trace, Not(HasSubstr("other thread")));
+}
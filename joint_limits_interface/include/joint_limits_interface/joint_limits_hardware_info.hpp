@@ -0,0 +1,77 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_LIMITS_INTERFACE__JOINT_LIMITS_HARDWARE_INFO_HPP_
+#define JOINT_LIMITS_INTERFACE__JOINT_LIMITS_HARDWARE_INFO_HPP_
+
+#include <hardware_interface/component_info.hpp>
+#include <joint_limits_interface/joint_limits.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace joint_limits_interface
+{
+
+/**
+ * \brief Populate a JointLimits instance from the command interface limits of a ros2_control joint.
+ * \param[in] joint Joint information as parsed from the \e ros2_control URDF tag.
+ * \param[out] limits Where the limits get written into. Only the limits of "position", "velocity",
+ * "acceleration" and "effort" command interfaces having a finite min or max value are overwritten,
+ * other values in \e limits remain unchanged.
+ * \return True if at least one limit was found, false otherwise.
+ */
+inline bool getJointLimits(const hardware_interface::ComponentInfo & joint, JointLimits & limits)
+{
+  bool found = false;
+  for (const auto & interface : joint.command_interfaces) {
+    if (!std::isfinite(interface.min_value) && !std::isfinite(interface.max_value)) {
+      continue;
+    }
+    // velocity, acceleration and effort limits are symmetric
+    double max_abs_value = 0.0;
+    if (std::isfinite(interface.min_value)) {
+      max_abs_value = std::abs(interface.min_value);
+    }
+    if (std::isfinite(interface.max_value)) {
+      max_abs_value = std::max(max_abs_value, std::abs(interface.max_value));
+    }
+
+    if (interface.name == "position") {
+      if (!std::isfinite(interface.min_value) || !std::isfinite(interface.max_value)) {
+        continue;
+      }
+      limits.has_position_limits = true;
+      limits.min_position = interface.min_value;
+      limits.max_position = interface.max_value;
+    } else if (interface.name == "velocity") {
+      limits.has_velocity_limits = true;
+      limits.max_velocity = max_abs_value;
+    } else if (interface.name == "acceleration") {
+      limits.has_acceleration_limits = true;
+      limits.max_acceleration = max_abs_value;
+    } else if (interface.name == "effort") {
+      limits.has_effort_limits = true;
+      limits.max_effort = max_abs_value;
+    } else {
+      continue;
+    }
+    found = true;
+  }
+  return found;
+}
+
+}  // namespace joint_limits_interface
+
+#endif  // JOINT_LIMITS_INTERFACE__JOINT_LIMITS_HARDWARE_INFO_HPP_
@@ -0,0 +1,66 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <joint_limits_interface/joint_limits_hardware_info.hpp>
+
+#include <limits>
+
+namespace
+{
+hardware_interface::InterfaceInfo make_interface(
+  const std::string & name, double min_value, double max_value)
+{
+  hardware_interface::InterfaceInfo interface;
+  interface.name = name;
+  interface.min_value = min_value;
+  interface.max_value = max_value;
+  return interface;
+}
+}  // namespace
+
+TEST(JointLimitsHardwareInfoTest, GetJointLimits)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // No limited command interfaces
+  {
+    hardware_interface::ComponentInfo joint;
+    joint.command_interfaces.push_back(make_interface("position", -inf, inf));
+    joint_limits_interface::JointLimits limits;
+    EXPECT_FALSE(joint_limits_interface::getJointLimits(joint, limits));
+    EXPECT_FALSE(limits.has_position_limits);
+  }
+
+  // Limited command interfaces
+  {
+    hardware_interface::ComponentInfo joint;
+    joint.command_interfaces.push_back(make_interface("position", -1.0, 2.0));
+    joint.command_interfaces.push_back(make_interface("velocity", -3.0, 2.5));
+    joint.command_interfaces.push_back(make_interface("effort", -inf, 8.0));
+    joint.command_interfaces.push_back(make_interface("custom", -1.0, 1.0));
+    joint_limits_interface::JointLimits limits;
+    EXPECT_TRUE(joint_limits_interface::getJointLimits(joint, limits));
+
+    EXPECT_TRUE(limits.has_position_limits);
+    EXPECT_DOUBLE_EQ(-1.0, limits.min_position);
+    EXPECT_DOUBLE_EQ(2.0, limits.max_position);
+    EXPECT_TRUE(limits.has_velocity_limits);
+    EXPECT_DOUBLE_EQ(3.0, limits.max_velocity);
+    EXPECT_FALSE(limits.has_acceleration_limits);
+    EXPECT_TRUE(limits.has_effort_limits);
+    EXPECT_DOUBLE_EQ(8.0, limits.max_effort);
+  }
+}
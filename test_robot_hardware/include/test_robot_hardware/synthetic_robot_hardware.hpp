@@ -0,0 +1,105 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TEST_ROBOT_HARDWARE__SYNTHETIC_ROBOT_HARDWARE_HPP_
+#define TEST_ROBOT_HARDWARE__SYNTHETIC_ROBOT_HARDWARE_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/joint_handle.hpp"
+#include "hardware_interface/robot_hardware.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+
+#include "test_robot_hardware/visibility_control.h"
+
+namespace test_robot_hardware
+{
+
+/// Configuration of a SyntheticRobotHardware
+struct SyntheticRobotHardwareOptions
+{
+  /// Joints registered as "joint0", "joint1", ...
+  std::size_t joints = 100;
+  /// Quantities per joint, named "position", "velocity", "effort", "interface3", ... Each is
+  /// registered as a state interface and a command interface with the "_command" suffix
+  std::size_t interfaces = 3;
+  /// Simulated I/O time of every read() and write()
+  std::chrono::nanoseconds latency{0};
+  /// Maximum random time added to the latency, uniformly distributed
+  std::chrono::nanoseconds jitter{0};
+  /// Time constant of the first order response of every state to its command, in seconds
+  double time_constant = 0.05;
+  /// Time simulated by every read(), in seconds
+  double period = 0.001;
+  /// Seed of the jitter, so that runs are reproducible
+  std::uint32_t seed = 42;
+};
+
+/// Robot hardware of configurable size for load testing, without any real I/O.
+/**
+ * write() latches the command interfaces, every read() moves each state towards its latched
+ * command with first order dynamics. Both optionally wait for a simulated I/O latency. Once
+ * initialized, read() and write() neither allocate nor look up handles by name. They keep handles
+ * into the registered values, so no further joints or interfaces must be registered after init().
+ */
+class SyntheticRobotHardware : public hardware_interface::RobotHardware
+{
+public:
+  TEST_ROBOT_HARDWARE_PUBLIC
+  explicit SyntheticRobotHardware(
+    const SyntheticRobotHardwareOptions & options = SyntheticRobotHardwareOptions());
+
+  TEST_ROBOT_HARDWARE_PUBLIC
+  hardware_interface::return_type
+  init() override;
+
+  TEST_ROBOT_HARDWARE_PUBLIC
+  hardware_interface::return_type
+  read() override;
+
+  TEST_ROBOT_HARDWARE_PUBLIC
+  hardware_interface::return_type
+  write() override;
+
+  TEST_ROBOT_HARDWARE_PUBLIC
+  const SyntheticRobotHardwareOptions & get_options() const;
+
+  /// Name of the i-th interface of every joint
+  TEST_ROBOT_HARDWARE_PUBLIC
+  static std::string interface_name(std::size_t index);
+
+private:
+  void simulate_io();
+
+  SyntheticRobotHardwareOptions options_;
+  /// Fraction of the remaining distance to the command covered by every read()
+  double response_ = 1.0;
+
+  /// State and command handles of every simulated quantity, taken once all are registered
+  std::vector<hardware_interface::JointHandle> state_handles_;
+  std::vector<hardware_interface::JointHandle> command_handles_;
+  /// Commands sent by the last write()
+  std::vector<double> latched_commands_;
+
+  std::minstd_rand jitter_generator_;
+  std::uniform_int_distribution<std::int64_t> jitter_distribution_;
+};
+
+}  // namespace test_robot_hardware
+
+#endif  // TEST_ROBOT_HARDWARE__SYNTHETIC_ROBOT_HARDWARE_HPP_
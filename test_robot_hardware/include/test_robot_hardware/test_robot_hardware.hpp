@@ -15,6 +15,7 @@
 #ifndef TEST_ROBOT_HARDWARE__TEST_ROBOT_HARDWARE_HPP_
 #define TEST_ROBOT_HARDWARE__TEST_ROBOT_HARDWARE_HPP_
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -44,6 +45,18 @@ public:
   hardware_interface::return_type
   write();
 
+  TEST_ROBOT_HARDWARE_PUBLIC
+  hardware_interface::return_type
+  prepare_command_mode_switch(
+    const std::vector<hardware_interface::InterfaceResources> & start_interfaces,
+    const std::vector<hardware_interface::InterfaceResources> & stop_interfaces);
+
+  TEST_ROBOT_HARDWARE_PUBLIC
+  hardware_interface::return_type
+  perform_command_mode_switch(
+    const std::vector<hardware_interface::InterfaceResources> & start_interfaces,
+    const std::vector<hardware_interface::InterfaceResources> & stop_interfaces);
+
   std::string read_op_handle_name1 = "read1";
   std::string read_op_handle_name2 = "read2";
   std::string write_op_handle_name1 = "write1";
@@ -56,6 +69,14 @@ public:
   std::vector<double> vel_dflt_values = {1.2, 2.2, 3.2};
   std::vector<double> eff_dflt_values = {1.3, 2.3, 3.3};
 
+  // command mode switches requested by the controller manager, counted from any thread
+  bool fail_command_mode_switch = false;
+  bool fail_perform_command_mode_switch = false;
+  std::atomic<size_t> prepared_command_mode_switches{0};
+  std::atomic<size_t> performed_command_mode_switches{0};
+  std::vector<hardware_interface::InterfaceResources> start_interfaces;
+  std::vector<hardware_interface::InterfaceResources> stop_interfaces;
+
   bool read1 = false;
   bool read2 = false;
   bool write1 = false;
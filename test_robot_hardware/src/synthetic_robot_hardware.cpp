@@ -0,0 +1,121 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test_robot_hardware/synthetic_robot_hardware.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace test_robot_hardware
+{
+
+SyntheticRobotHardware::SyntheticRobotHardware(const SyntheticRobotHardwareOptions & options)
+: options_(options),
+  jitter_generator_(options.seed),
+  // the bounds of the distribution must be ordered, a negative jitter is rejected by init()
+  jitter_distribution_(0, std::max<std::int64_t>(options.jitter.count(), 0))
+{
+}
+
+hardware_interface::return_type
+SyntheticRobotHardware::init()
+{
+  if (options_.period <= 0.0 || options_.time_constant < 0.0 || options_.jitter.count() < 0) {
+    return hardware_interface::return_type::ERROR;
+  }
+  response_ = options_.time_constant > 0.0 ?
+    1.0 - std::exp(-options_.period / options_.time_constant) : 1.0;
+
+  std::vector<std::string> joint_names;
+  for (std::size_t joint = 0; joint < options_.joints; ++joint) {
+    joint_names.push_back("joint" + std::to_string(joint));
+    for (std::size_t index = 0; index < options_.interfaces; ++index) {
+      if (register_joint(joint_names.back(), interface_name(index)) !=
+        hardware_interface::return_type::OK ||
+        register_joint(joint_names.back(), interface_name(index) + "_command") !=
+        hardware_interface::return_type::OK)
+      {
+        return hardware_interface::return_type::ERROR;
+      }
+    }
+  }
+
+  // the registered values do not move anymore once all are registered
+  state_handles_.clear();
+  command_handles_.clear();
+  for (const auto & joint_name : joint_names) {
+    for (std::size_t index = 0; index < options_.interfaces; ++index) {
+      state_handles_.emplace_back(joint_name, interface_name(index));
+      command_handles_.emplace_back(joint_name, interface_name(index) + "_command");
+      if (get_joint_handle(state_handles_.back()) != hardware_interface::return_type::OK ||
+        get_joint_handle(command_handles_.back()) != hardware_interface::return_type::OK)
+      {
+        return hardware_interface::return_type::ERROR;
+      }
+    }
+  }
+  latched_commands_.assign(state_handles_.size(), 0.0);
+  return hardware_interface::return_type::OK;
+}
+
+hardware_interface::return_type
+SyntheticRobotHardware::read()
+{
+  simulate_io();
+  for (std::size_t i = 0; i < state_handles_.size(); ++i) {
+    const auto state = state_handles_[i].get_value();
+    state_handles_[i].set_value(state + response_ * (latched_commands_[i] - state));
+  }
+  return hardware_interface::return_type::OK;
+}
+
+hardware_interface::return_type
+SyntheticRobotHardware::write()
+{
+  simulate_io();
+  for (std::size_t i = 0; i < command_handles_.size(); ++i) {
+    latched_commands_[i] = command_handles_[i].get_value();
+  }
+  return hardware_interface::return_type::OK;
+}
+
+const SyntheticRobotHardwareOptions & SyntheticRobotHardware::get_options() const
+{
+  return options_;
+}
+
+std::string SyntheticRobotHardware::interface_name(std::size_t index)
+{
+  static const std::vector<std::string> kInterfaceNames = {"position", "velocity", "effort"};
+  if (index < kInterfaceNames.size()) {
+    return kInterfaceNames[index];
+  }
+  return "interface" + std::to_string(index);
+}
+
+void SyntheticRobotHardware::simulate_io()
+{
+  auto duration = options_.latency;
+  if (options_.jitter.count() > 0) {
+    duration += std::chrono::nanoseconds(jitter_distribution_(jitter_generator_));
+  }
+  if (duration.count() > 0) {
+    std::this_thread::sleep_for(duration);
+  }
+}
+
+}  // namespace test_robot_hardware
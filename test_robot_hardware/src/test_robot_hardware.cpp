@@ -121,4 +121,30 @@ TestRobotHardware::write()
   return hardware_interface::return_type::OK;
 }
 
+hardware_interface::return_type
+TestRobotHardware::prepare_command_mode_switch(
+  const std::vector<hardware_interface::InterfaceResources> & start_interfaces,
+  const std::vector<hardware_interface::InterfaceResources> & stop_interfaces)
+{
+  ++prepared_command_mode_switches;
+  this->start_interfaces = start_interfaces;
+  this->stop_interfaces = stop_interfaces;
+  if (fail_command_mode_switch) {
+    return hardware_interface::return_type::ERROR;
+  }
+  return hardware_interface::return_type::OK;
+}
+
+hardware_interface::return_type
+TestRobotHardware::perform_command_mode_switch(
+  const std::vector<hardware_interface::InterfaceResources> &,
+  const std::vector<hardware_interface::InterfaceResources> &)
+{
+  ++performed_command_mode_switches;
+  if (fail_perform_command_mode_switch) {
+    return hardware_interface::return_type::ERROR;
+  }
+  return hardware_interface::return_type::OK;
+}
+
 }  // namespace test_robot_hardware
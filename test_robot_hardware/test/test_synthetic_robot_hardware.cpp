@@ -0,0 +1,105 @@
+// Copyright 2020 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "hardware_interface/joint_handle.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+
+#include "test_robot_hardware/synthetic_robot_hardware.hpp"
+
+using hw_ret = hardware_interface::return_type;
+using test_robot_hardware::SyntheticRobotHardware;
+using test_robot_hardware::SyntheticRobotHardwareOptions;
+
+TEST(TestSyntheticRobotHardware, registers_configured_joints_and_interfaces) {
+  SyntheticRobotHardwareOptions options;
+  options.joints = 1000;
+  options.interfaces = 4;
+  SyntheticRobotHardware robot(options);
+  ASSERT_EQ(hw_ret::OK, robot.init());
+
+  ASSERT_EQ(1000u, robot.get_registered_joint_names().size());
+  EXPECT_EQ("joint999", robot.get_registered_joint_names().back());
+  EXPECT_EQ(
+    (std::vector<std::string>{
+    "position", "position_command", "velocity", "velocity_command", "effort", "effort_command",
+    "interface3", "interface3_command"}),
+    robot.get_registered_joint_interface_names("joint0"));
+}
+
+TEST(TestSyntheticRobotHardware, invalid_options_are_rejected) {
+  SyntheticRobotHardwareOptions options;
+  options.period = 0.0;
+  SyntheticRobotHardware robot(options);
+  EXPECT_EQ(hw_ret::ERROR, robot.init());
+
+  options.period = 0.001;
+  options.jitter = std::chrono::nanoseconds(-1);
+  SyntheticRobotHardware jittery_robot(options);
+  EXPECT_EQ(hw_ret::ERROR, jittery_robot.init());
+}
+
+TEST(TestSyntheticRobotHardware, states_follow_commands_with_first_order_dynamics) {
+  SyntheticRobotHardwareOptions options;
+  options.joints = 2;
+  options.time_constant = 0.01;
+  options.period = 0.001;
+  SyntheticRobotHardware robot(options);
+  ASSERT_EQ(hw_ret::OK, robot.init());
+
+  hardware_interface::JointHandle position("joint1", "position");
+  hardware_interface::JointHandle position_command("joint1", "position_command");
+  ASSERT_EQ(hw_ret::OK, robot.get_joint_handle(position));
+  ASSERT_EQ(hw_ret::OK, robot.get_joint_handle(position_command));
+
+  // the command only takes effect once written
+  position_command.set_value(1.0);
+  ASSERT_EQ(hw_ret::OK, robot.read());
+  EXPECT_EQ(0.0, position.get_value());
+
+  ASSERT_EQ(hw_ret::OK, robot.write());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(hw_ret::OK, robot.read());
+  }
+  // one time constant
+  EXPECT_NEAR(1.0 - std::exp(-1.0), position.get_value(), 1e-9);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(hw_ret::OK, robot.read());
+  }
+  EXPECT_NEAR(1.0, position.get_value(), 1e-9);
+
+  hardware_interface::JointHandle other_position("joint0", "position");
+  ASSERT_EQ(hw_ret::OK, robot.get_joint_handle(other_position));
+  EXPECT_EQ(0.0, other_position.get_value());
+}
+
+TEST(TestSyntheticRobotHardware, io_takes_the_simulated_latency) {
+  SyntheticRobotHardwareOptions options;
+  options.joints = 1;
+  options.latency = std::chrono::milliseconds(2);
+  options.jitter = std::chrono::milliseconds(1);
+  SyntheticRobotHardware robot(options);
+  ASSERT_EQ(hw_ret::OK, robot.init());
+
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(hw_ret::OK, robot.read());
+  ASSERT_EQ(hw_ret::OK, robot.write());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(4));
+}
@@ -0,0 +1,77 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * \file
+ * \brief Stores parsed <tt>\<transmission\></tt> elements in the binary robot description cache.
+ */
+
+#ifndef TRANSMISSION_INTERFACE__TRANSMISSION_CACHE_HPP_
+#define TRANSMISSION_INTERFACE__TRANSMISSION_CACHE_HPP_
+
+#include <hardware_interface/hardware_info_cache.hpp>
+#include <transmission_interface/transmission_info.hpp>
+#include <transmission_interface/visibility_control.h>
+
+#include <string>
+#include <vector>
+
+namespace transmission_interface
+{
+
+/// Tag of the cache file section storing parsed TransmissionInfo.
+constexpr const auto kTransmissionInfoCacheSection = "TRNS";
+
+/**
+ * \brief Serialize parsed transmissions into a cache section payload.
+ * \param transmissions transmissions as returned by parse_transmissions_from_urdf
+ * \return binary payload to be added to a hardware_interface::cache::CacheFileWriter
+ */
+TRANSMISSION_INTERFACE_PUBLIC
+std::string serialize_transmission_info(const std::vector<TransmissionInfo> & transmissions);
+
+/**
+ * \brief Deserialize transmissions from a cache section payload.
+ * \param reader reader over a section written by serialize_transmission_info
+ * \return parsed transmission information
+ * \throws std::runtime_error if the payload is corrupted
+ */
+TRANSMISSION_INTERFACE_PUBLIC
+std::vector<TransmissionInfo> deserialize_transmission_info(
+  hardware_interface::cache::Reader & reader);
+
+/**
+ * \brief Get transmission information from a cache file, falling back to parsing the URDF
+ * if the cache is missing, corrupted or was generated for another URDF.
+ * \param urdf A string containing the URDF xml
+ * \param cache_path cache file generated for this URDF
+ * \return parsed transmission information
+ * \throws std::runtime_error if the cache is unusable and the xml is malformed or empty
+ */
+TRANSMISSION_INTERFACE_PUBLIC
+std::vector<TransmissionInfo> parse_transmissions_from_urdf(
+  const std::string & urdf, const std::string & cache_path);
+
+/**
+ * \brief Parse hardware and transmission information from a URDF and write them to a cache file.
+ * \param urdf A string containing the URDF xml
+ * \param cache_path file to be (over)written
+ * \throws std::runtime_error on malformed xml or if the file cannot be written
+ */
+TRANSMISSION_INTERFACE_PUBLIC
+void write_robot_description_cache(const std::string & urdf, const std::string & cache_path);
+
+}  // namespace transmission_interface
+
+#endif  // TRANSMISSION_INTERFACE__TRANSMISSION_CACHE_HPP_
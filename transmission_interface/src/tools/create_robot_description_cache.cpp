@@ -0,0 +1,51 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * \file
+ * \brief Precompiles the ros2_control and transmission tags of a URDF into a binary cache,
+ * which can be loaded at startup instead of parsing the XML.
+ */
+
+#include <transmission_interface/transmission_cache.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char ** argv)
+{
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <urdf_file> <cache_file>" << std::endl;
+    return 1;
+  }
+
+  std::ifstream urdf_file(argv[1]);
+  if (!urdf_file) {
+    std::cerr << "cannot open URDF file '" << argv[1] << "'" << std::endl;
+    return 1;
+  }
+  const std::string urdf(
+    (std::istreambuf_iterator<char>(urdf_file)), std::istreambuf_iterator<char>());
+
+  try {
+    transmission_interface::write_robot_description_cache(urdf, argv[2]);
+  } catch (const std::runtime_error & ex) {
+    std::cerr << "cannot create robot description cache: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <transmission_interface/transmission_cache.hpp>
+
+#include <hardware_interface/component_parser.hpp>
+#include <transmission_interface/transmission_parser.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Smallest serialized sizes, used to reject element counts a corrupted cache cannot hold
+constexpr std::size_t kMinStringSize = sizeof(std::uint32_t);
+constexpr std::size_t kMinTransmissionSize = 2 * kMinStringSize + 2 * sizeof(std::uint32_t);
+constexpr std::size_t kMinJointSize = 2 * kMinStringSize + sizeof(std::uint32_t);
+constexpr std::size_t kMinActuatorSize = kMinStringSize + sizeof(std::uint32_t) + sizeof(double);
+
+void serialize_strings(
+  hardware_interface::cache::Writer & writer, const std::vector<std::string> & strings)
+{
+  writer.write_u32(static_cast<std::uint32_t>(strings.size()));
+  for (const auto & string : strings) {
+    writer.write_string(string);
+  }
+}
+
+std::vector<std::string> deserialize_strings(hardware_interface::cache::Reader & reader)
+{
+  std::vector<std::string> strings(reader.read_count(kMinStringSize));
+  for (auto & string : strings) {
+    string = reader.read_string();
+  }
+  return strings;
+}
+}  // namespace
+
+namespace transmission_interface
+{
+
+std::string serialize_transmission_info(const std::vector<TransmissionInfo> & transmissions)
+{
+  hardware_interface::cache::Writer writer;
+  writer.write_u32(static_cast<std::uint32_t>(transmissions.size()));
+  for (const auto & transmission : transmissions) {
+    writer.write_string(transmission.name);
+    writer.write_string(transmission.type);
+    writer.write_u32(static_cast<std::uint32_t>(transmission.joints.size()));
+    for (const auto & joint : transmission.joints) {
+      writer.write_string(joint.name);
+      serialize_strings(writer, joint.interfaces);
+      writer.write_string(joint.role);
+    }
+    writer.write_u32(static_cast<std::uint32_t>(transmission.actuators.size()));
+    for (const auto & actuator : transmission.actuators) {
+      writer.write_string(actuator.name);
+      serialize_strings(writer, actuator.interfaces);
+      writer.write_double(actuator.mechanical_reduction);
+    }
+  }
+  return writer.get_buffer();
+}
+
+std::vector<TransmissionInfo> deserialize_transmission_info(
+  hardware_interface::cache::Reader & reader)
+{
+  std::vector<TransmissionInfo> transmissions(reader.read_count(kMinTransmissionSize));
+  for (auto & transmission : transmissions) {
+    transmission.name = reader.read_string();
+    transmission.type = reader.read_string();
+    transmission.joints.resize(reader.read_count(kMinJointSize));
+    for (auto & joint : transmission.joints) {
+      joint.name = reader.read_string();
+      joint.interfaces = deserialize_strings(reader);
+      joint.role = reader.read_string();
+    }
+    transmission.actuators.resize(reader.read_count(kMinActuatorSize));
+    for (auto & actuator : transmission.actuators) {
+      actuator.name = reader.read_string();
+      actuator.interfaces = deserialize_strings(reader);
+      actuator.mechanical_reduction = reader.read_double();
+    }
+  }
+  if (!reader.at_end()) {
+    throw std::runtime_error("transmission cache is corrupted, trailing data");
+  }
+  return transmissions;
+}
+
+std::vector<TransmissionInfo> parse_transmissions_from_urdf(
+  const std::string & urdf, const std::string & cache_path)
+{
+  try {
+    hardware_interface::cache::CacheFile cache_file(cache_path);
+    if (cache_file.is_valid_for(urdf) && cache_file.has_section(kTransmissionInfoCacheSection)) {
+      auto reader = cache_file.get_section(kTransmissionInfoCacheSection);
+      return deserialize_transmission_info(reader);
+    }
+  } catch (const std::runtime_error &) {
+    // unusable cache, parse the URDF instead
+  }
+  return parse_transmissions_from_urdf(urdf);
+}
+
+void write_robot_description_cache(const std::string & urdf, const std::string & cache_path)
+{
+  hardware_interface::cache::CacheFileWriter writer(hardware_interface::cache::hash_urdf(urdf));
+  writer.add_section(
+    hardware_interface::kHardwareInfoCacheSection,
+    hardware_interface::serialize_hardware_info(
+      hardware_interface::parse_control_resources_from_urdf(urdf)));
+  writer.add_section(
+    kTransmissionInfoCacheSection,
+    serialize_transmission_info(parse_transmissions_from_urdf(urdf)));
+  writer.write(cache_path);
+}
+
+}  // namespace transmission_interface
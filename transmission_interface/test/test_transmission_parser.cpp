@@ -13,9 +13,11 @@
 // limitations under the License.
 
 #include <gmock/gmock.h>
+#include <cstdio>
 #include <string>
 #include <vector>
 
+#include "transmission_interface/transmission_cache.hpp"
 #include "transmission_interface/transmission_parser.hpp"
 
 using namespace ::testing;  // NOLINT
@@ -442,3 +444,31 @@ TEST_F(TestTransmissionParser, wrong_urdf_throws_error)
     transmission_interface::parse_transmissions_from_urdf(wrong_urdf_xml_),
     std::runtime_error);
 }
+
+TEST_F(TestTransmissionParser, successfully_restore_from_cache)
+{
+  const std::string cache_path = "test_transmission_parser_cache.bin";
+  hardware_interface::cache::CacheFileWriter writer(
+    hardware_interface::cache::hash_urdf(valid_urdf_xml_));
+  writer.add_section(
+    transmission_interface::kTransmissionInfoCacheSection,
+    transmission_interface::serialize_transmission_info(
+      parse_transmissions_from_urdf(valid_urdf_xml_)));
+  writer.write(cache_path);
+
+  hardware_interface::cache::CacheFile cache_file(cache_path);
+  ASSERT_TRUE(cache_file.is_valid_for(valid_urdf_xml_));
+  auto reader = cache_file.get_section(transmission_interface::kTransmissionInfoCacheSection);
+  const auto transmissions = transmission_interface::deserialize_transmission_info(reader);
+  std::remove(cache_path.c_str());
+
+  ASSERT_THAT(transmissions, SizeIs(2));
+  EXPECT_EQ("rrbot_tran2", transmissions[1].name);
+  EXPECT_EQ("transmission_interface/SimpleTransmission", transmissions[1].type);
+  ASSERT_THAT(transmissions[1].joints, SizeIs(1));
+  EXPECT_EQ("rrbot_joint2", transmissions[1].joints[0].name);
+  EXPECT_EQ("VelocityJointInterface", transmissions[1].joints[0].interfaces[0]);
+  ASSERT_THAT(transmissions[1].actuators, SizeIs(1));
+  EXPECT_EQ("rrbot_motor2", transmissions[1].actuators[0].name);
+  EXPECT_EQ(60, transmissions[1].actuators[0].mechanical_reduction);
+}